@@ -7,6 +7,7 @@
 #include <stdbool.h>
 #include <math.h>
 #include <string.h>
+#include <float.h>
 
 // If you want to define your own decimal type (i.e. float instead of
 // double) make sure to define this before including `lin.h`:
@@ -17,657 +18,7673 @@
 typedef float lin_decimal_t;
 #endif
 
+// Machine epsilon of whichever decimal type is in use
+#define LIN_EPSILON (sizeof(lin_decimal_t) == sizeof(float) \
+    ? (lin_decimal_t)FLT_EPSILON : (lin_decimal_t)DBL_EPSILON)
+
 #define LIN_LOG_ERROR(fmt, ...) \
     fprintf(stderr, "[%s:%d] ERROR: " fmt "\n", __FILE__, __LINE__, \
             ##__VA_ARGS__)
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-// VECTOR DECLARATION
+// THREADING DECLARATION
 //
 ///////////////////////////////////////////////////////////////////////////////
 
-typedef enum {
-    DEGREES,
-    RADIANS,
-} AngleType;
+// Large operations are split across threads with pthreads. Define
+// `LIN_NO_THREADS` before including `lin.h` to run everything on the calling
+// thread instead.
 
-typedef struct {
-    size_t dim;
-    lin_decimal_t *elements;
-} lin_vec_t;
+#ifndef LIN_MAX_THREADS
+#define LIN_MAX_THREADS 64
+#endif
 
-lin_vec_t *lin_vec_create(size_t dim);
-lin_vec_t *lin_vec_create_from_array(size_t dim, lin_decimal_t const *elements);
-lin_vec_t *lin_vec_scalar_mult(lin_vec_t const *v, lin_decimal_t k);
-lin_vec_t *lin_vec_add(lin_vec_t const *a, lin_vec_t const *b);
-lin_vec_t *lin_vec_sub(lin_vec_t const *a, lin_vec_t const *b);
-lin_decimal_t lin_vec_dot(lin_vec_t const *a, lin_vec_t const *b);
-lin_decimal_t lin_vec_len(lin_vec_t const *v);
-lin_decimal_t lin_vec_angle(lin_vec_t const *a, lin_vec_t const *b, 
-                            AngleType angle_type);
-lin_vec_t *lin_vec_cross(lin_vec_t const *a, lin_vec_t const *b);
-lin_vec_t *lin_vec_map(lin_vec_t const *v, lin_decimal_t (*fn)(lin_decimal_t));
-void _lin_vec_print(lin_vec_t const *v);
+// Minimum amount of work (roughly, elements touched) given to each thread
+#ifndef LIN_PARALLEL_GRAIN
+#define LIN_PARALLEL_GRAIN ((size_t)1 << 16)
+#endif
+
+void lin_set_num_threads(size_t n);
+size_t lin_get_num_threads(void);
+void lin_set_numa_first_touch(bool enabled);
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-// VECTOR IMPLEMENTATION
+// THREADING IMPLEMENTATION
 //
 ///////////////////////////////////////////////////////////////////////////////
 
-lin_vec_t *lin_vec_create(size_t const dim) {
-    lin_vec_t *vec = (lin_vec_t *)malloc(sizeof(lin_vec_t));
-    if (vec == NULL) {
-        LIN_LOG_ERROR("Failed to allocate memory for lin_vec_t");
-        return NULL;
-    }
+#ifndef LIN_NO_THREADS
+#include <pthread.h>
+#include <unistd.h>
+// Pinning workers to processors needs the GNU affinity API, which is only
+// declared when the program itself defines `_GNU_SOURCE`
+#if defined(__linux__) && defined(_GNU_SOURCE)
+#include <sched.h>
+#ifdef CPU_SETSIZE
+#define _LIN_PIN_THREADS
+#endif
+#endif
+#endif
 
-    vec->elements = (lin_decimal_t *)malloc(dim * sizeof(lin_decimal_t));
-    if (vec->elements == NULL) {
-        LIN_LOG_ERROR("Failed to allocate memory for vector elements");
-        free(vec);
-        return NULL;
-    }
+// 0 means one thread per online processor
+static size_t _lin_num_threads = 0;
+static bool _lin_first_touch = false;
 
-    vec->dim = dim;
-    return vec;
+/// Where `n` is the maximum number of threads used by a single operation,
+/// or 0 to use one per online processor
+void lin_set_num_threads(size_t n) {
+    _lin_num_threads = n > LIN_MAX_THREADS ? LIN_MAX_THREADS : n;
 }
-lin_vec_t *lin_vec_create_from_array(size_t const dim, lin_decimal_t const *elements) {
-    lin_vec_t *vec = lin_vec_create(dim);
-    
-    for (size_t i = 0; i < dim; i++) {
-        lin_decimal_t const * const n = &elements[i];
-        if (n == NULL) {
-            LIN_LOG_ERROR(
-                "Array passed to lin_vec_create_from_array is incompatible \
-                with given dimension"
-            );
-            free(vec);
-            return NULL;
-        }
 
-        vec->elements[i] = *n;
+size_t lin_get_num_threads(void) {
+#ifdef LIN_NO_THREADS
+    return 1;
+#else
+    if (_lin_num_threads != 0) {
+        return _lin_num_threads;
     }
-    
-    return vec;
-}
 
-lin_vec_t *lin_vec_scalar_mult(lin_vec_t const *v, lin_decimal_t k) {
-    lin_vec_t *res = lin_vec_create(v->dim);
-    for (size_t i = 0; i < v->dim; i++) {
-        res->elements[i] = v->elements[i] * k;
+    long const procs = sysconf(_SC_NPROCESSORS_ONLN);
+    if (procs < 1) {
+        return 1;
     }
-
-    return res;
+    return (size_t)procs > LIN_MAX_THREADS ? LIN_MAX_THREADS : (size_t)procs;
+#endif
 }
 
-lin_vec_t *lin_vec_add(lin_vec_t const *a, lin_vec_t const *b) {
-    if (a->dim != b->dim) {
-        LIN_LOG_ERROR("Length mistmatch during vector addition (%zu and %zu)",
-                      a->dim, b->dim);
-        exit(EXIT_FAILURE);
-    }
+/// When enabled, new matrices have their pages first touched by the same
+/// worker threads, pinned to the same processors, that later process them in
+/// parallel operations of the same size. On NUMA machines this places each
+/// part of a large matrix on the memory node of the processor that uses it.
+void lin_set_numa_first_touch(bool enabled) {
+    _lin_first_touch = enabled;
+}
 
-    lin_vec_t *res = lin_vec_create(a->dim);
-    for (size_t i = 0; i < a->dim; i++) {
-        res->elements[i] = a->elements[i] + b->elements[i];
-    }
+// Processes items [begin, end) as part number `chunk` of a split operation
+typedef void (*_lin_range_fn_t)(void *ctx, size_t chunk, size_t begin, size_t end);
 
-    return res;
-}
+typedef struct {
+    _lin_range_fn_t fn;
+    void *ctx;
+    size_t chunk, begin, end;
+    // Processor the worker pins itself to, or -1 to leave it unpinned
+    int cpu;
+} _lin_range_t;
 
-lin_vec_t *lin_vec_sub(lin_vec_t const *a, lin_vec_t const *b) {
-    if (a->dim != b->dim) {
-        LIN_LOG_ERROR(
-            "Length mistmatch during vector subtraction (%zu and %zu)",
-            a->dim, b->dim
-        );
-        exit(EXIT_FAILURE);
+// Number of chunks `n` items costing `work_per_item` each should be split into
+static size_t _lin_parallel_chunks(size_t n, size_t work_per_item) {
+    size_t const work = n * (work_per_item == 0 ? 1 : work_per_item);
+    size_t chunks = work / LIN_PARALLEL_GRAIN;
+    if (chunks <= 1) {
+        // too small to split, skip querying the processor count
+        return 1;
     }
 
-    lin_vec_t *res = lin_vec_create(a->dim);
-    for (size_t i = 0; i < a->dim; i++) {
-        res->elements[i] = a->elements[i] - b->elements[i];
-    }
+    size_t const threads = lin_get_num_threads();
 
-    return res;
+    chunks = chunks > threads ? threads : chunks;
+    chunks = chunks > n ? n : chunks;
+    return chunks == 0 ? 1 : chunks;
 }
 
-lin_decimal_t lin_vec_dot(lin_vec_t const *a, lin_vec_t const *b) {
-    if (a->dim != b->dim) {
-        LIN_LOG_ERROR(
-            "Length mistmatch while taking dot product (%zu and %zu)",
-            a->dim, b->dim
-        );
-        exit(EXIT_FAILURE);
-    }
-
-    lin_decimal_t sum = 0;
-    for (size_t i = 0; i < a->dim; i++) {
-        sum += a->elements[i] * b->elements[i];
+#ifndef LIN_NO_THREADS
+static void *_lin_range_thread(void *arg) {
+    _lin_range_t const *range = (_lin_range_t const *)arg;
+#ifdef _LIN_PIN_THREADS
+    if (range->cpu >= 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(range->cpu, &cpus);
+        if (sched_setaffinity(0, sizeof(cpus), &cpus) != 0) {
+            // still run the chunk here, it just loses its memory locality
+            LIN_LOG_ERROR("Failed to pin worker thread to processor %d",
+                          range->cpu);
+        }
     }
-
-    return sum;
+#endif
+    range->fn(range->ctx, range->chunk, range->begin, range->end);
+    return NULL;
 }
 
-lin_decimal_t lin_vec_len(lin_vec_t const *v) {
-    lin_decimal_t sum = 0;
+// Assigns each of the `chunks` ranges a processor in first touch mode,
+// spreading them evenly over the processors the calling thread may run on so
+// the same chunk always lands on the same one
+static void _lin_range_cpus(_lin_range_t *ranges, size_t chunks) {
+#ifdef _LIN_PIN_THREADS
+    cpu_set_t allowed;
+    if (_lin_first_touch
+        && sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+        int cpus[CPU_SETSIZE];
+        size_t count = 0;
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &allowed)) {
+                cpus[count++] = cpu;
+            }
+        }
 
-    for (size_t i = 0; i < v->dim; i++) {
-        sum += v->elements[i] * v->elements[i];
+        if (count > 0) {
+            for (size_t c = 0; c < chunks; c++) {
+                ranges[c].cpu = cpus[(c * count) / chunks];
+            }
+            return;
+        }
+    }
+#endif
+    for (size_t c = 0; c < chunks; c++) {
+        ranges[c].cpu = -1;
     }
-
-    return (lin_decimal_t)sqrt((double)sum);
 }
+#endif
 
-lin_decimal_t lin_vec_angle(lin_vec_t const *a, lin_vec_t const *b, AngleType angle_type) {
-    if (a->dim != b->dim) {
-        LIN_LOG_ERROR(
-            "Length mistmatch while taking dot product (%zu and %zu)",
-            a->dim, b->dim
-        );
-        exit(EXIT_FAILURE);
+// Runs `fn` over [0, n) split into `chunks` contiguous ranges. The last range
+// runs on the calling thread unless workers are being pinned.
+static void _lin_parallel_run(size_t n, size_t chunks, _lin_range_fn_t fn,
+                              void *ctx) {
+#ifdef LIN_NO_THREADS
+    (void)chunks;
+    fn(ctx, 0, 0, n);
+#else
+    if (chunks <= 1) {
+        fn(ctx, 0, 0, n);
+        return;
     }
 
-    lin_decimal_t rads = (lin_decimal_t)acos(
-        (double)(lin_vec_dot(a, b) /
-        (lin_vec_len(a) * lin_vec_len(b)))
-    );
+    _lin_range_t ranges[LIN_MAX_THREADS];
+    pthread_t threads[LIN_MAX_THREADS];
+    bool started[LIN_MAX_THREADS];
 
-    if (angle_type == DEGREES) {
-        return (lin_decimal_t)(rads * (180.0 / M_PI));
+    chunks = chunks > LIN_MAX_THREADS ? LIN_MAX_THREADS : chunks;
+    for (size_t c = 0; c < chunks; c++) {
+        ranges[c] = (_lin_range_t){
+            fn, ctx, c, (n * c) / chunks, (n * (c + 1)) / chunks, -1
+        };
     }
+    _lin_range_cpus(ranges, chunks);
 
-    return rads;
-}
-
-lin_vec_t *lin_vec_cross(lin_vec_t const *a, lin_vec_t const *b) {
-    if (a->dim != b->dim) {
-        LIN_LOG_ERROR(
-            "Length mistmatch while taking cross product (%zu and %zu)",
-            a->dim, b->dim
-        );
-        exit(EXIT_FAILURE);
+    size_t const workers = _lin_first_touch ? chunks : chunks - 1;
+    for (size_t c = 0; c < workers; c++) {
+        started[c] = pthread_create(&threads[c], NULL, _lin_range_thread,
+                                    &ranges[c]) == 0;
+        if (!started[c]) {
+            fn(ctx, c, ranges[c].begin, ranges[c].end);
+        }
     }
 
-    if (a->dim != 3) {
-        LIN_LOG_ERROR(
-            "Cross product is not defined for vectors of %zu dimensions",
-            a->dim
-        );
-        exit(EXIT_FAILURE);
+    if (workers < chunks) {
+        fn(ctx, chunks - 1, ranges[chunks - 1].begin, ranges[chunks - 1].end);
     }
 
-    lin_decimal_t res_elements[3] = {
-        a->elements[1] * b->elements[2] - a->elements[2] * b->elements[1],
-        a->elements[2] * b->elements[0] - a->elements[0] * b->elements[2],
-        a->elements[0] * b->elements[1] - a->elements[1] * b->elements[0],
-    };
-
-    return lin_vec_create_from_array(3, res_elements);
-}
-
-lin_vec_t *lin_vec_map(lin_vec_t const *v, lin_decimal_t (*fn)(lin_decimal_t)) {
-    lin_vec_t *res = lin_vec_create(v->dim);
-    for (size_t i = 0; i < v->dim; i++) {
-        res->elements[i] = fn(v->elements[i]);
+    for (size_t c = 0; c < workers; c++) {
+        if (started[c]) {
+            pthread_join(threads[c], NULL);
+        }
     }
-
-    return res;
+#endif
 }
 
-void _lin_vec_print(lin_vec_t const *v) {
-    printf("[ ");
-    for (size_t i = 0; i < v->dim; i++) {
-        printf("%f ", v->elements[i]);
-    }
-    printf("]\n");
+static void _lin_parallel_for(size_t n, size_t work_per_item,
+                              _lin_range_fn_t fn, void *ctx) {
+    _lin_parallel_run(n, _lin_parallel_chunks(n, work_per_item), fn, ctx);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-// MATRIX DECLARATION
+// TRACE DECLARATION
 //
 ///////////////////////////////////////////////////////////////////////////////
 
-typedef struct {
-    size_t rows, columns;
-} lin_mat_shape_t;
+// Define `LIN_TRACE` before including `lin.h` to have every public function
+// report its entry and exit, with the shapes of its first two operands, to a
+// callback set with `lin_set_trace_callback`. Without it the hooks compile to
+// nothing and the callback is never invoked. Tracing relies on the `cleanup`
+// attribute of GCC and Clang.
+//
+// `lin_trace_start_json` installs a built-in callback that records events in
+// a ring buffer per thread, from which a background thread writes them as
+// Chrome trace-event JSON, viewable in chrome://tracing or Perfetto.
+
+// Events kept per thread until written, further events are dropped
+#ifndef LIN_TRACE_RING
+#define LIN_TRACE_RING 4096
+#endif
+
+// Milliseconds between writes of the recorded events
+#ifndef LIN_TRACE_FLUSH_MS
+#define LIN_TRACE_FLUSH_MS 10
+#endif
+
+typedef enum {
+    LIN_TRACE_BEGIN,
+    LIN_TRACE_END,
+} lin_trace_phase_t;
 
 typedef struct {
-    lin_mat_shape_t shape;
-    lin_decimal_t *elements;
-} lin_mat_t;
+    lin_trace_phase_t phase;
+    // name of the function, e.g. "lin_mat_mult"
+    char const *op;
+    // [rows x columns] of the first two operands, vectors as [dim x 1] and
+    // 0 where the function has no such operand. Only set on entry.
+    size_t a_rows, a_columns, b_rows, b_columns;
+} lin_trace_event_t;
 
-lin_mat_t *lin_mat_create(lin_mat_shape_t shape);
-lin_mat_t *lin_mat_create_from_array(lin_mat_shape_t shape, lin_decimal_t const *elements);
-lin_mat_t *lin_mat_mult(lin_mat_t const *a, lin_mat_t const *b);
-lin_mat_t *lin_mat_add(lin_mat_t const *a, lin_mat_t const *b);
-lin_mat_t *lin_mat_sub(lin_mat_t const *a, lin_mat_t const *b);
-lin_mat_t *lin_mat_scalar_mult(lin_mat_t const *mat, lin_decimal_t k);
-lin_mat_t *lin_mat_transpose(lin_mat_t const *mat);
-lin_decimal_t lin_mat_det(lin_mat_t const *mat);
-lin_mat_t *lin_mat_identity(size_t n);
-lin_mat_t *lin_mat_row(lin_mat_t const *mat, size_t n);
-lin_mat_t *lin_mat_col(lin_mat_t const *mat, size_t n);
-lin_vec_t *lin_mat_row_vec(lin_mat_t const *mat, size_t n);
-lin_vec_t *lin_mat_col_vec(lin_mat_t const *mat, size_t n);
-lin_decimal_t lin_mat_minor_of_element(lin_mat_t const *a, size_t row, size_t col);
-lin_mat_t *lin_mat_minor(lin_mat_t const *a);
-lin_decimal_t lin_mat_cofactor_of_element(lin_mat_t const *a, size_t row, size_t col);
-lin_mat_t *lin_mat_cofactor(lin_mat_t const *a);
-lin_mat_t *lin_mat_adj(lin_mat_t const *a);
-lin_mat_t *lin_mat_inv(lin_mat_t const *a);
-lin_mat_t *lin_mat_map(lin_mat_t *mat, lin_decimal_t (*fn)(lin_decimal_t));
-void _lin_mat_print(lin_mat_t const *a);
+typedef void (*lin_trace_fn_t)(lin_trace_event_t const *event, void *user);
+
+void lin_set_trace_callback(lin_trace_fn_t fn, void *user);
+bool lin_trace_start_json(char const *path);
+bool lin_trace_stop_json(void);
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-// MATRIX IMPLEMENTATION
+// TRACE IMPLEMENTATION
 //
 ///////////////////////////////////////////////////////////////////////////////
 
-lin_mat_t *lin_mat_create(lin_mat_shape_t shape) {
-    lin_mat_t *mat = (lin_mat_t *)malloc(sizeof(lin_mat_t));
+#ifdef LIN_TRACE
 
-    if (mat == NULL) {
-        return NULL;
-    }
+#include <stdint.h>
+#include <time.h>
 
-    mat->shape = shape;
-    mat->elements = (lin_decimal_t *)malloc(
-        shape.rows * shape.columns * sizeof(lin_decimal_t)
-    );
-    if (mat->elements == NULL) {
-        LIN_LOG_ERROR(
-            "Failed to allocate memory for matrix of dimensions [%zu x %zu]", 
-            shape.rows, shape.columns
-        );
-        free(mat->elements);
-        free(mat);
-        return NULL;
-    }
+static lin_trace_fn_t _lin_trace_fn = NULL;
+static void *_lin_trace_user = NULL;
 
-    return mat;
+/// Where `fn` is called with `user` on entry to and exit from every public
+/// function, or NULL to stop tracing. Not to be changed while other threads
+/// are calling into `lin.h`.
+void lin_set_trace_callback(lin_trace_fn_t fn, void *user) {
+    _lin_trace_fn = fn;
+    _lin_trace_user = user;
 }
 
-lin_mat_t *lin_mat_create_from_array(lin_mat_shape_t shape, lin_decimal_t const *elements) {
-    lin_mat_t *mat = lin_mat_create(shape);
-    
-    for (size_t i = 0; i < shape.rows; i++) {
-        for (size_t j = 0; j < shape.columns; j++) {
-            mat->elements[(i * mat->shape.columns) + j] = 
-                elements[(i * shape.columns) + j];
-        }
+// Reports entry to `op`, returning the name to report on exit, or NULL if
+// tracing is off
+static inline char const *_lin_trace_begin(char const *op,
+                                           size_t a_rows, size_t a_columns,
+                                           size_t b_rows, size_t b_columns) {
+    if (__builtin_expect(_lin_trace_fn == NULL, 1)) {
+        return NULL;
     }
 
-    return mat;
+    lin_trace_event_t const event = {
+        LIN_TRACE_BEGIN, op, a_rows, a_columns, b_rows, b_columns
+    };
+    _lin_trace_fn(&event, _lin_trace_user);
+    return op;
 }
 
-lin_mat_t *lin_mat_mult(lin_mat_t const *a, lin_mat_t const *b) {
-    if (a->shape.columns != b->shape.rows) {
-        LIN_LOG_ERROR("Dimension mismatch during matrix multiplication \
-                      [%zu x %zu] [%zu x %zu]",
-                      a->shape.rows, a->shape.columns,
-                      b->shape.rows, b->shape.columns);
-        exit(EXIT_FAILURE);
+static inline void _lin_trace_end(char const *const *op) {
+    if (__builtin_expect(*op != NULL, 0) && _lin_trace_fn != NULL) {
+        lin_trace_event_t const event = {LIN_TRACE_END, *op, 0, 0, 0, 0};
+        _lin_trace_fn(&event, _lin_trace_user);
     }
+}
 
-    lin_mat_t *res = lin_mat_create((lin_mat_shape_t){
-        a->shape.rows, b->shape.columns
-    });
-    for (size_t a_row = 0; a_row < a->shape.rows; a_row++) {
-        for (size_t b_col = 0; b_col < b->shape.columns; b_col++) {
-            lin_decimal_t column[b->shape.rows];
-            for (size_t i = 0; i < b->shape.rows; i++) {
-                column[i] = b->elements[(i * b->shape.columns) + b_col];
-            }
+// Traces the enclosing function from here until it returns. `a` and `b` are
+// operand shapes given as `rows, columns`, see the _LIN_*_DIMS macros.
+#define _LIN_TRACE(a, b) \
+    char const *const _lin_trace_op \
+        __attribute__((cleanup(_lin_trace_end))) = \
+        _lin_trace_begin(__func__, a, b)
 
-            lin_decimal_t row[a->shape.columns];
+// Built-in JSON sink
 
-            for (size_t i = 0; i < a->shape.columns; i++) {
-                row[i] = a->elements[(a_row * a->shape.columns) + i];
-            }
+typedef struct {
+    lin_trace_event_t event;
+    uint64_t ns;
+} _lin_trace_record_t;
 
-            lin_decimal_t d = lin_vec_dot(
-                &(lin_vec_t){a->shape.columns, row},
-                &(lin_vec_t){b->shape.rows, column}
-            );
-            res->elements[(a_row * res->shape.columns) + b_col] = d;
-        }
-    }
+// Single producer, single consumer ring of one thread's events. `head` is
+// only advanced by the owning thread and `tail` by the writer.
+typedef struct _lin_trace_ring {
+    _lin_trace_record_t records[LIN_TRACE_RING];
+    size_t head, tail, dropped, tid;
+    bool in_use;
+    struct _lin_trace_ring *next;
+} _lin_trace_ring_t;
+
+typedef struct {
+    FILE *file;
+    bool first, ok;
+    _lin_trace_ring_t *rings;
+    size_t ring_count;
+    uint64_t start_ns;
+#ifndef LIN_NO_THREADS
+    pthread_mutex_t lock;
+    pthread_key_t key;
+    bool key_created, stop;
+    pthread_t writer;
+#endif
+} _lin_trace_json_t;
 
+static _lin_trace_json_t _lin_trace_json = {
+    NULL, true, true, NULL, 0, 0,
+#ifndef LIN_NO_THREADS
+    PTHREAD_MUTEX_INITIALIZER, 0, false, false, 0,
+#endif
+};
 
-    return res;
+static uint64_t _lin_trace_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * UINT64_C(1000000000)) + (uint64_t)ts.tv_nsec;
 }
 
-lin_mat_t *lin_mat_add(lin_mat_t const *a, lin_mat_t const *b) {
-    if (a->shape.rows != b->shape.rows
-        || a->shape.columns != b->shape.columns) {
-        LIN_LOG_ERROR(
-            "Dimension mismatch during matrix addition [%zu x %zu] [%zu x %zu]",
-            a->shape.rows, a->shape.columns, b->shape.rows, b->shape.columns
-        );
-        exit(EXIT_FAILURE);
+// Writes out the events recorded in `ring` so far
+static void _lin_trace_drain(_lin_trace_ring_t *ring) {
+    _lin_trace_json_t *j = &_lin_trace_json;
+    size_t const head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    size_t tail = ring->tail;
+    for (; tail != head; tail++) {
+        _lin_trace_record_t const *r = &ring->records[tail % LIN_TRACE_RING];
+        double const us = (double)(r->ns - j->start_ns) / 1000.0;
+        int n;
+        if (r->event.phase == LIN_TRACE_BEGIN) {
+            n = fprintf(j->file,
+                        "%s{\"name\":\"%s\",\"ph\":\"B\",\"ts\":%.3f,\"pid\":1,"
+                        "\"tid\":%zu,\"args\":{\"a\":\"%zux%zu\",\"b\":\"%zux%zu\"}}",
+                        j->first ? "" : ",\n", r->event.op, us, ring->tid,
+                        r->event.a_rows, r->event.a_columns,
+                        r->event.b_rows, r->event.b_columns);
+        } else {
+            n = fprintf(j->file,
+                        "%s{\"name\":\"%s\",\"ph\":\"E\",\"ts\":%.3f,\"pid\":1,"
+                        "\"tid\":%zu}",
+                        j->first ? "" : ",\n", r->event.op, us, ring->tid);
+        }
+        j->first = false;
+        j->ok = j->ok && n > 0;
     }
+    __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+}
 
-    lin_mat_t *res = lin_mat_create(a->shape);
-    for (size_t row = 0; row < a->shape.rows; row++) {
-        for (size_t col = 0; col < a->shape.columns; col++) {
-            res->elements[(row * res->shape.columns) + col] = 
-                a->elements[(row * a->shape.columns) + col] + 
-                b->elements[(row * b->shape.columns) + col];
-        }
+static void _lin_trace_drain_all(void) {
+#ifndef LIN_NO_THREADS
+    pthread_mutex_lock(&_lin_trace_json.lock);
+#endif
+    for (_lin_trace_ring_t *ring = _lin_trace_json.rings; ring != NULL;
+         ring = ring->next) {
+        _lin_trace_drain(ring);
     }
+#ifndef LIN_NO_THREADS
+    pthread_mutex_unlock(&_lin_trace_json.lock);
+#endif
+}
 
-    return res;
+#ifndef LIN_NO_THREADS
+// Frees the ring of an exiting thread for reuse by a later one
+static void _lin_trace_ring_release(void *ring) {
+    pthread_mutex_lock(&_lin_trace_json.lock);
+    ((_lin_trace_ring_t *)ring)->in_use = false;
+    pthread_mutex_unlock(&_lin_trace_json.lock);
 }
+#endif
 
+// Ring of the calling thread, taking a free one or allocating it on first use
+static _lin_trace_ring_t *_lin_trace_ring(void) {
+    _lin_trace_json_t *j = &_lin_trace_json;
+#ifndef LIN_NO_THREADS
+    _lin_trace_ring_t *ring = (_lin_trace_ring_t *)pthread_getspecific(j->key);
+    if (ring != NULL) {
+        return ring;
+    }
+
+    pthread_mutex_lock(&j->lock);
+#else
+    if (j->rings != NULL) {
+        return j->rings;
+    }
+    _lin_trace_ring_t *ring;
+#endif
+    for (ring = j->rings; ring != NULL && ring->in_use; ring = ring->next) {
+    }
+    if (ring == NULL) {
+        ring = (_lin_trace_ring_t *)calloc(1, sizeof(_lin_trace_ring_t));
+        if (ring != NULL) {
+            ring->tid = ++j->ring_count;
+            ring->next = j->rings;
+            j->rings = ring;
+        }
+    }
+    if (ring != NULL) {
+        ring->in_use = true;
+    }
+#ifndef LIN_NO_THREADS
+    pthread_mutex_unlock(&j->lock);
+    if (ring != NULL) {
+        pthread_setspecific(j->key, ring);
+    }
+#endif
+    return ring;
+}
+
+static void _lin_trace_json_event(lin_trace_event_t const *event, void *user) {
+    (void)user;
+    _lin_trace_ring_t *ring = _lin_trace_ring();
+    if (ring == NULL) {
+        return;
+    }
+
+    size_t const head = ring->head;
+    if (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) == LIN_TRACE_RING) {
+#ifdef LIN_NO_THREADS
+        _lin_trace_drain(ring);
+#else
+        ring->dropped++;
+        return;
+#endif
+    }
+
+    ring->records[head % LIN_TRACE_RING] = (_lin_trace_record_t){
+        *event, _lin_trace_now()
+    };
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+#ifndef LIN_NO_THREADS
+static void *_lin_trace_writer(void *arg) {
+    (void)arg;
+    struct timespec const pause = {
+        LIN_TRACE_FLUSH_MS / 1000, (LIN_TRACE_FLUSH_MS % 1000) * 1000000L
+    };
+    while (!__atomic_load_n(&_lin_trace_json.stop, __ATOMIC_ACQUIRE)) {
+        _lin_trace_drain_all();
+        nanosleep(&pause, NULL);
+    }
+    return NULL;
+}
+#endif
+
+/// Starts recording calls of the current and all other threads, written to
+/// `path` as Chrome trace-event JSON until `lin_trace_stop_json`. Replaces
+/// any callback set with `lin_set_trace_callback`.
+bool lin_trace_start_json(char const *path) {
+    _lin_trace_json_t *j = &_lin_trace_json;
+    if (j->file != NULL) {
+        LIN_LOG_ERROR("A JSON trace is already being written");
+        return false;
+    }
+
+    j->file = fopen(path, "w");
+    if (j->file == NULL) {
+        LIN_LOG_ERROR("Failed to open %s for writing", path);
+        return false;
+    }
+    fputs("[\n", j->file);
+    j->first = true;
+    j->ok = true;
+    j->start_ns = _lin_trace_now();
+
+#ifndef LIN_NO_THREADS
+    if (!j->key_created) {
+        j->key_created = pthread_key_create(&j->key, _lin_trace_ring_release) == 0;
+    }
+    j->stop = false;
+    if (!j->key_created
+        || pthread_create(&j->writer, NULL, _lin_trace_writer, NULL) != 0) {
+        LIN_LOG_ERROR("Failed to start trace writer thread");
+        fclose(j->file);
+        j->file = NULL;
+        return false;
+    }
+#endif
+
+    lin_set_trace_callback(_lin_trace_json_event, NULL);
+    return true;
+}
+
+/// Stops recording, writes out the remaining events and closes the file.
+/// Returns false if writing failed or events had to be dropped.
+bool lin_trace_stop_json(void) {
+    _lin_trace_json_t *j = &_lin_trace_json;
+    if (j->file == NULL) {
+        return false;
+    }
+
+    lin_set_trace_callback(NULL, NULL);
+#ifndef LIN_NO_THREADS
+    __atomic_store_n(&j->stop, true, __ATOMIC_RELEASE);
+    pthread_join(j->writer, NULL);
+#endif
+    _lin_trace_drain_all();
+
+    size_t dropped = 0;
+    for (_lin_trace_ring_t *ring = j->rings; ring != NULL; ring = ring->next) {
+        dropped += ring->dropped;
+        ring->dropped = 0;
+    }
+
+    fputs("\n]\n", j->file);
+    bool ok = j->ok && fclose(j->file) == 0;
+    j->file = NULL;
+    if (!ok) {
+        LIN_LOG_ERROR("Failed to write JSON trace");
+    }
+    if (dropped > 0) {
+        LIN_LOG_ERROR("Dropped %zu trace events, consider a larger LIN_TRACE_RING",
+                      dropped);
+        ok = false;
+    }
+    return ok;
+}
+
+#else
+
+#define _LIN_TRACE(a, b) ((void)0)
+
+void lin_set_trace_callback(lin_trace_fn_t fn, void *user) {
+    (void)fn;
+    (void)user;
+}
+
+bool lin_trace_start_json(char const *path) {
+    (void)path;
+    LIN_LOG_ERROR("Tracing requires LIN_TRACE to be defined before including lin.h");
+    return false;
+}
+
+bool lin_trace_stop_json(void) {
+    return false;
+}
+
+#endif // LIN_TRACE
+
+// Operand shapes for _LIN_TRACE
+#define _LIN_DIMS(rows, columns) rows, columns
+#define _LIN_MAT_DIMS(m) (m)->shape.rows, (m)->shape.columns
+#define _LIN_VEC_DIMS(v) (v)->dim, 1
+#define _LIN_VEC3_DIMS(a) (a)->len, 3
+#define _LIN_SHAPE_DIMS(s) (s).rows, (s).columns
+#define _LIN_NO_DIMS 0, 0
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// KERNELS
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Internal routines working on raw row-major buffers. `ld*` is the number of
+// elements between the starts of consecutive rows, which lets a kernel operate
+// on a sub-block of a larger matrix in place.
+
+#ifndef LIN_GEMM_BLOCK
+#define LIN_GEMM_BLOCK 64
+#endif
+
+static inline size_t _lin_min(size_t a, size_t b) {
+    return a < b ? a : b;
+}
+
+static inline size_t _lin_max(size_t a, size_t b) {
+    return a > b ? a : b;
+}
+
+// Sum of a[i] * b[i], with independent partial sums so the loop vectorizes
+static lin_decimal_t _lin_dot(lin_decimal_t const *a, lin_decimal_t const *b,
+                              size_t n) {
+    lin_decimal_t acc[8] = {0};
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        for (size_t l = 0; l < 8; l++) {
+            acc[l] += a[i + l] * b[i + l];
+        }
+    }
+
+    lin_decimal_t sum = ((acc[0] + acc[4]) + (acc[1] + acc[5])) +
+        ((acc[2] + acc[6]) + (acc[3] + acc[7]));
+    for (; i < n; i++) {
+        sum += a[i] * b[i];
+    }
+
+    return sum;
+}
+
+// y += alpha * x
+static void _lin_axpy(size_t n, lin_decimal_t alpha,
+                      lin_decimal_t const *restrict x,
+                      lin_decimal_t *restrict y) {
+    for (size_t i = 0; i < n; i++) {
+        y[i] += alpha * x[i];
+    }
+}
+
+// x *= alpha
+static void _lin_scale(size_t n, lin_decimal_t alpha, lin_decimal_t *x) {
+    for (size_t i = 0; i < n; i++) {
+        x[i] *= alpha;
+    }
+}
+
+// c = alpha * op(a) * op(b) + beta * c
+// where op(x) is x or x^T, op(a) is [m x k], op(b) is [k x n], c is [m x n]
+static void _lin_gemm(bool trans_a, bool trans_b,
+                      size_t m, size_t n, size_t k,
+                      lin_decimal_t alpha,
+                      lin_decimal_t const *a, size_t lda,
+                      lin_decimal_t const *b, size_t ldb,
+                      lin_decimal_t beta,
+                      lin_decimal_t *c, size_t ldc) {
+    for (size_t i = 0; i < m; i++) {
+        lin_decimal_t *c_row = &c[i * ldc];
+        if (beta == (lin_decimal_t)0) {
+            for (size_t j = 0; j < n; j++) {
+                c_row[j] = (lin_decimal_t)0;
+            }
+        } else if (beta != (lin_decimal_t)1) {
+            for (size_t j = 0; j < n; j++) {
+                c_row[j] *= beta;
+            }
+        }
+    }
+
+    if (alpha == (lin_decimal_t)0 || k == 0) {
+        return;
+    }
+
+    size_t const bs = LIN_GEMM_BLOCK;
+    for (size_t i0 = 0; i0 < m; i0 += bs) {
+        size_t const i1 = _lin_min(i0 + bs, m);
+        for (size_t p0 = 0; p0 < k; p0 += bs) {
+            size_t const p1 = _lin_min(p0 + bs, k);
+            for (size_t j0 = 0; j0 < n; j0 += bs) {
+                size_t const j1 = _lin_min(j0 + bs, n);
+                for (size_t i = i0; i < i1; i++) {
+                    lin_decimal_t *c_row = &c[i * ldc];
+
+                    if (!trans_b) {
+                        // rows of b are contiguous, accumulate c_row += a_ip * b_row
+                        for (size_t p = p0; p < p1; p++) {
+                            lin_decimal_t const a_ip = alpha * (trans_a
+                                ? a[(p * lda) + i] : a[(i * lda) + p]);
+                            lin_decimal_t const *b_row = &b[p * ldb];
+                            for (size_t j = j0; j < j1; j++) {
+                                c_row[j] += a_ip * b_row[j];
+                            }
+                        }
+                        continue;
+                    }
+
+                    // columns of op(b) are rows of b, take dot products
+                    for (size_t j = j0; j < j1; j++) {
+                        lin_decimal_t const *b_row = &b[j * ldb];
+                        lin_decimal_t sum = 0;
+                        if (trans_a) {
+                            for (size_t p = p0; p < p1; p++) {
+                                sum += a[(p * lda) + i] * b_row[p];
+                            }
+                        } else {
+                            lin_decimal_t const *a_row = &a[i * lda];
+                            for (size_t p = p0; p < p1; p++) {
+                                sum += a_row[p] * b_row[p];
+                            }
+                        }
+                        c_row[j] += alpha * sum;
+                    }
+                }
+            }
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// SMALL KERNELS
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Copies of the matrix routines specialized for each size from 2 to 8, which
+// `lin_mat_mult`, `lin_mat_inv`, `lin_mat_transpose` and `lin_mat_add`
+// dispatch to by shape. All their loop bounds are constants, so the compiler
+// unrolls them completely. Define `LIN_NO_SMALL_KERNELS` to always take the
+// generic paths.
+
+#define _LIN_SMALL_SIZES(X) X(2) X(3) X(4) X(5) X(6) X(7) X(8)
+
+#ifndef LIN_NO_SMALL_KERNELS
+
+// c[m x N] = a[m x N] * b[N x N]
+#define _LIN_SMALL_MULT(N) \
+static void _lin_small_mult_##N(size_t m, lin_decimal_t const *restrict a, \
+                                lin_decimal_t const *restrict b, \
+                                lin_decimal_t *restrict c) { \
+    for (size_t i = 0; i < m; i++) { \
+        lin_decimal_t row[N] = {0}; \
+        for (size_t p = 0; p < N; p++) { \
+            for (size_t j = 0; j < N; j++) { \
+                row[j] += a[(i * N) + p] * b[(p * N) + j]; \
+            } \
+        } \
+        for (size_t j = 0; j < N; j++) { \
+            c[(i * N) + j] = row[j]; \
+        } \
+    } \
+}
+
+// c[m x 1] = a[m x N] * b[N x 1]
+#define _LIN_SMALL_MULT_VEC(N) \
+static void _lin_small_mult_vec_##N(size_t m, lin_decimal_t const *restrict a, \
+                                    lin_decimal_t const *restrict b, \
+                                    lin_decimal_t *restrict c) { \
+    for (size_t i = 0; i < m; i++) { \
+        lin_decimal_t sum = 0; \
+        for (size_t p = 0; p < N; p++) { \
+            sum += a[(i * N) + p] * b[p]; \
+        } \
+        c[i] = sum; \
+    } \
+}
+
+// t = a^T for [N x N] a
+#define _LIN_SMALL_TRANSPOSE(N) \
+static void _lin_small_transpose_##N(lin_decimal_t const *restrict a, \
+                                     lin_decimal_t *restrict t) { \
+    for (size_t i = 0; i < N; i++) { \
+        for (size_t j = 0; j < N; j++) { \
+            t[(j * N) + i] = a[(i * N) + j]; \
+        } \
+    } \
+}
+
+// c = a + b for [N x N] matrices
+#define _LIN_SMALL_ADD(N) \
+static void _lin_small_add_##N(lin_decimal_t const *restrict a, \
+                               lin_decimal_t const *restrict b, \
+                               lin_decimal_t *restrict c) { \
+    for (size_t i = 0; i < N * N; i++) { \
+        c[i] = a[i] + b[i]; \
+    } \
+}
+
+// inv = a^-1 for [N x N] a by Gauss-Jordan elimination with partial pivoting,
+// false if a pivot is exactly zero
+#define _LIN_SMALL_INV(N) \
+static bool _lin_small_inv_##N(lin_decimal_t const *restrict a, \
+                               lin_decimal_t *restrict inv) { \
+    lin_decimal_t w[N][N]; \
+    for (size_t i = 0; i < N; i++) { \
+        for (size_t j = 0; j < N; j++) { \
+            w[i][j] = a[(i * N) + j]; \
+            inv[(i * N) + j] = (lin_decimal_t)(i == j); \
+        } \
+    } \
+    for (size_t k = 0; k < N; k++) { \
+        size_t piv = k; \
+        for (size_t i = k + 1; i < N; i++) { \
+            if (fabs((double)w[i][k]) > fabs((double)w[piv][k])) { \
+                piv = i; \
+            } \
+        } \
+        if (w[piv][k] == (lin_decimal_t)0) { \
+            return false; \
+        } \
+        if (piv != k) { \
+            for (size_t j = 0; j < N; j++) { \
+                lin_decimal_t const tw = w[k][j]; \
+                w[k][j] = w[piv][j]; \
+                w[piv][j] = tw; \
+                lin_decimal_t const ti = inv[(k * N) + j]; \
+                inv[(k * N) + j] = inv[(piv * N) + j]; \
+                inv[(piv * N) + j] = ti; \
+            } \
+        } \
+        lin_decimal_t const d = (lin_decimal_t)1 / w[k][k]; \
+        for (size_t j = 0; j < N; j++) { \
+            w[k][j] *= d; \
+            inv[(k * N) + j] *= d; \
+        } \
+        for (size_t i = 0; i < N; i++) { \
+            if (i == k) { \
+                continue; \
+            } \
+            lin_decimal_t const f = w[i][k]; \
+            for (size_t j = 0; j < N; j++) { \
+                w[i][j] -= f * w[k][j]; \
+                inv[(i * N) + j] -= f * inv[(k * N) + j]; \
+            } \
+        } \
+    } \
+    return true; \
+}
+
+#define _LIN_SMALL_KERNELS(N) \
+    _LIN_SMALL_MULT(N) \
+    _LIN_SMALL_MULT_VEC(N) \
+    _LIN_SMALL_TRANSPOSE(N) \
+    _LIN_SMALL_ADD(N) \
+    _LIN_SMALL_INV(N)
+
+_LIN_SMALL_SIZES(_LIN_SMALL_KERNELS)
+
+#define _LIN_SMALL_MULT_CASE(N) \
+    case N: _lin_small_mult_##N(m, a, b, c); return true;
+#define _LIN_SMALL_MULT_VEC_CASE(N) \
+    case N: _lin_small_mult_vec_##N(m, a, b, c); return true;
+#define _LIN_SMALL_TRANSPOSE_CASE(N) \
+    case N: _lin_small_transpose_##N(a, t); return true;
+#define _LIN_SMALL_ADD_CASE(N) \
+    case N: _lin_small_add_##N(a, b, c); return true;
+#define _LIN_SMALL_INV_CASE(N) \
+    case N: *ok = _lin_small_inv_##N(a, inv); return true;
+
+#endif // LIN_NO_SMALL_KERNELS
+
+// The dispatchers below return false when no kernel matches the shape, leaving
+// the caller to take its generic path
+
+// c = a * b for [m x k] a and [k x n] b, where n is k or 1
+static bool _lin_small_mult(size_t m, size_t k, size_t n,
+                            lin_decimal_t const *a, lin_decimal_t const *b,
+                            lin_decimal_t *c) {
+#ifndef LIN_NO_SMALL_KERNELS
+    if (n == k) {
+        switch (k) {
+            _LIN_SMALL_SIZES(_LIN_SMALL_MULT_CASE)
+            default: break;
+        }
+    } else if (n == 1) {
+        switch (k) {
+            _LIN_SMALL_SIZES(_LIN_SMALL_MULT_VEC_CASE)
+            default: break;
+        }
+    }
+#else
+    (void)m; (void)k; (void)n; (void)a; (void)b; (void)c;
+#endif
+    return false;
+}
+
+static bool _lin_small_transpose(size_t n, lin_decimal_t const *a,
+                                 lin_decimal_t *t) {
+#ifndef LIN_NO_SMALL_KERNELS
+    switch (n) {
+        _LIN_SMALL_SIZES(_LIN_SMALL_TRANSPOSE_CASE)
+        default: break;
+    }
+#else
+    (void)n; (void)a; (void)t;
+#endif
+    return false;
+}
+
+static bool _lin_small_add(size_t n, lin_decimal_t const *a,
+                           lin_decimal_t const *b, lin_decimal_t *c) {
+#ifndef LIN_NO_SMALL_KERNELS
+    switch (n) {
+        _LIN_SMALL_SIZES(_LIN_SMALL_ADD_CASE)
+        default: break;
+    }
+#else
+    (void)n; (void)a; (void)b; (void)c;
+#endif
+    return false;
+}
+
+// `ok` is set to false if `a` turned out to be singular
+static bool _lin_small_inv(size_t n, lin_decimal_t const *a,
+                           lin_decimal_t *inv, bool *ok) {
+#ifndef LIN_NO_SMALL_KERNELS
+    switch (n) {
+        _LIN_SMALL_SIZES(_LIN_SMALL_INV_CASE)
+        default: break;
+    }
+#else
+    (void)n; (void)a; (void)inv; (void)ok;
+#endif
+    return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// DECIMAL CONVERSION
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Conversion of single values between lin_decimal_t and text, used by the
+// printing and text I/O routines. Both take a fast path computed exactly in
+// double precision and fall back to the C library for anything else.
+
+#include <stdint.h>
+
+// Longest text a single value is formatted as. Longer input is still parsed.
+#define _LIN_DECIMAL_TOKEN 64
+
+// Significant digits that always round trip for the decimal type
+#define _LIN_DECIMAL_DIG (sizeof(lin_decimal_t) == sizeof(float) ? 9 : 17)
+
+// Powers of ten exactly representable as doubles
+static double const _lin_pow10[23] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static inline bool _lin_decimal_is_sep(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == ','
+        || c == ';' || c == '#';
+}
+
+// Rounds a double known to be the correctly rounded value of some decimal
+// number to lin_decimal_t. Returns false when that could round differently
+// from the decimal number itself, which only happens when an inexact double
+// lies exactly halfway between two floats, or outside the normal float range.
+static bool _lin_decimal_narrow(double d, bool exact, lin_decimal_t *out) {
+    if (sizeof(lin_decimal_t) == sizeof(double)) {
+        *out = (lin_decimal_t)d;
+        return true;
+    }
+
+    double const a = fabs(d);
+    if (a != 0 && (a < (double)FLT_MIN || a > (double)FLT_MAX)) {
+        return false;
+    }
+
+    uint64_t bits;
+    memcpy(&bits, &d, sizeof(bits));
+    // the 29 bits of a double's significand below float precision
+    uint64_t const low = bits & ((UINT64_C(1) << 29) - 1);
+    if (!exact && low == (UINT64_C(1) << 28)) {
+        return false;
+    }
+
+    *out = (lin_decimal_t)d;
+    return true;
+}
+
+// Value of m * 10^e if it can be computed exactly, see Clinger's fast path
+static bool _lin_decimal_exact(uint64_t m, int e, bool neg,
+                               lin_decimal_t *out) {
+    if (m > (UINT64_C(1) << 53) || e < -22 || e > 22) {
+        return false;
+    }
+
+    double d = (double)m;
+    d = e < 0 ? d / _lin_pow10[-e] : d * _lin_pow10[e];
+    // integers below 2^53 are exact, so no rounding happened at all
+    bool const exact = e >= 0 && d <= (double)(UINT64_C(1) << 53);
+    return _lin_decimal_narrow(neg ? -d : d, exact, out);
+}
+
+// Parses the number starting at `s`, reading no further than `end`. Returns
+// a pointer past the number, or NULL if `s` does not start with one.
+static char const *_lin_decimal_parse(char const *s, char const *end,
+                                      lin_decimal_t *out) {
+    // the fast path below only counts if it accounts for the whole token
+    char const *token_stop = s;
+    while (token_stop < end && !_lin_decimal_is_sep(*token_stop)) {
+        token_stop++;
+    }
+
+    char const *p = s;
+    bool neg = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        neg = *p == '-';
+        p++;
+    }
+
+    // up to 18 significant digits are kept in `m`, later ones only have to
+    // be zero for the value to be exact
+    uint64_t m = 0;
+    int e = 0;
+    size_t digits = 0;
+    bool exact = true;
+    for (; p < end && *p >= '0' && *p <= '9'; p++, digits++) {
+        if (m < UINT64_C(100000000000000000)) {
+            m = (m * 10) + (uint64_t)(*p - '0');
+        } else {
+            e++;
+            exact = exact && *p == '0';
+        }
+    }
+    if (p < end && *p == '.') {
+        for (p++; p < end && *p >= '0' && *p <= '9'; p++, digits++) {
+            if (m < UINT64_C(100000000000000000)) {
+                m = (m * 10) + (uint64_t)(*p - '0');
+                e--;
+            } else {
+                exact = exact && *p == '0';
+            }
+        }
+    }
+
+    if (digits > 0 && p < end && (*p == 'e' || *p == 'E')) {
+        char const *q = p + 1;
+        bool exp_neg = false;
+        if (q < end && (*q == '-' || *q == '+')) {
+            exp_neg = *q == '-';
+            q++;
+        }
+        if (q < end && *q >= '0' && *q <= '9') {
+            int x = 0;
+            for (; q < end && *q >= '0' && *q <= '9'; q++) {
+                x = x < 100000 ? (x * 10) + (*q - '0') : x;
+            }
+            e += exp_neg ? -x : x;
+            p = q;
+        }
+    }
+
+    if (p == token_stop && digits > 0 && exact
+        && _lin_decimal_exact(m, e, neg, out)) {
+        return p;
+    }
+
+    // nan, inf, hexadecimal, long or hard to round, let the C library decide
+    // on a NUL-terminated copy of the token, on the heap if it is long
+    size_t const len = (size_t)(token_stop - s);
+    char small[_LIN_DECIMAL_TOKEN];
+    char *token = len < sizeof(small) ? small : (char *)malloc(len + 1);
+    if (token == NULL) {
+        LIN_LOG_ERROR("Failed to allocate %zu byte number", len);
+        return NULL;
+    }
+    memcpy(token, s, len);
+    token[len] = '\0';
+
+    char *token_end;
+    if (sizeof(lin_decimal_t) == sizeof(float)) {
+        *out = (lin_decimal_t)strtof(token, &token_end);
+    } else {
+        *out = (lin_decimal_t)strtod(token, &token_end);
+    }
+    size_t const used = (size_t)(token_end - token);
+    if (token != small) {
+        free(token);
+    }
+    return used == 0 ? NULL : s + used;
+}
+
+// Writes the digits of m, followed by `zeros` zeros, returning the length
+static size_t _lin_decimal_digits(char *out, uint64_t m, size_t zeros) {
+    char rev[20];
+    size_t n = 0;
+    do {
+        rev[n++] = (char)('0' + (m % 10));
+        m /= 10;
+    } while (m != 0);
+
+    for (size_t i = 0; i < n; i++) {
+        out[i] = rev[n - 1 - i];
+    }
+    for (size_t i = 0; i < zeros; i++) {
+        out[n + i] = '0';
+    }
+    return n + zeros;
+}
+
+// Writes m * 10^e in plain or scientific notation, returning the length
+static size_t _lin_decimal_emit(char *out, uint64_t m, int e) {
+    char digits[20];
+    size_t const n = _lin_decimal_digits(digits, m, 0);
+    int const lead = (int)n - 1 + e;
+    size_t len = 0;
+
+    if (lead < -5 || lead > 15) {
+        out[len++] = digits[0];
+        if (n > 1) {
+            out[len++] = '.';
+            memcpy(&out[len], &digits[1], n - 1);
+            len += n - 1;
+        }
+        return len + (size_t)sprintf(&out[len], "e%d", lead);
+    }
+
+    if (e >= 0) {
+        return _lin_decimal_digits(out, m, (size_t)e);
+    }
+
+    size_t const frac = (size_t)-e;
+    if (n > frac) {
+        memcpy(out, digits, n - frac);
+        len = n - frac;
+        out[len++] = '.';
+        memcpy(&out[len], &digits[n - frac], frac);
+        return len + frac;
+    }
+
+    out[len++] = '0';
+    out[len++] = '.';
+    for (size_t i = n; i < frac; i++) {
+        out[len++] = '0';
+    }
+    memcpy(&out[len], digits, n);
+    return len + n;
+}
+
+// Rounds positive `a`, whose leading digit is at 10^lead, to `p` significant
+// digits m * 10^e. Returns false unless that reads back as exactly `a`.
+static bool _lin_decimal_candidate(double a, int lead, int p, uint64_t *m,
+                                   int *e) {
+    int const k = p - 1 - lead;
+    if (k < -22 || k > 22) {
+        return false;
+    }
+
+    double const scaled = k < 0 ? a / _lin_pow10[-k] : a * _lin_pow10[k];
+    *m = (uint64_t)(scaled + 0.5);
+    *e = -k;
+    lin_decimal_t back;
+    return _lin_decimal_exact(*m, *e, false, &back) && back == (lin_decimal_t)a;
+}
+
+// Writes the shortest text that parses back to exactly `v` into `out`, which
+// must hold _LIN_DECIMAL_TOKEN bytes. Returns the length, without a NUL.
+static size_t _lin_decimal_format(lin_decimal_t v, char *out) {
+    double const x = (double)v;
+    size_t len = 0;
+    if (signbit(x)) {
+        out[len++] = '-';
+    }
+
+    double const a = fabs(x);
+    if (isnan(x) || isinf(x)) {
+        memcpy(&out[len], isnan(x) ? "nan" : "inf", 3);
+        return len + 3;
+    }
+    if (a == 0) {
+        out[len++] = '0';
+        return len;
+    }
+
+    // find the fewest digits that round trip, by bisection since anything
+    // that round trips with p digits also does with p + 1. Only magnitudes
+    // where _lin_decimal_exact can check every candidate are handled here.
+    double const lead_exp = floor(log10(a));
+    int const lead = (int)lead_exp;
+    int lo = 1, hi = (int)_LIN_DECIMAL_DIG < 15 ? (int)_LIN_DECIMAL_DIG : 15;
+    uint64_t m;
+    int e;
+    if (lead <= 22 && hi - 1 - lead <= 22
+        && _lin_decimal_candidate(a, lead, hi, &m, &e)) {
+        while (lo < hi) {
+            int const mid = (lo + hi) / 2;
+            uint64_t m_mid;
+            int e_mid;
+            if (_lin_decimal_candidate(a, lead, mid, &m_mid, &e_mid)) {
+                hi = mid;
+                m = m_mid;
+                e = e_mid;
+            } else {
+                lo = mid + 1;
+            }
+        }
+
+        while (m != 0 && m % 10 == 0) {
+            m /= 10;
+            e++;
+        }
+        return len + _lin_decimal_emit(&out[len], m, e);
+    }
+
+    // magnitudes beyond the exact range and doubles needing 16 or more digits
+    for (int p = 1;; p++) {
+        int const n = snprintf(&out[len], _LIN_DECIMAL_TOKEN - len, "%.*g", p, a);
+        lin_decimal_t back;
+        if (p >= (int)_LIN_DECIMAL_DIG
+            || (_lin_decimal_parse(&out[len], &out[len + (size_t)n], &back) != NULL
+                && back == (lin_decimal_t)a)) {
+            return len + (size_t)n;
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// POOL DECLARATION
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// A matrix or vector lives in a single block holding its header followed by
+// its elements, aligned to LIN_ALIGNMENT bytes. The default keeps the
+// alignment `malloc` already provides; define LIN_ALIGNMENT as 32 or 64
+// for cache-line aligned elements at the cost of slower allocation.
+//
+// An optional process-wide pool recycles the blocks of freed matrices and
+// vectors. Blocks are kept in free lists by power-of-two size class and
+// handed back out by `lin_mat_create` / `lin_vec_create`, so a long-running
+// program reaches a stable footprint and stops calling the allocator.
+
+#ifndef LIN_ALIGNMENT
+#define LIN_ALIGNMENT _Alignof(max_align_t)
+#endif
+
+#ifndef LIN_POOL_CLASSES
+#define LIN_POOL_CLASSES 48
+#endif
+
+void lin_pool_enable(size_t max_bytes);
+void lin_pool_disable(void);
+size_t lin_pool_bytes(void);
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// POOL IMPLEMENTATION
+//
+///////////////////////////////////////////////////////////////////////////////
+
+typedef struct _lin_pool_node {
+    struct _lin_pool_node *next;
+} _lin_pool_node_t;
+
+typedef struct {
+    bool enabled;
+    size_t max_bytes, bytes;
+    _lin_pool_node_t *classes[LIN_POOL_CLASSES];
+} _lin_pool_t;
+
+static _lin_pool_t _lin_pool = {false, 0, 0, {NULL}};
+
+#ifndef LIN_NO_THREADS
+static pthread_mutex_t _lin_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+#define _LIN_POOL_LOCK() pthread_mutex_lock(&_lin_pool_lock)
+#define _LIN_POOL_UNLOCK() pthread_mutex_unlock(&_lin_pool_lock)
+#else
+#define _LIN_POOL_LOCK() ((void)0)
+#define _LIN_POOL_UNLOCK() ((void)0)
+#endif
+
+/// Where `max_bytes` bounds the memory kept by the pool for reuse
+void lin_pool_enable(size_t max_bytes) {
+    _LIN_POOL_LOCK();
+    _lin_pool.enabled = true;
+    _lin_pool.max_bytes = max_bytes;
+    _LIN_POOL_UNLOCK();
+}
+
+/// Stops pooling and frees all memory held by the pool
+void lin_pool_disable(void) {
+    _LIN_POOL_LOCK();
+    for (size_t c = 0; c < LIN_POOL_CLASSES; c++) {
+        while (_lin_pool.classes[c] != NULL) {
+            _lin_pool_node_t *next = _lin_pool.classes[c]->next;
+            free(_lin_pool.classes[c]);
+            _lin_pool.classes[c] = next;
+        }
+    }
+    _lin_pool.enabled = false;
+    _lin_pool.bytes = 0;
+    _LIN_POOL_UNLOCK();
+}
+
+/// Number of bytes currently held by the pool for reuse
+size_t lin_pool_bytes(void) {
+    _LIN_POOL_LOCK();
+    size_t const bytes = _lin_pool.bytes;
+    _LIN_POOL_UNLOCK();
+    return bytes;
+}
+
+// Sets `bytes` to the size of a `header` followed by `rows * columns`
+// elements, or returns false if that does not fit in a size_t
+static bool _lin_alloc_bytes(size_t header, size_t rows, size_t columns,
+                             size_t *bytes) {
+    size_t count;
+    return !__builtin_mul_overflow(rows, columns, &count)
+        && !__builtin_mul_overflow(count, sizeof(lin_decimal_t), bytes)
+        && !__builtin_add_overflow(*bytes, header, bytes);
+}
+
+// Allocates an aligned block of at least `bytes`, storing its actual size
+static void *_lin_pool_alloc(size_t bytes, size_t *block_bytes) {
+    if (bytes > SIZE_MAX - (size_t)LIN_ALIGNMENT) {
+        return NULL;
+    }
+
+    size_t cls = 0;
+    while (cls < LIN_POOL_CLASSES && ((size_t)LIN_ALIGNMENT << cls) < bytes) {
+        cls++;
+    }
+
+    _LIN_POOL_LOCK();
+    bool const pooled = _lin_pool.enabled && cls < LIN_POOL_CLASSES;
+    if (pooled && _lin_pool.classes[cls] != NULL) {
+        _lin_pool_node_t *node = _lin_pool.classes[cls];
+        _lin_pool.classes[cls] = node->next;
+        _lin_pool.bytes -= (size_t)LIN_ALIGNMENT << cls;
+        _LIN_POOL_UNLOCK();
+        *block_bytes = (size_t)LIN_ALIGNMENT << cls;
+        return node;
+    }
+    _LIN_POOL_UNLOCK();
+
+    // round up to the size class while pooling so the block returns to the
+    // same class later, otherwise just to a multiple of the alignment
+    *block_bytes = pooled ? (size_t)LIN_ALIGNMENT << cls
+        : ((bytes + LIN_ALIGNMENT - 1) / LIN_ALIGNMENT) * LIN_ALIGNMENT;
+    // plain malloc is cheaper when it already guarantees the alignment
+    if (LIN_ALIGNMENT <= _Alignof(max_align_t)) {
+        return malloc(*block_bytes);
+    }
+    return aligned_alloc(LIN_ALIGNMENT, *block_bytes);
+}
+
+// Returns a block of `block_bytes` to the pool, or frees it
+static void _lin_pool_free(void *block, size_t block_bytes) {
+    if (block == NULL) {
+        return;
+    }
+
+    // largest class the block is big enough for
+    size_t cls = 0;
+    while (cls + 1 < LIN_POOL_CLASSES
+           && ((size_t)LIN_ALIGNMENT << (cls + 1)) <= block_bytes) {
+        cls++;
+    }
+    size_t const bytes = (size_t)LIN_ALIGNMENT << cls;
+
+    _LIN_POOL_LOCK();
+    if (_lin_pool.enabled && block_bytes >= bytes
+        && _lin_pool.bytes + bytes <= _lin_pool.max_bytes) {
+        _lin_pool_node_t *node = (_lin_pool_node_t *)block;
+        node->next = _lin_pool.classes[cls];
+        _lin_pool.classes[cls] = node;
+        _lin_pool.bytes += bytes;
+        _LIN_POOL_UNLOCK();
+        return;
+    }
+    _LIN_POOL_UNLOCK();
+
+    free(block);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// VECTOR DECLARATION
+//
+///////////////////////////////////////////////////////////////////////////////
+
+typedef enum {
+    DEGREES,
+    RADIANS,
+} AngleType;
+
+// Who releases an external buffer wrapped by `lin_vec_wrap` / `lin_mat_wrap`
+typedef enum {
+    LIN_BORROW,     // the caller, after the last reference is freed
+    LIN_ADOPT,      // the library, with `free` when the last reference is freed
+} lin_ownership_t;
+
+// `elements` normally points at `data`, the storage allocated together with
+// the header, which has room for `capacity` elements. A vector can also
+// reference an external buffer instead, see `lin_vec_wrap`. `refs` counts the
+// holders that will call `lin_vec_free`.
+typedef struct {
+    size_t dim;
+    lin_decimal_t *elements;
+    size_t capacity;
+    lin_ownership_t ownership;
+    size_t refs;
+    _Alignas(LIN_ALIGNMENT) lin_decimal_t data[];
+} lin_vec_t;
+
+lin_vec_t *lin_vec_create(size_t dim);
+lin_vec_t *lin_vec_create_from_array(size_t dim, lin_decimal_t const *elements);
+lin_vec_t *lin_vec_wrap(size_t dim, lin_decimal_t *elements, lin_ownership_t ownership);
+lin_vec_t *lin_vec_retain(lin_vec_t *v);
+lin_vec_t *lin_vec_scalar_mult(lin_vec_t const *v, lin_decimal_t k);
+lin_vec_t *lin_vec_add(lin_vec_t const *a, lin_vec_t const *b);
+lin_vec_t *lin_vec_sub(lin_vec_t const *a, lin_vec_t const *b);
+lin_decimal_t lin_vec_dot(lin_vec_t const *a, lin_vec_t const *b);
+lin_decimal_t lin_vec_len(lin_vec_t const *v);
+lin_decimal_t lin_vec_angle(lin_vec_t const *a, lin_vec_t const *b, 
+                            AngleType angle_type);
+lin_vec_t *lin_vec_cross(lin_vec_t const *a, lin_vec_t const *b);
+lin_vec_t *lin_vec_map(lin_vec_t const *v, lin_decimal_t (*fn)(lin_decimal_t));
+void lin_vec_free(lin_vec_t *v);
+void _lin_vec_print(lin_vec_t const *v);
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// VECTOR IMPLEMENTATION
+//
+///////////////////////////////////////////////////////////////////////////////
+
+lin_vec_t *lin_vec_create(size_t const dim) {
+    _LIN_TRACE(_LIN_DIMS(dim, 1), _LIN_NO_DIMS);
+    size_t bytes, block_bytes;
+    lin_vec_t *vec = _lin_alloc_bytes(sizeof(lin_vec_t), dim, 1, &bytes)
+        ? (lin_vec_t *)_lin_pool_alloc(bytes, &block_bytes) : NULL;
+    if (vec == NULL) {
+        LIN_LOG_ERROR("Failed to allocate memory for lin_vec_t of %zu elements",
+                      dim);
+        return NULL;
+    }
+
+    vec->elements = vec->data;
+    vec->capacity = (block_bytes - sizeof(lin_vec_t)) / sizeof(lin_decimal_t);
+    vec->ownership = LIN_BORROW;
+    vec->refs = 1;
+
+    vec->dim = dim;
+    return vec;
+}
+
+lin_vec_t *lin_vec_create_from_array(size_t const dim, lin_decimal_t const *elements) {
+    _LIN_TRACE(_LIN_DIMS(dim, 1), _LIN_NO_DIMS);
+    lin_vec_t *vec = lin_vec_create(dim);
+    if (vec == NULL) {
+        return NULL;
+    }
+
+    memcpy(vec->elements, elements, dim * sizeof(lin_decimal_t));
+    return vec;
+}
+
+/// Vector over the caller's `elements` without copying them. With LIN_ADOPT
+/// the buffer must come from `malloc` and is freed along with the vector; if
+/// NULL is returned it stays with the caller either way.
+lin_vec_t *lin_vec_wrap(size_t dim, lin_decimal_t *elements, lin_ownership_t ownership) {
+    _LIN_TRACE(_LIN_DIMS(dim, 1), _LIN_NO_DIMS);
+    size_t block_bytes;
+    lin_vec_t *vec = (lin_vec_t *)_lin_pool_alloc(sizeof(lin_vec_t), &block_bytes);
+    if (vec == NULL) {
+        LIN_LOG_ERROR("Failed to allocate memory for lin_vec_t");
+        return NULL;
+    }
+
+    vec->dim = dim;
+    vec->elements = elements;
+    vec->capacity = (block_bytes - sizeof(lin_vec_t)) / sizeof(lin_decimal_t);
+    vec->ownership = ownership;
+    vec->refs = 1;
+    return vec;
+}
+
+/// Adds a reference to `v`, to be dropped with its own `lin_vec_free`
+lin_vec_t *lin_vec_retain(lin_vec_t *v) {
+    __atomic_add_fetch(&v->refs, 1, __ATOMIC_RELAXED);
+    return v;
+}
+
+lin_vec_t *lin_vec_scalar_mult(lin_vec_t const *v, lin_decimal_t k) {
+    _LIN_TRACE(_LIN_VEC_DIMS(v), _LIN_NO_DIMS);
+    lin_vec_t *res = lin_vec_create(v->dim);
+    for (size_t i = 0; i < v->dim; i++) {
+        res->elements[i] = v->elements[i] * k;
+    }
+
+    return res;
+}
+
+lin_vec_t *lin_vec_add(lin_vec_t const *a, lin_vec_t const *b) {
+    _LIN_TRACE(_LIN_VEC_DIMS(a), _LIN_VEC_DIMS(b));
+    if (a->dim != b->dim) {
+        LIN_LOG_ERROR("Length mistmatch during vector addition (%zu and %zu)",
+                      a->dim, b->dim);
+        exit(EXIT_FAILURE);
+    }
+
+    lin_vec_t *res = lin_vec_create(a->dim);
+    for (size_t i = 0; i < a->dim; i++) {
+        res->elements[i] = a->elements[i] + b->elements[i];
+    }
+
+    return res;
+}
+
+lin_vec_t *lin_vec_sub(lin_vec_t const *a, lin_vec_t const *b) {
+    _LIN_TRACE(_LIN_VEC_DIMS(a), _LIN_VEC_DIMS(b));
+    if (a->dim != b->dim) {
+        LIN_LOG_ERROR(
+            "Length mistmatch during vector subtraction (%zu and %zu)",
+            a->dim, b->dim
+        );
+        exit(EXIT_FAILURE);
+    }
+
+    lin_vec_t *res = lin_vec_create(a->dim);
+    for (size_t i = 0; i < a->dim; i++) {
+        res->elements[i] = a->elements[i] - b->elements[i];
+    }
+
+    return res;
+}
+
+lin_decimal_t lin_vec_dot(lin_vec_t const *a, lin_vec_t const *b) {
+    _LIN_TRACE(_LIN_VEC_DIMS(a), _LIN_VEC_DIMS(b));
+    if (a->dim != b->dim) {
+        LIN_LOG_ERROR(
+            "Length mistmatch while taking dot product (%zu and %zu)",
+            a->dim, b->dim
+        );
+        exit(EXIT_FAILURE);
+    }
+
+    return _lin_dot(a->elements, b->elements, a->dim);
+}
+
+lin_decimal_t lin_vec_len(lin_vec_t const *v) {
+    _LIN_TRACE(_LIN_VEC_DIMS(v), _LIN_NO_DIMS);
+    lin_decimal_t sum = 0;
+
+    for (size_t i = 0; i < v->dim; i++) {
+        sum += v->elements[i] * v->elements[i];
+    }
+
+    return (lin_decimal_t)sqrt((double)sum);
+}
+
+lin_decimal_t lin_vec_angle(lin_vec_t const *a, lin_vec_t const *b, AngleType angle_type) {
+    _LIN_TRACE(_LIN_VEC_DIMS(a), _LIN_VEC_DIMS(b));
+    if (a->dim != b->dim) {
+        LIN_LOG_ERROR(
+            "Length mistmatch while taking dot product (%zu and %zu)",
+            a->dim, b->dim
+        );
+        exit(EXIT_FAILURE);
+    }
+
+    lin_decimal_t rads = (lin_decimal_t)acos(
+        (double)(lin_vec_dot(a, b) /
+        (lin_vec_len(a) * lin_vec_len(b)))
+    );
+
+    if (angle_type == DEGREES) {
+        return (lin_decimal_t)(rads * (180.0 / M_PI));
+    }
+
+    return rads;
+}
+
+lin_vec_t *lin_vec_cross(lin_vec_t const *a, lin_vec_t const *b) {
+    _LIN_TRACE(_LIN_VEC_DIMS(a), _LIN_VEC_DIMS(b));
+    if (a->dim != b->dim) {
+        LIN_LOG_ERROR(
+            "Length mistmatch while taking cross product (%zu and %zu)",
+            a->dim, b->dim
+        );
+        exit(EXIT_FAILURE);
+    }
+
+    if (a->dim != 3) {
+        LIN_LOG_ERROR(
+            "Cross product is not defined for vectors of %zu dimensions",
+            a->dim
+        );
+        exit(EXIT_FAILURE);
+    }
+
+    lin_decimal_t res_elements[3] = {
+        a->elements[1] * b->elements[2] - a->elements[2] * b->elements[1],
+        a->elements[2] * b->elements[0] - a->elements[0] * b->elements[2],
+        a->elements[0] * b->elements[1] - a->elements[1] * b->elements[0],
+    };
+
+    return lin_vec_create_from_array(3, res_elements);
+}
+
+lin_vec_t *lin_vec_map(lin_vec_t const *v, lin_decimal_t (*fn)(lin_decimal_t)) {
+    _LIN_TRACE(_LIN_VEC_DIMS(v), _LIN_NO_DIMS);
+    lin_vec_t *res = lin_vec_create(v->dim);
+    for (size_t i = 0; i < v->dim; i++) {
+        res->elements[i] = fn(v->elements[i]);
+    }
+
+    return res;
+}
+
+/// Drops a reference to `v`, releasing it with the last one
+void lin_vec_free(lin_vec_t *v) {
+    _LIN_TRACE(_LIN_NO_DIMS, _LIN_NO_DIMS);
+    if (v == NULL || __atomic_sub_fetch(&v->refs, 1, __ATOMIC_ACQ_REL) != 0) {
+        return;
+    }
+
+    if (v->ownership == LIN_ADOPT) {
+        free(v->elements);
+    }
+    _lin_pool_free(v, sizeof(lin_vec_t) + (v->capacity * sizeof(lin_decimal_t)));
+}
+
+void _lin_vec_print(lin_vec_t const *v) {
+    char buf[_LIN_DECIMAL_TOKEN + 1];
+    fputs("[ ", stdout);
+    for (size_t i = 0; i < v->dim; i++) {
+        size_t const len = _lin_decimal_format(v->elements[i], buf);
+        buf[len] = ' ';
+        fwrite(buf, 1, len + 1, stdout);
+    }
+    fputs("]\n", stdout);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// VEC3 ARRAY DECLARATION
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Structure-of-arrays storage for many 3-dimensional vectors. The x, y and z
+// streams each hold `len` elements; `lin_vec3_array_create` places them in a
+// single allocation owned by `x`.
+typedef struct {
+    size_t len;
+    lin_decimal_t *x, *y, *z;
+} lin_vec3_array_t;
+
+lin_vec3_array_t *lin_vec3_array_create(size_t len);
+lin_vec3_array_t *lin_vec3_array_create_from_xyz(size_t len, lin_decimal_t const *xyz);
+void lin_vec3_array_to_xyz(lin_vec3_array_t const *a, lin_decimal_t *xyz);
+lin_vec_t *lin_vec3_array_dot(lin_vec3_array_t const *a, lin_vec3_array_t const *b);
+lin_vec3_array_t *lin_vec3_array_cross(lin_vec3_array_t const *a, lin_vec3_array_t const *b);
+lin_vec_t *lin_vec3_array_len(lin_vec3_array_t const *a);
+lin_vec3_array_t *lin_vec3_array_normalize(lin_vec3_array_t const *a);
+lin_vec3_array_t *lin_vec3_array_add(lin_vec3_array_t const *a, lin_vec3_array_t const *b);
+lin_vec3_array_t *lin_vec3_array_scalar_mult(lin_vec3_array_t const *a, lin_decimal_t k);
+void lin_vec3_array_free(lin_vec3_array_t *a);
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// VEC3 ARRAY IMPLEMENTATION
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// The loops below stick to one independent operation per stream element so
+// that compilers can vectorize them across points.
+
+lin_vec3_array_t *lin_vec3_array_create(size_t len) {
+    _LIN_TRACE(_LIN_DIMS(len, 3), _LIN_NO_DIMS);
+    lin_vec3_array_t *arr = (lin_vec3_array_t *)malloc(sizeof(lin_vec3_array_t));
+    if (arr == NULL) {
+        LIN_LOG_ERROR("Failed to allocate memory for lin_vec3_array_t");
+        return NULL;
+    }
+
+    size_t bytes;
+    arr->x = _lin_alloc_bytes(0, 3, len, &bytes)
+        ? (lin_decimal_t *)malloc(bytes) : NULL;
+    if (arr->x == NULL) {
+        LIN_LOG_ERROR("Failed to allocate memory for %zu 3-vectors", len);
+        free(arr);
+        return NULL;
+    }
+
+    arr->len = len;
+    arr->y = &arr->x[len];
+    arr->z = &arr->y[len];
+    return arr;
+}
+
+/// Where `xyz` holds `len` interleaved points x0 y0 z0 x1 y1 z1 ...
+lin_vec3_array_t *lin_vec3_array_create_from_xyz(size_t len, lin_decimal_t const *xyz) {
+    _LIN_TRACE(_LIN_DIMS(len, 3), _LIN_NO_DIMS);
+    lin_vec3_array_t *arr = lin_vec3_array_create(len);
+    if (arr == NULL) {
+        return NULL;
+    }
+
+    lin_decimal_t *restrict x = arr->x;
+    lin_decimal_t *restrict y = arr->y;
+    lin_decimal_t *restrict z = arr->z;
+    for (size_t i = 0; i < len; i++) {
+        x[i] = xyz[(3 * i) + 0];
+        y[i] = xyz[(3 * i) + 1];
+        z[i] = xyz[(3 * i) + 2];
+    }
+
+    return arr;
+}
+
+/// Where `xyz` has room for `3 * a->len` elements
+void lin_vec3_array_to_xyz(lin_vec3_array_t const *a, lin_decimal_t *xyz) {
+    _LIN_TRACE(_LIN_VEC3_DIMS(a), _LIN_NO_DIMS);
+    lin_decimal_t const *restrict x = a->x;
+    lin_decimal_t const *restrict y = a->y;
+    lin_decimal_t const *restrict z = a->z;
+    for (size_t i = 0; i < a->len; i++) {
+        xyz[(3 * i) + 0] = x[i];
+        xyz[(3 * i) + 1] = y[i];
+        xyz[(3 * i) + 2] = z[i];
+    }
+}
+
+lin_vec_t *lin_vec3_array_dot(lin_vec3_array_t const *a, lin_vec3_array_t const *b) {
+    _LIN_TRACE(_LIN_VEC3_DIMS(a), _LIN_VEC3_DIMS(b));
+    if (a->len != b->len) {
+        LIN_LOG_ERROR(
+            "Length mistmatch while taking batch dot product (%zu and %zu)",
+            a->len, b->len
+        );
+        exit(EXIT_FAILURE);
+    }
+
+    lin_vec_t *res = lin_vec_create(a->len);
+    if (res == NULL) {
+        return NULL;
+    }
+
+    lin_decimal_t *restrict out = res->elements;
+    for (size_t i = 0; i < a->len; i++) {
+        out[i] = (a->x[i] * b->x[i]) + (a->y[i] * b->y[i]) + (a->z[i] * b->z[i]);
+    }
+
+    return res;
+}
+
+lin_vec3_array_t *lin_vec3_array_cross(lin_vec3_array_t const *a, lin_vec3_array_t const *b) {
+    _LIN_TRACE(_LIN_VEC3_DIMS(a), _LIN_VEC3_DIMS(b));
+    if (a->len != b->len) {
+        LIN_LOG_ERROR(
+            "Length mistmatch while taking batch cross product (%zu and %zu)",
+            a->len, b->len
+        );
+        exit(EXIT_FAILURE);
+    }
+
+    lin_vec3_array_t *res = lin_vec3_array_create(a->len);
+    if (res == NULL) {
+        return NULL;
+    }
+
+    lin_decimal_t *restrict x = res->x;
+    lin_decimal_t *restrict y = res->y;
+    lin_decimal_t *restrict z = res->z;
+    for (size_t i = 0; i < a->len; i++) {
+        x[i] = (a->y[i] * b->z[i]) - (a->z[i] * b->y[i]);
+        y[i] = (a->z[i] * b->x[i]) - (a->x[i] * b->z[i]);
+        z[i] = (a->x[i] * b->y[i]) - (a->y[i] * b->x[i]);
+    }
+
+    return res;
+}
+
+lin_vec_t *lin_vec3_array_len(lin_vec3_array_t const *a) {
+    _LIN_TRACE(_LIN_VEC3_DIMS(a), _LIN_NO_DIMS);
+    lin_vec_t *res = lin_vec3_array_dot(a, a);
+    if (res == NULL) {
+        return NULL;
+    }
+
+    lin_decimal_t *restrict out = res->elements;
+    for (size_t i = 0; i < a->len; i++) {
+        out[i] = (lin_decimal_t)sqrt((double)out[i]);
+    }
+
+    return res;
+}
+
+/// Zero-length vectors are left as zero
+lin_vec3_array_t *lin_vec3_array_normalize(lin_vec3_array_t const *a) {
+    _LIN_TRACE(_LIN_VEC3_DIMS(a), _LIN_NO_DIMS);
+    lin_vec3_array_t *res = lin_vec3_array_create(a->len);
+    if (res == NULL) {
+        return NULL;
+    }
+
+    lin_decimal_t *restrict x = res->x;
+    lin_decimal_t *restrict y = res->y;
+    lin_decimal_t *restrict z = res->z;
+    for (size_t i = 0; i < a->len; i++) {
+        lin_decimal_t const len_sq = (a->x[i] * a->x[i]) +
+            (a->y[i] * a->y[i]) + (a->z[i] * a->z[i]);
+        lin_decimal_t const inv = len_sq > (lin_decimal_t)0
+            ? (lin_decimal_t)(1.0 / sqrt((double)len_sq)) : (lin_decimal_t)0;
+        x[i] = a->x[i] * inv;
+        y[i] = a->y[i] * inv;
+        z[i] = a->z[i] * inv;
+    }
+
+    return res;
+}
+
+lin_vec3_array_t *lin_vec3_array_add(lin_vec3_array_t const *a, lin_vec3_array_t const *b) {
+    _LIN_TRACE(_LIN_VEC3_DIMS(a), _LIN_VEC3_DIMS(b));
+    if (a->len != b->len) {
+        LIN_LOG_ERROR(
+            "Length mistmatch during batch vector addition (%zu and %zu)",
+            a->len, b->len
+        );
+        exit(EXIT_FAILURE);
+    }
+
+    lin_vec3_array_t *res = lin_vec3_array_create(a->len);
+    if (res == NULL) {
+        return NULL;
+    }
+
+    lin_decimal_t *restrict x = res->x;
+    lin_decimal_t *restrict y = res->y;
+    lin_decimal_t *restrict z = res->z;
+    for (size_t i = 0; i < a->len; i++) {
+        x[i] = a->x[i] + b->x[i];
+        y[i] = a->y[i] + b->y[i];
+        z[i] = a->z[i] + b->z[i];
+    }
+
+    return res;
+}
+
+lin_vec3_array_t *lin_vec3_array_scalar_mult(lin_vec3_array_t const *a, lin_decimal_t k) {
+    _LIN_TRACE(_LIN_VEC3_DIMS(a), _LIN_NO_DIMS);
+    lin_vec3_array_t *res = lin_vec3_array_create(a->len);
+    if (res == NULL) {
+        return NULL;
+    }
+
+    lin_decimal_t *restrict x = res->x;
+    lin_decimal_t *restrict y = res->y;
+    lin_decimal_t *restrict z = res->z;
+    for (size_t i = 0; i < a->len; i++) {
+        x[i] = a->x[i] * k;
+        y[i] = a->y[i] * k;
+        z[i] = a->z[i] * k;
+    }
+
+    return res;
+}
+
+void lin_vec3_array_free(lin_vec3_array_t *a) {
+    _LIN_TRACE(_LIN_NO_DIMS, _LIN_NO_DIMS);
+    if (a == NULL) {
+        return;
+    }
+
+    free(a->x);
+    free(a);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// MATRIX DECLARATION
+//
+///////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+    size_t rows, columns;
+} lin_mat_shape_t;
+
+// Memoized derived quantities of a matrix, see `lin_mat_cache_enable`
+struct lin_mat_cache;
+
+// Order of the elements in storage. Matrices are created row-major, a column-
+// major [r x c] matrix stores the elements of its [c x r] transpose row by row.
+typedef enum {
+    LIN_ROW_MAJOR,
+    LIN_COL_MAJOR,
+} lin_layout_t;
+
+// As with `lin_vec_t`, `elements` normally points at the `capacity` elements
+// of `data` allocated together with the header, or at a buffer wrapped by
+// `lin_mat_wrap`.
+typedef struct {
+    lin_mat_shape_t shape;
+    lin_layout_t layout;
+    lin_decimal_t *elements;
+    size_t capacity;
+    lin_ownership_t ownership;
+    size_t refs;
+    struct lin_mat_cache *cache;
+    _Alignas(LIN_ALIGNMENT) lin_decimal_t data[];
+} lin_mat_t;
+
+lin_mat_t *lin_mat_create(lin_mat_shape_t shape);
+lin_mat_t *lin_mat_create_from_array(lin_mat_shape_t shape, lin_decimal_t const *elements);
+lin_mat_t *lin_mat_wrap(lin_mat_shape_t shape, lin_decimal_t *elements, lin_ownership_t ownership);
+lin_mat_t *lin_mat_retain(lin_mat_t *mat);
+lin_mat_t *lin_mat_mult(lin_mat_t const *a, lin_mat_t const *b);
+lin_vec_t *lin_mat_vec_mult(lin_mat_t const *a, lin_vec_t const *x);
+lin_vec_t *lin_mat_vec_mult_transposed(lin_mat_t const *a, lin_vec_t const *x);
+lin_mat_t *lin_mat_add(lin_mat_t const *a, lin_mat_t const *b);
+lin_mat_t *lin_mat_sub(lin_mat_t const *a, lin_mat_t const *b);
+lin_mat_t *lin_mat_scalar_mult(lin_mat_t const *mat, lin_decimal_t k);
+lin_mat_t *lin_mat_transpose(lin_mat_t const *mat);
+void lin_mat_transpose_in_place(lin_mat_t *mat);
+bool lin_mat_set_layout(lin_mat_t *mat, lin_layout_t layout);
+lin_decimal_t lin_mat_get(lin_mat_t const *mat, size_t row, size_t column);
+void lin_mat_set(lin_mat_t *mat, size_t row, size_t column, lin_decimal_t value);
+lin_decimal_t lin_mat_det(lin_mat_t const *mat);
+lin_mat_t *lin_mat_identity(size_t n);
+lin_mat_t *lin_mat_row(lin_mat_t const *mat, size_t n);
+lin_mat_t *lin_mat_col(lin_mat_t const *mat, size_t n);
+lin_vec_t *lin_mat_row_vec(lin_mat_t const *mat, size_t n);
+lin_vec_t *lin_mat_col_vec(lin_mat_t const *mat, size_t n);
+lin_decimal_t lin_mat_minor_of_element(lin_mat_t const *a, size_t row, size_t col);
+lin_mat_t *lin_mat_minor(lin_mat_t const *a);
+lin_decimal_t lin_mat_cofactor_of_element(lin_mat_t const *a, size_t row, size_t col);
+lin_mat_t *lin_mat_cofactor(lin_mat_t const *a);
+lin_mat_t *lin_mat_adj(lin_mat_t const *a);
+lin_mat_t *lin_mat_inv(lin_mat_t const *a);
+lin_mat_t *lin_mat_map(lin_mat_t *mat, lin_decimal_t (*fn)(lin_decimal_t));
+lin_mat_t *lin_mat_pow(lin_mat_t const *a, size_t k);
+void lin_mat_pow_into(lin_mat_t const *a, size_t k, lin_mat_t *res, lin_mat_t *work);
+void lin_mat_transform_points(lin_mat_t const *m, lin_decimal_t const *src,
+                              lin_decimal_t *dst, size_t n);
+void lin_mat_transform_vec3_array(lin_mat_t const *m, lin_vec3_array_t const *src,
+                                  lin_vec3_array_t *dst);
+void lin_mat_free(lin_mat_t *mat);
+void lin_mat_cache_enable(lin_mat_t *mat);
+void lin_mat_cache_disable(lin_mat_t *mat);
+void lin_mat_touch(lin_mat_t *mat);
+lin_decimal_t lin_mat_cached_det(lin_mat_t const *mat);
+lin_mat_t const *lin_mat_cached_inv(lin_mat_t const *mat);
+lin_mat_t const *lin_mat_cached_transpose(lin_mat_t const *mat);
+void _lin_mat_print(lin_mat_t const *a);
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// MATRIX IMPLEMENTATION
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Elementwise operations split the flat element range [0, rows * columns)
+// into the same chunks as the first touch below, so each thread works on
+// pages local to it.
+static void _lin_mat_touch_range(void *ctx, size_t chunk, size_t begin,
+                                 size_t end) {
+    (void)chunk;
+    lin_decimal_t *elements = (lin_decimal_t *)ctx;
+    memset(&elements[begin], 0, (end - begin) * sizeof(lin_decimal_t));
+}
+
+typedef enum {
+    _LIN_EW_ADD,
+    _LIN_EW_SUB,
+    _LIN_EW_SCALAR_MULT,
+} _lin_ew_op_t;
+
+typedef struct {
+    _lin_ew_op_t op;
+    lin_decimal_t const *a, *b;
+    lin_decimal_t k;
+    lin_decimal_t *res;
+} _lin_ew_ctx_t;
+
+static void _lin_mat_ew_range(void *ctx, size_t chunk, size_t begin,
+                              size_t end) {
+    (void)chunk;
+    _lin_ew_ctx_t const *ew = (_lin_ew_ctx_t const *)ctx;
+    lin_decimal_t const *restrict a = ew->a;
+    lin_decimal_t const *restrict b = ew->b;
+    lin_decimal_t *restrict res = ew->res;
+
+    switch (ew->op) {
+    case _LIN_EW_ADD:
+        for (size_t i = begin; i < end; i++) {
+            res[i] = a[i] + b[i];
+        }
+        break;
+    case _LIN_EW_SUB:
+        for (size_t i = begin; i < end; i++) {
+            res[i] = a[i] - b[i];
+        }
+        break;
+    case _LIN_EW_SCALAR_MULT:
+        for (size_t i = begin; i < end; i++) {
+            res[i] = a[i] * ew->k;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+static inline size_t _lin_mat_index(lin_mat_t const *a, size_t row,
+                                    size_t column) {
+    return a->layout == LIN_ROW_MAJOR
+        ? (row * a->shape.columns) + column : (column * a->shape.rows) + row;
+}
+
+// Row stride of the storage of `a`
+static inline size_t _lin_mat_ld(lin_mat_t const *a) {
+    return a->layout == LIN_ROW_MAJOR ? a->shape.columns : a->shape.rows;
+}
+
+// Row-major header over the storage of `a`: `a` itself if it is row-major,
+// its transpose otherwise
+static inline void _lin_mat_storage(lin_mat_t const *a, lin_mat_t *s) {
+    s->shape = a->layout == LIN_COL_MAJOR
+        ? (lin_mat_shape_t){a->shape.columns, a->shape.rows} : a->shape;
+    s->layout = LIN_ROW_MAJOR;
+    s->elements = a->elements;
+    s->cache = NULL;
+    s->capacity = 0;
+    s->ownership = LIN_BORROW;
+    s->refs = 0;
+}
+
+static lin_mat_t *_lin_mat_transpose(lin_mat_t const *a);
+
+// Row-major copy of `a`
+static lin_mat_t *_lin_mat_dup(lin_mat_t const *a) {
+    if (a->layout == LIN_ROW_MAJOR) {
+        return lin_mat_create_from_array(a->shape, a->elements);
+    }
+
+    lin_mat_t s;
+    _lin_mat_storage(a, &s);
+    return _lin_mat_transpose(&s);
+}
+
+// `a` itself if it is row-major, otherwise a row-major copy that is also
+// stored in `copy` (NULL when no copy was made) to be freed by the caller.
+// Routines that only walk row-major storage take their operands through this.
+static lin_mat_t const *_lin_mat_rows(lin_mat_t const *a, lin_mat_t **copy) {
+    *copy = a->layout == LIN_ROW_MAJOR ? NULL : _lin_mat_dup(a);
+    return a->layout == LIN_ROW_MAJOR ? a : *copy;
+}
+
+lin_mat_t *lin_mat_create(lin_mat_shape_t shape) {
+    _LIN_TRACE(_LIN_SHAPE_DIMS(shape), _LIN_NO_DIMS);
+    size_t bytes, block_bytes;
+    lin_mat_t *mat = _lin_alloc_bytes(sizeof(lin_mat_t), shape.rows,
+                                      shape.columns, &bytes)
+        ? (lin_mat_t *)_lin_pool_alloc(bytes, &block_bytes) : NULL;
+
+    if (mat == NULL) {
+        LIN_LOG_ERROR(
+            "Failed to allocate memory for matrix of dimensions [%zu x %zu]", 
+            shape.rows, shape.columns
+        );
+        return NULL;
+    }
+
+    mat->shape = shape;
+    mat->layout = LIN_ROW_MAJOR;
+    mat->cache = NULL;
+    mat->elements = mat->data;
+    mat->capacity = (block_bytes - sizeof(lin_mat_t)) / sizeof(lin_decimal_t);
+    mat->ownership = LIN_BORROW;
+    mat->refs = 1;
+
+    if (_lin_first_touch) {
+        _lin_parallel_for(shape.rows * shape.columns, 1, _lin_mat_touch_range,
+                          mat->elements);
+    }
+
+    return mat;
+}
+
+lin_mat_t *lin_mat_create_from_array(lin_mat_shape_t shape, lin_decimal_t const *elements) {
+    _LIN_TRACE(_LIN_SHAPE_DIMS(shape), _LIN_NO_DIMS);
+    lin_mat_t *mat = lin_mat_create(shape);
+    if (mat == NULL) {
+        return NULL;
+    }
+
+    memcpy(mat->elements, elements,
+           shape.rows * shape.columns * sizeof(lin_decimal_t));
+    return mat;
+}
+
+/// Row-major matrix over the caller's `elements` without copying them, with
+/// the same ownership rules as `lin_vec_wrap`
+lin_mat_t *lin_mat_wrap(lin_mat_shape_t shape, lin_decimal_t *elements, lin_ownership_t ownership) {
+    _LIN_TRACE(_LIN_SHAPE_DIMS(shape), _LIN_NO_DIMS);
+    size_t block_bytes;
+    lin_mat_t *mat = (lin_mat_t *)_lin_pool_alloc(sizeof(lin_mat_t), &block_bytes);
+    if (mat == NULL) {
+        LIN_LOG_ERROR("Failed to allocate memory for lin_mat_t");
+        return NULL;
+    }
+
+    mat->shape = shape;
+    mat->layout = LIN_ROW_MAJOR;
+    mat->cache = NULL;
+    mat->elements = elements;
+    mat->capacity = (block_bytes - sizeof(lin_mat_t)) / sizeof(lin_decimal_t);
+    mat->ownership = ownership;
+    mat->refs = 1;
+    return mat;
+}
+
+/// Adds a reference to `mat`, to be dropped with its own `lin_mat_free`
+lin_mat_t *lin_mat_retain(lin_mat_t *mat) {
+    __atomic_add_fetch(&mat->refs, 1, __ATOMIC_RELAXED);
+    return mat;
+}
+
+lin_mat_t *lin_mat_mult(lin_mat_t const *a, lin_mat_t const *b) {
+    _LIN_TRACE(_LIN_MAT_DIMS(a), _LIN_MAT_DIMS(b));
+    if (a->shape.columns != b->shape.rows) {
+        LIN_LOG_ERROR("Dimension mismatch during matrix multiplication \
+                      [%zu x %zu] [%zu x %zu]",
+                      a->shape.rows, a->shape.columns,
+                      b->shape.rows, b->shape.columns);
+        exit(EXIT_FAILURE);
+    }
+
+    lin_mat_t *res = lin_mat_create((lin_mat_shape_t){
+        a->shape.rows, b->shape.columns
+    });
+    bool const a_t = a->layout == LIN_COL_MAJOR;
+    bool const b_t = b->layout == LIN_COL_MAJOR;
+    if (!a_t && !b_t
+        && _lin_small_mult(a->shape.rows, a->shape.columns, b->shape.columns,
+                           a->elements, b->elements, res->elements)) {
+        return res;
+    }
+
+    // a column-major operand is the transpose of its storage
+    _lin_gemm(a_t, b_t, a->shape.rows, b->shape.columns, a->shape.columns, 1,
+              a->elements, _lin_mat_ld(a), b->elements, _lin_mat_ld(b),
+              0, res->elements, res->shape.columns);
+
+    return res;
+}
+
+typedef struct {
+    lin_mat_t const *a;
+    lin_decimal_t const *x;
+    lin_decimal_t *y;
+} _lin_gemv_ctx_t;
+
+// y[begin:end] = A[begin:end, :] * x, one dot product per row
+static void _lin_gemv_rows(void *ctx, size_t chunk, size_t begin, size_t end) {
+    (void)chunk;
+    _lin_gemv_ctx_t const *g = (_lin_gemv_ctx_t const *)ctx;
+    size_t const n = g->a->shape.columns;
+    for (size_t i = begin; i < end; i++) {
+        g->y[i] = _lin_dot(&g->a->elements[i * n], g->x, n);
+    }
+}
+
+// y[begin:end] = A[:, begin:end]^T * x, as axpys over the rows of the strip
+static void _lin_gemv_t_cols(void *ctx, size_t chunk, size_t begin, size_t end) {
+    (void)chunk;
+    _lin_gemv_ctx_t const *g = (_lin_gemv_ctx_t const *)ctx;
+    size_t const n = g->a->shape.columns;
+    for (size_t j = begin; j < end; j++) {
+        g->y[j] = (lin_decimal_t)0;
+    }
+    for (size_t i = 0; i < g->a->shape.rows; i++) {
+        _lin_axpy(end - begin, g->x[i], &g->a->elements[(i * n) + begin],
+                  &g->y[begin]);
+    }
+}
+
+// Partial y for rows [begin, end) of a tall matrix, written to its own slice
+// of the `y` scratch buffer and summed afterwards
+static void _lin_gemv_t_rows(void *ctx, size_t chunk, size_t begin, size_t end) {
+    _lin_gemv_ctx_t const *g = (_lin_gemv_ctx_t const *)ctx;
+    size_t const n = g->a->shape.columns;
+    lin_decimal_t *y = &g->y[chunk * n];
+    for (size_t j = 0; j < n; j++) {
+        y[j] = (lin_decimal_t)0;
+    }
+    for (size_t i = begin; i < end; i++) {
+        _lin_axpy(n, g->x[i], &g->a->elements[i * n], y);
+    }
+}
+
+lin_vec_t *lin_mat_vec_mult(lin_mat_t const *a, lin_vec_t const *x) {
+    _LIN_TRACE(_LIN_MAT_DIMS(a), _LIN_VEC_DIMS(x));
+    if (a->shape.columns != x->dim) {
+        LIN_LOG_ERROR(
+            "Dimension mismatch during matrix-vector multiplication [%zu x %zu] (%zu)",
+            a->shape.rows, a->shape.columns, x->dim
+        );
+        exit(EXIT_FAILURE);
+    }
+
+    if (a->layout == LIN_COL_MAJOR) {
+        lin_mat_t s;
+        _lin_mat_storage(a, &s);
+        return lin_mat_vec_mult_transposed(&s, x);
+    }
+
+    lin_vec_t *res = lin_vec_create(a->shape.rows);
+    if (res == NULL) {
+        return NULL;
+    }
+
+    _lin_gemv_ctx_t ctx = {a, x->elements, res->elements};
+    _lin_parallel_for(a->shape.rows, a->shape.columns, _lin_gemv_rows, &ctx);
+
+    return res;
+}
+
+/// Computes a^T * x without materializing the transpose of `a`
+lin_vec_t *lin_mat_vec_mult_transposed(lin_mat_t const *a, lin_vec_t const *x) {
+    _LIN_TRACE(_LIN_MAT_DIMS(a), _LIN_VEC_DIMS(x));
+    if (a->shape.rows != x->dim) {
+        LIN_LOG_ERROR(
+            "Dimension mismatch during transposed matrix-vector multiplication [%zu x %zu] (%zu)",
+            a->shape.rows, a->shape.columns, x->dim
+        );
+        exit(EXIT_FAILURE);
+    }
+
+    if (a->layout == LIN_COL_MAJOR) {
+        lin_mat_t s;
+        _lin_mat_storage(a, &s);
+        return lin_mat_vec_mult(&s, x);
+    }
+
+    size_t const m = a->shape.rows;
+    size_t const n = a->shape.columns;
+    lin_vec_t *res = lin_vec_create(n);
+    if (res == NULL) {
+        return NULL;
+    }
+
+    // Wide enough: give each thread a strip of output columns. Otherwise
+    // split the rows and reduce per-thread partial results.
+    size_t const chunks = _lin_parallel_chunks(m, n);
+    if (chunks <= 1 || n >= chunks * 64) {
+        _lin_gemv_ctx_t ctx = {a, x->elements, res->elements};
+        _lin_parallel_run(n, chunks, _lin_gemv_t_cols, &ctx);
+        return res;
+    }
+
+    lin_decimal_t *partial = (lin_decimal_t *)malloc(
+        chunks * n * sizeof(lin_decimal_t)
+    );
+    if (partial == NULL) {
+        LIN_LOG_ERROR("Failed to allocate matrix-vector workspace");
+        lin_vec_free(res);
+        return NULL;
+    }
+
+    _lin_gemv_ctx_t ctx = {a, x->elements, partial};
+    _lin_parallel_run(m, chunks, _lin_gemv_t_rows, &ctx);
+
+    for (size_t j = 0; j < n; j++) {
+        res->elements[j] = partial[j];
+    }
+    for (size_t c = 1; c < chunks; c++) {
+        _lin_axpy(n, 1, &partial[c * n], res->elements);
+    }
+
+    free(partial);
+    return res;
+}
+
+lin_mat_t *lin_mat_add(lin_mat_t const *a, lin_mat_t const *b) {
+    _LIN_TRACE(_LIN_MAT_DIMS(a), _LIN_MAT_DIMS(b));
+    if (a->shape.rows != b->shape.rows
+        || a->shape.columns != b->shape.columns) {
+        LIN_LOG_ERROR(
+            "Dimension mismatch during matrix addition [%zu x %zu] [%zu x %zu]",
+            a->shape.rows, a->shape.columns, b->shape.rows, b->shape.columns
+        );
+        exit(EXIT_FAILURE);
+    }
+
+    if (a->layout != b->layout) {
+        lin_mat_t *a_rows_copy;
+        lin_mat_t const *a_rows = _lin_mat_rows(a, &a_rows_copy);
+        lin_mat_t *b_rows_copy;
+        lin_mat_t const *b_rows = _lin_mat_rows(b, &b_rows_copy);
+        lin_mat_t *res = lin_mat_add(a_rows, b_rows);
+        lin_mat_free(a_rows_copy);
+        lin_mat_free(b_rows_copy);
+        return res;
+    }
+
+    // elementwise on the storage, keeping the layout
+    lin_mat_t *res = lin_mat_create(a->shape);
+    res->layout = a->layout;
+    if (a->shape.rows == a->shape.columns
+        && _lin_small_add(a->shape.rows, a->elements, b->elements,
+                          res->elements)) {
+        return res;
+    }
+
+    _lin_ew_ctx_t ctx = {_LIN_EW_ADD, a->elements, b->elements, 0, res->elements};
+    _lin_parallel_for(a->shape.rows * a->shape.columns, 1, _lin_mat_ew_range,
+                      &ctx);
+
+    return res;
+}
+
+
+lin_mat_t *lin_mat_sub(lin_mat_t const *a, lin_mat_t const *b) {
+    _LIN_TRACE(_LIN_MAT_DIMS(a), _LIN_MAT_DIMS(b));
+    if (a->shape.rows != b->shape.rows
+        || a->shape.columns != b->shape.columns) {
+        LIN_LOG_ERROR(
+            "Dimension mismatch during matrix addition [%zu x %zu] [%zu x %zu]",
+            a->shape.rows, a->shape.columns, b->shape.rows, b->shape.columns
+        );
+        exit(EXIT_FAILURE);
+    }
+
+    if (a->layout != b->layout) {
+        lin_mat_t *a_rows_copy;
+        lin_mat_t const *a_rows = _lin_mat_rows(a, &a_rows_copy);
+        lin_mat_t *b_rows_copy;
+        lin_mat_t const *b_rows = _lin_mat_rows(b, &b_rows_copy);
+        lin_mat_t *res = lin_mat_sub(a_rows, b_rows);
+        lin_mat_free(a_rows_copy);
+        lin_mat_free(b_rows_copy);
+        return res;
+    }
+
+    lin_mat_t *res = lin_mat_create(a->shape);
+    res->layout = a->layout;
+    _lin_ew_ctx_t ctx = {_LIN_EW_SUB, a->elements, b->elements, 0, res->elements};
+    _lin_parallel_for(a->shape.rows * a->shape.columns, 1, _lin_mat_ew_range,
+                      &ctx);
+
+    return res;
+}
+
+lin_mat_t *lin_mat_scalar_mult(lin_mat_t const *a, lin_decimal_t k) {
+    _LIN_TRACE(_LIN_MAT_DIMS(a), _LIN_NO_DIMS);
+    lin_mat_t *res = lin_mat_create(a->shape);
+    res->layout = a->layout;
+    _lin_ew_ctx_t ctx = {_LIN_EW_SCALAR_MULT, a->elements, NULL, k, res->elements};
+    _lin_parallel_for(a->shape.rows * a->shape.columns, 1, _lin_mat_ew_range,
+                      &ctx);
+
+    return res;
+}
+
+static lin_mat_t *_lin_mat_transpose(lin_mat_t const *a) {
+    if (a->layout == LIN_COL_MAJOR) {
+        // the storage already holds the transpose row by row
+        return lin_mat_create_from_array(
+            (lin_mat_shape_t){a->shape.columns, a->shape.rows}, a->elements
+        );
+    }
+
+    lin_mat_t *res = lin_mat_create((lin_mat_shape_t){
+        a->shape.columns, a->shape.rows
+    });
+    if (a->shape.rows == a->shape.columns
+        && _lin_small_transpose(a->shape.rows, a->elements, res->elements)) {
+        return res;
+    }
+
+    for (size_t col = 0; col < a->shape.columns; col++) {
+        for (size_t row = 0; row < a->shape.rows; row++) {
+            res->elements[(col * res->shape.columns) + row] = 
+                a->elements[(row * res->shape.rows) + col];
+        }
+    }
+
+    return res;
+}
+
+lin_mat_t *lin_mat_transpose(lin_mat_t const *a) {
+    _LIN_TRACE(_LIN_MAT_DIMS(a), _LIN_NO_DIMS);
+    if (a->cache != NULL) {
+        lin_mat_t const *t = lin_mat_cached_transpose(a);
+        return lin_mat_create_from_array(t->shape, t->elements);
+    }
+
+    return _lin_mat_transpose(a);
+}
+
+/// Transposes `mat` in O(1) by swapping its shape and flipping its layout
+void lin_mat_transpose_in_place(lin_mat_t *mat) {
+    _LIN_TRACE(_LIN_MAT_DIMS(mat), _LIN_NO_DIMS);
+    mat->shape = (lin_mat_shape_t){mat->shape.columns, mat->shape.rows};
+    if (mat->shape.rows != 1 && mat->shape.columns != 1) {
+        mat->layout = mat->layout == LIN_ROW_MAJOR ? LIN_COL_MAJOR : LIN_ROW_MAJOR;
+    }
+    lin_mat_touch(mat);
+}
+
+/// Reorders the storage of `mat` into `layout`, leaving the matrix itself
+/// unchanged. Returns false if the workspace cannot be allocated.
+bool lin_mat_set_layout(lin_mat_t *mat, lin_layout_t layout) {
+    _LIN_TRACE(_LIN_MAT_DIMS(mat), _LIN_NO_DIMS);
+    if (mat->layout == layout) {
+        return true;
+    }
+    if (mat->shape.rows == 1 || mat->shape.columns == 1) {
+        mat->layout = layout;
+        return true;
+    }
+
+    size_t const count = mat->shape.rows * mat->shape.columns;
+    lin_decimal_t *src = (lin_decimal_t *)malloc(count * sizeof(lin_decimal_t));
+    if (src == NULL) {
+        LIN_LOG_ERROR("Failed to allocate matrix layout workspace");
+        return false;
+    }
+    memcpy(src, mat->elements, count * sizeof(lin_decimal_t));
+
+    // transpose the storage, viewed as a row-major matrix
+    lin_mat_t s;
+    _lin_mat_storage(mat, &s);
+    for (size_t r = 0; r < s.shape.rows; r++) {
+        for (size_t c = 0; c < s.shape.columns; c++) {
+            mat->elements[(c * s.shape.rows) + r] = src[(r * s.shape.columns) + c];
+        }
+    }
+
+    free(src);
+    mat->layout = layout;
+    return true;
+}
+
+lin_decimal_t lin_mat_get(lin_mat_t const *mat, size_t row, size_t column) {
+    return mat->elements[_lin_mat_index(mat, row, column)];
+}
+
+void lin_mat_set(lin_mat_t *mat, size_t row, size_t column, lin_decimal_t value) {
+    mat->elements[_lin_mat_index(mat, row, column)] = value;
+    lin_mat_touch(mat);
+}
+
+lin_decimal_t lin_mat_det(lin_mat_t const *a) {
+    _LIN_TRACE(_LIN_MAT_DIMS(a), _LIN_NO_DIMS);
+    if (a->shape.rows != a->shape.columns) {
+        LIN_LOG_ERROR(
+            "Cannot take determinant of non-square matrix [%zu x %zu]",
+            a->shape.rows, a->shape.columns
+        );
+        exit(EXIT_FAILURE);
+    }
+
+    if (a->cache != NULL) {
+        return lin_mat_cached_det(a);
+    }
+
+    if (a->layout == LIN_COL_MAJOR) {
+        // det(a) = det(a^T)
+        lin_mat_t s;
+        _lin_mat_storage(a, &s);
+        return lin_mat_det(&s);
+    }
+
+    size_t n = a->shape.rows;
+
+    if (n == 1) {
+        return a->elements[0];
+    }
+
+    if (n == 2) {
+        return a->elements[0] * a->elements[3] -
+            a->elements[1] * a->elements[2];
+    }
+
+    if (n == 3) {
+        return (a->elements[0] * a->elements[4] * a->elements[8]) +
+        (a->elements[1] * a->elements[5] * a->elements[6]) +
+        (a->elements[2] * a->elements[3] * a->elements[7]) -
+        (a->elements[2] * a->elements[4] * a->elements[6]) -
+        (a->elements[1] * a->elements[3] * a->elements[8]) -
+        (a->elements[0] * a->elements[5] * a->elements[7]);
+    }
+
+    lin_decimal_t res = 0;
+    for (size_t col = 0; col < n; ++col) {
+        lin_mat_t *sub = lin_mat_create((lin_mat_shape_t){n - 1, n - 1});
+        for (size_t i = 1; i < n; ++i) {
+            int sub_col = 0;
+            for (size_t j = 0; j < n; j++) {
+                if (j == col) {
+                    continue;
+                }
+
+                sub->elements[((i - 1) * sub->shape.columns) + sub_col] = 
+                    a->elements[(i * a->shape.columns) + j];
+                sub_col += 1;
+            }
+        }
+        int sign = (col % 2 == 0) ? 1: -1;
+        res += sign * a->elements[col] * lin_mat_det(sub);
+        lin_mat_free(sub);
+    }
+
+    return res;
+}
+
+/// Where `n` is the dimension [n x n] of the output matrix
+lin_mat_t *lin_mat_identity(size_t n) {
+    _LIN_TRACE(_LIN_DIMS(n, n), _LIN_NO_DIMS);
+    lin_mat_t *res = lin_mat_create((lin_mat_shape_t){n, n});
+
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < n; j++) {
+            if (j != i) {
+                res->elements[(i * res->shape.columns) + j] = (lin_decimal_t)0;
+            }
+        }
+        res->elements[(i * res->shape.columns) + i] = (lin_decimal_t)1;
+    }
+
+    return res;
+}
+
+// zero indexed
+lin_mat_t *lin_mat_row(lin_mat_t const *a, size_t n) {
+    _LIN_TRACE(_LIN_MAT_DIMS(a), _LIN_NO_DIMS);
+    lin_mat_t *row = lin_mat_create((lin_mat_shape_t){1, a->shape.columns});
+    for (size_t i = 0; i < a->shape.columns; i++) {
+        row->elements[i] = a->elements[_lin_mat_index(a, n, i)];
+    }
+    return row;
+}
+
+// zero indexed
+lin_mat_t *lin_mat_col(lin_mat_t const *a, size_t n) {
+    _LIN_TRACE(_LIN_MAT_DIMS(a), _LIN_NO_DIMS);
+    lin_mat_t *col = lin_mat_create((lin_mat_shape_t){a->shape.rows, 1});
+    for (size_t i = 0; i < a->shape.rows; i++) {
+        col->elements[i] = a->elements[_lin_mat_index(a, i, n)];
+    }
+    return col;
+}
+
+// zero indexed
+lin_vec_t *lin_mat_row_vec(lin_mat_t const *a, size_t n) {
+    _LIN_TRACE(_LIN_MAT_DIMS(a), _LIN_NO_DIMS);
+    lin_vec_t *row = lin_vec_create(a->shape.columns);
+    for (size_t i = 0; i < a->shape.columns; i++) {
+        row->elements[i] = a->elements[_lin_mat_index(a, n, i)];
+    }
+    return row;
+}
+
+// zero indexed
+lin_vec_t *lin_mat_col_vec(lin_mat_t const *a, size_t n) {
+    _LIN_TRACE(_LIN_MAT_DIMS(a), _LIN_NO_DIMS);
+    lin_vec_t *col = lin_vec_create(a->shape.rows);
+    for (size_t i = 0; i < a->shape.rows; i++) {
+        col->elements[i] = a->elements[_lin_mat_index(a, i, n)];
+    }
+    return col;
+}
+
+lin_decimal_t lin_mat_minor_of_element(lin_mat_t const *a, size_t row, size_t col) {
+    _LIN_TRACE(_LIN_MAT_DIMS(a), _LIN_NO_DIMS);
+    if (a->shape.rows != a->shape.columns) {
+        LIN_LOG_ERROR(
+            "Cannot take minor of element of non-square matrix [%zu x %zu]",
+            a->shape.rows, a->shape.columns
+        );
+        exit(EXIT_FAILURE);
+    }
+
+    size_t n = a->shape.rows;
+    lin_mat_t *sub = lin_mat_create((lin_mat_shape_t){n - 1, n - 1});
+
+    bool passed_row = false;
+    for (size_t i = 0; i < a->shape.rows; i++) {
+        if (i == row) {
+            passed_row = true;
+            continue;
+        }
+
+        bool passed_col = false;
+        for (size_t j = 0; j < a->shape.columns; j++) {
+            if (j == col) {
+                passed_col = true;
+                continue;
+            }
+
+            size_t sub_row = passed_row ? i - 1 : i;
+            size_t sub_col = passed_col ? j - 1 : j;
+            sub->elements[(sub_row * sub->shape.columns) + sub_col] = 
+                a->elements[_lin_mat_index(a, i, j)];
+        }
+    }
+
+    lin_decimal_t const res = lin_mat_det(sub);
+    lin_mat_free(sub);
+    return res;
+}
+
+lin_mat_t *lin_mat_minor(lin_mat_t const *a) {
+    _LIN_TRACE(_LIN_MAT_DIMS(a), _LIN_NO_DIMS);
+    if (a->shape.rows != a->shape.columns) {
+        LIN_LOG_ERROR(
+            "Cannot find minor matrix of non-square matrix [%zu x %zu]",
+            a->shape.rows, a->shape.columns
+        );
+        exit(EXIT_FAILURE);
+    }
+
+    lin_mat_t *res = lin_mat_create(a->shape);
+
+    for (size_t row = 0; row < a->shape.rows; row++) {
+        for (size_t col = 0; col < a->shape.columns; col++) {
+            res->elements[(row * res->shape.columns) + col] = 
+                lin_mat_minor_of_element(a, row, col);
+        }
+    }
+
+    return res;
+}
+
+lin_decimal_t lin_mat_cofactor_of_element(lin_mat_t const *a, size_t row, size_t col) {
+    _LIN_TRACE(_LIN_MAT_DIMS(a), _LIN_NO_DIMS);
+    if (a->shape.rows != a->shape.columns) {
+        LIN_LOG_ERROR(
+            "Cannot find cofactor of element of non-square matrix [%zu x %zu]",
+            a->shape.rows, a->shape.columns
+        );
+        exit(EXIT_FAILURE);
+    }
+
+    lin_decimal_t min = lin_mat_minor_of_element(a, row, col);
+    lin_decimal_t mul  = (lin_decimal_t)pow(-1.0, (double)(row + col));
+
+    return mul * min;
+}
+
+lin_mat_t *lin_mat_cofactor(lin_mat_t const *a) {
+    _LIN_TRACE(_LIN_MAT_DIMS(a), _LIN_NO_DIMS);
+    if (a->shape.rows != a->shape.columns) {
+        LIN_LOG_ERROR(
+            "Cannot find cofactor matrix of non-square matrix [%zu x %zu]",
+            a->shape.rows, a->shape.columns
+        );
+        exit(EXIT_FAILURE);
+    }
+
+    lin_mat_t *res = lin_mat_create(a->shape);
+
+    for (size_t row = 0; row < a->shape.rows; row++) {
+        for (size_t col = 0; col < a->shape.columns; col++) {
+            res->elements[(row * res->shape.columns) + col] = 
+                lin_mat_cofactor_of_element(a, row, col);
+        }
+    }
+
+    return res;
+}
+
+lin_mat_t *lin_mat_adj(lin_mat_t const *a) {
+    _LIN_TRACE(_LIN_MAT_DIMS(a), _LIN_NO_DIMS);
+    if (a->shape.rows != a->shape.columns) {
+        LIN_LOG_ERROR(
+            "Cannot find adjoint matrix of non-square matrix [%zu x %zu]",
+            a->shape.rows, a->shape.columns
+        );
+        exit(EXIT_FAILURE);
+    }
+
+    lin_mat_t *min = lin_mat_cofactor(a);
+    lin_mat_t *res = lin_mat_transpose(min);
+    lin_mat_free(min);
+    return res;
+}
+
+lin_mat_t *lin_mat_inv(lin_mat_t const *a) {
+    _LIN_TRACE(_LIN_MAT_DIMS(a), _LIN_NO_DIMS);
+    if (a->shape.rows != a->shape.columns) {
+        LIN_LOG_ERROR("Cannot find inverse of non-square matrix [%zu x %zu]",
+                      a->shape.rows, a->shape.columns);
+        exit(EXIT_FAILURE);
+    }
+
+    if (a->cache != NULL) {
+        lin_mat_t const *inv = lin_mat_cached_inv(a);
+        if (inv == NULL) {
+            LIN_LOG_ERROR("Cannot find inverse of matrix with determinant of zero");
+            exit(EXIT_FAILURE);
+        }
+        return lin_mat_create_from_array(inv->shape, inv->elements);
+    }
+
+    if (a->layout == LIN_COL_MAJOR) {
+        lin_mat_t *rows = _lin_mat_dup(a);
+        lin_mat_t *res = lin_mat_inv(rows);
+        lin_mat_free(rows);
+        return res;
+    }
+
+    lin_mat_t *res = lin_mat_create(a->shape);
+    bool ok;
+    if (_lin_small_inv(a->shape.rows, a->elements, res->elements, &ok)) {
+        if (!ok) {
+            LIN_LOG_ERROR("Cannot find inverse of matrix with determinant of zero");
+            exit(EXIT_FAILURE);
+        }
+        return res;
+    }
+    lin_mat_free(res);
+
+    lin_decimal_t det = lin_mat_det(a);
+
+    if (det == (lin_decimal_t)0) {
+        LIN_LOG_ERROR("Cannot find inverse of matrix with determinant of zero");
+        exit(EXIT_FAILURE);
+    }
+
+    lin_mat_t *adj = lin_mat_adj(a);
+    res = lin_mat_scalar_mult(adj, (1.0 / det));
+    lin_mat_free(adj);
+    return res;
+}
+
+lin_mat_t *lin_mat_map(lin_mat_t *mat, lin_decimal_t (*fn)(lin_decimal_t)) {
+    _LIN_TRACE(_LIN_MAT_DIMS(mat), _LIN_NO_DIMS);
+    lin_mat_t *res = lin_mat_create(mat->shape);
+    res->layout = mat->layout;
+    for (size_t i = 0; i < mat->shape.rows; i++) {
+        for (size_t j = 0; j < mat->shape.columns; j++) {
+            size_t idx = i * mat->shape.columns + j;
+            res->elements[idx] = fn(mat->elements[idx]);
+        }
+    }
+
+    return res;
+}
+
+// c = a * b for [n x n] operands, where `a_t` marks `a` as column-major
+static void _lin_mat_pow_mult(size_t n, lin_decimal_t const *a, bool a_t,
+                              lin_decimal_t const *b, lin_decimal_t *c) {
+    if (!a_t && _lin_small_mult(n, n, n, a, b, c)) {
+        return;
+    }
+    _lin_gemm(a_t, false, n, n, n, 1, a, n, b, n, 0, c, n);
+}
+
+/// a^k by repeated squaring, in about 2 * log2(k) multiplications
+lin_mat_t *lin_mat_pow(lin_mat_t const *a, size_t k) {
+    _LIN_TRACE(_LIN_MAT_DIMS(a), _LIN_DIMS(k, 1));
+    lin_mat_t *res = lin_mat_create(a->shape);
+    lin_mat_t *work = lin_mat_create(a->shape);
+    if (res == NULL || work == NULL) {
+        lin_mat_free(res);
+        lin_mat_free(work);
+        return NULL;
+    }
+
+    lin_mat_pow_into(a, k, res, work);
+    lin_mat_free(work);
+    return res;
+}
+
+/// Writes a^k to `res` without allocating, using `work` as the second buffer
+/// of the ping-pong. `res` and `work` must be distinct from `a` and have its
+/// shape; their previous contents are discarded and both end up row-major.
+void lin_mat_pow_into(lin_mat_t const *a, size_t k, lin_mat_t *res, lin_mat_t *work) {
+    _LIN_TRACE(_LIN_MAT_DIMS(a), _LIN_DIMS(k, 1));
+    size_t const n = a->shape.rows;
+    if (a->shape.columns != n
+        || res->shape.rows != n || res->shape.columns != n
+        || work->shape.rows != n || work->shape.columns != n) {
+        LIN_LOG_ERROR(
+            "Dimension mismatch during matrix power [%zu x %zu] [%zu x %zu] [%zu x %zu]",
+            a->shape.rows, a->shape.columns, res->shape.rows, res->shape.columns,
+            work->shape.rows, work->shape.columns
+        );
+        exit(EXIT_FAILURE);
+    }
+    if (res == a || work == a || res == work) {
+        LIN_LOG_ERROR("Matrix power buffers must be distinct from each other and the input");
+        exit(EXIT_FAILURE);
+    }
+
+    lin_mat_touch(res);
+    lin_mat_touch(work);
+    res->layout = LIN_ROW_MAJOR;
+    work->layout = LIN_ROW_MAJOR;
+    if (k == 0) {
+        for (size_t i = 0; i < n * n; i++) {
+            res->elements[i] = (lin_decimal_t)0;
+        }
+        for (size_t i = 0; i < n; i++) {
+            res->elements[(i * n) + i] = (lin_decimal_t)1;
+        }
+        return;
+    }
+
+    // left to right over the bits of k: square, then multiply by a if the
+    // bit is set. Each product lands in the other buffer.
+    bool const a_t = a->layout == LIN_COL_MAJOR;
+    lin_decimal_t *cur = res->elements;
+    lin_decimal_t *next = work->elements;
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < n; j++) {
+            cur[(i * n) + j] = a->elements[_lin_mat_index(a, i, j)];
+        }
+    }
+
+    size_t bit = 1;
+    while (bit <= k / 2) {
+        bit <<= 1;
+    }
+    for (bit >>= 1; bit != 0; bit >>= 1) {
+        _lin_mat_pow_mult(n, cur, false, cur, next);
+        lin_decimal_t *tmp = cur;
+        cur = next;
+        next = tmp;
+
+        if ((k & bit) != 0) {
+            // a * cur = cur * a, as powers of a commute
+            _lin_mat_pow_mult(n, a->elements, a_t, cur, next);
+            tmp = cur;
+            cur = next;
+            next = tmp;
+        }
+    }
+
+    if (cur != res->elements) {
+        memcpy(res->elements, cur, n * n * sizeof(lin_decimal_t));
+    }
+}
+
+typedef struct {
+    lin_decimal_t m[16];    // row-major, the last row is ignored if affine
+    bool affine;
+    lin_decimal_t const *src;
+    lin_decimal_t *dst;
+    lin_vec3_array_t const *src_arr;
+    lin_vec3_array_t *dst_arr;
+} _lin_xform_ctx_t;
+
+// Loads the transform into `g`, accepting a [4 x 4] matrix or the [3 x 4]
+// top of an affine one
+static void _lin_xform_init(_lin_xform_ctx_t *g, lin_mat_t const *m) {
+    if (m->shape.columns != 4 || (m->shape.rows != 3 && m->shape.rows != 4)) {
+        LIN_LOG_ERROR("Point transform must be [3 x 4] or [4 x 4], got [%zu x %zu]",
+                      m->shape.rows, m->shape.columns);
+        exit(EXIT_FAILURE);
+    }
+
+    for (size_t i = 0; i < 4; i++) {
+        for (size_t j = 0; j < 4; j++) {
+            g->m[(i * 4) + j] = i < m->shape.rows
+                ? m->elements[_lin_mat_index(m, i, j)]
+                : (lin_decimal_t)(j == 3 ? 1 : 0);
+        }
+    }
+    g->affine = g->m[12] == (lin_decimal_t)0 && g->m[13] == (lin_decimal_t)0
+        && g->m[14] == (lin_decimal_t)0 && g->m[15] == (lin_decimal_t)1;
+}
+
+// Points [begin, end) of an interleaved x y z buffer. The affine loop skips
+// the projective row and the divide; each is branch-free across points.
+static void _lin_xform_xyz(void *ctx, size_t chunk, size_t begin, size_t end) {
+    (void)chunk;
+    _lin_xform_ctx_t const *g = (_lin_xform_ctx_t const *)ctx;
+    lin_decimal_t const *m = g->m;
+    lin_decimal_t const m00 = m[0], m01 = m[1], m02 = m[2], m03 = m[3];
+    lin_decimal_t const m10 = m[4], m11 = m[5], m12 = m[6], m13 = m[7];
+    lin_decimal_t const m20 = m[8], m21 = m[9], m22 = m[10], m23 = m[11];
+    lin_decimal_t const m30 = m[12], m31 = m[13], m32 = m[14], m33 = m[15];
+    lin_decimal_t const *src = g->src;
+    lin_decimal_t *dst = g->dst;
+
+    if (g->affine) {
+        for (size_t i = begin; i < end; i++) {
+            lin_decimal_t const x = src[(3 * i) + 0];
+            lin_decimal_t const y = src[(3 * i) + 1];
+            lin_decimal_t const z = src[(3 * i) + 2];
+            dst[(3 * i) + 0] = (m00 * x) + (m01 * y) + (m02 * z) + m03;
+            dst[(3 * i) + 1] = (m10 * x) + (m11 * y) + (m12 * z) + m13;
+            dst[(3 * i) + 2] = (m20 * x) + (m21 * y) + (m22 * z) + m23;
+        }
+        return;
+    }
+
+    for (size_t i = begin; i < end; i++) {
+        lin_decimal_t const x = src[(3 * i) + 0];
+        lin_decimal_t const y = src[(3 * i) + 1];
+        lin_decimal_t const z = src[(3 * i) + 2];
+        lin_decimal_t const w = (lin_decimal_t)1
+            / ((m30 * x) + (m31 * y) + (m32 * z) + m33);
+        dst[(3 * i) + 0] = ((m00 * x) + (m01 * y) + (m02 * z) + m03) * w;
+        dst[(3 * i) + 1] = ((m10 * x) + (m11 * y) + (m12 * z) + m13) * w;
+        dst[(3 * i) + 2] = ((m20 * x) + (m21 * y) + (m22 * z) + m23) * w;
+    }
+}
+
+// Points [begin, end) of a structure-of-arrays buffer
+static void _lin_xform_soa(void *ctx, size_t chunk, size_t begin, size_t end) {
+    (void)chunk;
+    _lin_xform_ctx_t const *g = (_lin_xform_ctx_t const *)ctx;
+    lin_decimal_t const *m = g->m;
+    lin_decimal_t const m00 = m[0], m01 = m[1], m02 = m[2], m03 = m[3];
+    lin_decimal_t const m10 = m[4], m11 = m[5], m12 = m[6], m13 = m[7];
+    lin_decimal_t const m20 = m[8], m21 = m[9], m22 = m[10], m23 = m[11];
+    lin_decimal_t const m30 = m[12], m31 = m[13], m32 = m[14], m33 = m[15];
+    lin_decimal_t const *sx = g->src_arr->x;
+    lin_decimal_t const *sy = g->src_arr->y;
+    lin_decimal_t const *sz = g->src_arr->z;
+    lin_decimal_t *dx = g->dst_arr->x;
+    lin_decimal_t *dy = g->dst_arr->y;
+    lin_decimal_t *dz = g->dst_arr->z;
+
+    if (g->affine) {
+        for (size_t i = begin; i < end; i++) {
+            lin_decimal_t const x = sx[i];
+            lin_decimal_t const y = sy[i];
+            lin_decimal_t const z = sz[i];
+            dx[i] = (m00 * x) + (m01 * y) + (m02 * z) + m03;
+            dy[i] = (m10 * x) + (m11 * y) + (m12 * z) + m13;
+            dz[i] = (m20 * x) + (m21 * y) + (m22 * z) + m23;
+        }
+        return;
+    }
+
+    for (size_t i = begin; i < end; i++) {
+        lin_decimal_t const x = sx[i];
+        lin_decimal_t const y = sy[i];
+        lin_decimal_t const z = sz[i];
+        lin_decimal_t const w = (lin_decimal_t)1
+            / ((m30 * x) + (m31 * y) + (m32 * z) + m33);
+        dx[i] = ((m00 * x) + (m01 * y) + (m02 * z) + m03) * w;
+        dy[i] = ((m10 * x) + (m11 * y) + (m12 * z) + m13) * w;
+        dz[i] = ((m20 * x) + (m21 * y) + (m22 * z) + m23) * w;
+    }
+}
+
+/// Applies the homogeneous transform `m` to `n` points stored interleaved as
+/// x0 y0 z0 x1 y1 z1 ... in `src`, writing them the same way to `dst`, which
+/// may be `src` but must not otherwise overlap it. Points are divided by w
+/// unless the last row of `m` is 0 0 0 1 or `m` is [3 x 4].
+void lin_mat_transform_points(lin_mat_t const *m, lin_decimal_t const *src,
+                              lin_decimal_t *dst, size_t n) {
+    _LIN_TRACE(_LIN_MAT_DIMS(m), _LIN_DIMS(n, 3));
+    _lin_xform_ctx_t g = {{0}, false, src, dst, NULL, NULL};
+    _lin_xform_init(&g, m);
+    _lin_parallel_for(n, 16, _lin_xform_xyz, &g);
+}
+
+/// As `lin_mat_transform_points` for structure-of-arrays points; `dst` may be
+/// `src`
+void lin_mat_transform_vec3_array(lin_mat_t const *m, lin_vec3_array_t const *src,
+                                  lin_vec3_array_t *dst) {
+    _LIN_TRACE(_LIN_MAT_DIMS(m), _LIN_VEC3_DIMS(src));
+    if (src->len != dst->len) {
+        LIN_LOG_ERROR(
+            "Length mismatch during batch point transform (%zu and %zu)",
+            src->len, dst->len
+        );
+        exit(EXIT_FAILURE);
+    }
+
+    _lin_xform_ctx_t g = {{0}, false, NULL, NULL, src, dst};
+    _lin_xform_init(&g, m);
+    _lin_parallel_for(src->len, 16, _lin_xform_soa, &g);
+}
+
+/// Drops a reference to `mat`, releasing it with the last one
+void lin_mat_free(lin_mat_t *mat) {
+    _LIN_TRACE(_LIN_NO_DIMS, _LIN_NO_DIMS);
+    if (mat == NULL || __atomic_sub_fetch(&mat->refs, 1, __ATOMIC_ACQ_REL) != 0) {
+        return;
+    }
+
+    lin_mat_cache_disable(mat);
+    if (mat->ownership == LIN_ADOPT) {
+        free(mat->elements);
+    }
+    _lin_pool_free(mat, sizeof(lin_mat_t) + (mat->capacity * sizeof(lin_decimal_t)));
+}
+
+void _lin_mat_print(lin_mat_t const *a) {
+    char buf[_LIN_DECIMAL_TOKEN + 1];
+    for (size_t row = 0; row < a->shape.rows; row++) {
+        fputs("[ ", stdout);
+        for (size_t col = 0; col < a->shape.columns; col++) {
+            size_t const len = _lin_decimal_format(
+                a->elements[_lin_mat_index(a, row, col)], buf
+            );
+            buf[len] = ' ';
+            fwrite(buf, 1, len + 1, stdout);
+        }
+        fputs("]\n", stdout);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// TRIANGULAR DECLARATION
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef LIN_TRI_BLOCK
+#define LIN_TRI_BLOCK 64
+#endif
+
+// Flags selecting which triangle of a full matrix is used and how. The
+// triangle of a packed `lin_tri_t` comes from the object, so only
+// `LIN_TRI_TRANS` and `LIN_TRI_UNIT` apply to it.
+enum {
+    LIN_TRI_LOWER = 0,
+    LIN_TRI_UPPER = 1 << 0,
+    LIN_TRI_TRANS = 1 << 1, // use the transpose of the triangle
+    LIN_TRI_UNIT = 1 << 2,  // assume a unit diagonal, it is never read
+};
+
+// Packed [n x n] triangular matrix. Only the n * (n + 1) / 2 elements of the
+// triangle are stored, row by row: row i of a lower triangle holds columns
+// 0..i and row i of an upper triangle holds columns i..n-1.
+typedef struct {
+    size_t n;
+    bool upper;
+    lin_decimal_t *elements;
+    size_t capacity;
+    _Alignas(LIN_ALIGNMENT) lin_decimal_t data[];
+} lin_tri_t;
+
+lin_tri_t *lin_tri_create(size_t n, bool upper);
+lin_tri_t *lin_tri_pack(lin_mat_t const *a, bool upper);
+lin_mat_t *lin_tri_unpack(lin_tri_t const *t);
+lin_decimal_t lin_tri_get(lin_tri_t const *t, size_t row, size_t column);
+lin_mat_t *lin_tri_solve(lin_tri_t const *t, lin_mat_t const *b, unsigned flags);
+lin_mat_t *lin_tri_mult(lin_tri_t const *t, lin_mat_t const *b, unsigned flags);
+void lin_tri_free(lin_tri_t *t);
+lin_mat_t *lin_mat_trsm(lin_mat_t const *t, lin_mat_t const *b, unsigned flags);
+lin_mat_t *lin_mat_trmm(lin_mat_t const *t, lin_mat_t const *b, unsigned flags);
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// TRIANGULAR IMPLEMENTATION
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// A triangle in either full storage (`ld` is the row stride) or packed
+// storage (`ld` is 0)
+typedef struct {
+    lin_decimal_t const *el;
+    size_t ld;
+    size_t n;
+    bool upper;
+    bool trans;
+    bool unit;
+} _lin_tri_view_t;
+
+static inline size_t _lin_tri_offset(size_t n, bool upper, size_t row) {
+    return upper ? ((row * ((2 * n) - row + 1)) / 2) : ((row * (row + 1)) / 2);
+}
+
+// Pointer `p` such that p[j] is element (i, j) of the stored triangle for
+// every stored column j
+static inline lin_decimal_t const *_lin_tri_row(_lin_tri_view_t const *t,
+                                                size_t i) {
+    if (t->ld != 0) {
+        return &t->el[i * t->ld];
+    }
+    return &t->el[_lin_tri_offset(t->n, t->upper, i) - (t->upper ? i : 0)];
+}
+
+// Solves op(T)[k0:k1, k0:k1] * X = B for rows [k0, k1) of b in place, using
+// only rows of T so packed storage is read contiguously
+static void _lin_trsm_diag(_lin_tri_view_t const *t, size_t k0, size_t k1,
+                           size_t p, lin_decimal_t *b, size_t ldb) {
+    if (!t->trans && !t->upper) {
+        for (size_t i = k0; i < k1; i++) {
+            lin_decimal_t const *t_i = _lin_tri_row(t, i);
+            for (size_t q = k0; q < i; q++) {
+                _lin_axpy(p, -t_i[q], &b[q * ldb], &b[i * ldb]);
+            }
+            if (!t->unit) {
+                _lin_scale(p, (lin_decimal_t)1 / t_i[i], &b[i * ldb]);
+            }
+        }
+    } else if (!t->trans) {
+        for (size_t i = k1; i-- > k0;) {
+            lin_decimal_t const *t_i = _lin_tri_row(t, i);
+            for (size_t q = i + 1; q < k1; q++) {
+                _lin_axpy(p, -t_i[q], &b[q * ldb], &b[i * ldb]);
+            }
+            if (!t->unit) {
+                _lin_scale(p, (lin_decimal_t)1 / t_i[i], &b[i * ldb]);
+            }
+        }
+    } else if (!t->upper) {
+        // L^T * x = b, eliminating with row i of L once x_i is known
+        for (size_t i = k1; i-- > k0;) {
+            lin_decimal_t const *t_i = _lin_tri_row(t, i);
+            if (!t->unit) {
+                _lin_scale(p, (lin_decimal_t)1 / t_i[i], &b[i * ldb]);
+            }
+            for (size_t q = k0; q < i; q++) {
+                _lin_axpy(p, -t_i[q], &b[i * ldb], &b[q * ldb]);
+            }
+        }
+    } else {
+        for (size_t i = k0; i < k1; i++) {
+            lin_decimal_t const *t_i = _lin_tri_row(t, i);
+            if (!t->unit) {
+                _lin_scale(p, (lin_decimal_t)1 / t_i[i], &b[i * ldb]);
+            }
+            for (size_t q = i + 1; q < k1; q++) {
+                _lin_axpy(p, -t_i[q], &b[i * ldb], &b[q * ldb]);
+            }
+        }
+    }
+}
+
+// b[k0:k1] = op(T)[k0:k1, k0:k1] * b[k0:k1] in place, ordering the rows so
+// that every row is read before it is overwritten
+static void _lin_trmm_diag(_lin_tri_view_t const *t, size_t k0, size_t k1,
+                           size_t p, lin_decimal_t *b, size_t ldb) {
+    if (!t->trans && !t->upper) {
+        for (size_t i = k1; i-- > k0;) {
+            lin_decimal_t const *t_i = _lin_tri_row(t, i);
+            if (!t->unit) {
+                _lin_scale(p, t_i[i], &b[i * ldb]);
+            }
+            for (size_t q = k0; q < i; q++) {
+                _lin_axpy(p, t_i[q], &b[q * ldb], &b[i * ldb]);
+            }
+        }
+    } else if (!t->trans) {
+        for (size_t i = k0; i < k1; i++) {
+            lin_decimal_t const *t_i = _lin_tri_row(t, i);
+            if (!t->unit) {
+                _lin_scale(p, t_i[i], &b[i * ldb]);
+            }
+            for (size_t q = i + 1; q < k1; q++) {
+                _lin_axpy(p, t_i[q], &b[q * ldb], &b[i * ldb]);
+            }
+        }
+    } else if (!t->upper) {
+        // row i of L scatters b_i into the rows above it
+        for (size_t i = k0; i < k1; i++) {
+            lin_decimal_t const *t_i = _lin_tri_row(t, i);
+            for (size_t q = k0; q < i; q++) {
+                _lin_axpy(p, t_i[q], &b[i * ldb], &b[q * ldb]);
+            }
+            if (!t->unit) {
+                _lin_scale(p, t_i[i], &b[i * ldb]);
+            }
+        }
+    } else {
+        for (size_t i = k1; i-- > k0;) {
+            lin_decimal_t const *t_i = _lin_tri_row(t, i);
+            for (size_t q = i + 1; q < k1; q++) {
+                _lin_axpy(p, t_i[q], &b[i * ldb], &b[q * ldb]);
+            }
+            if (!t->unit) {
+                _lin_scale(p, t_i[i], &b[i * ldb]);
+            }
+        }
+    }
+}
+
+// Block op(T)[r0:, c0:] of a full storage triangle as a `_lin_gemm` operand
+static inline lin_decimal_t const *_lin_tri_block(_lin_tri_view_t const *t,
+                                                  size_t r0, size_t c0) {
+    return t->trans ? &t->el[(c0 * t->ld) + r0] : &t->el[(r0 * t->ld) + c0];
+}
+
+// Solves op(T) * X = B for the [n x p] matrix b in place. Full storage
+// triangles are processed in diagonal blocks of LIN_TRI_BLOCK, with the
+// off-diagonal parts applied by `_lin_gemm`. No singularity check is made.
+static void _lin_trsm(_lin_tri_view_t const *t, size_t p,
+                      lin_decimal_t *b, size_t ldb) {
+    size_t const n = t->n;
+    if (t->ld == 0) {
+        _lin_trsm_diag(t, 0, n, p, b, ldb);
+        return;
+    }
+
+    size_t const bs = LIN_TRI_BLOCK;
+    if (t->upper == t->trans) {
+        // forward: solved rows update the rows below them
+        for (size_t k0 = 0; k0 < n; k0 += bs) {
+            size_t const k1 = _lin_min(k0 + bs, n);
+            _lin_trsm_diag(t, k0, k1, p, b, ldb);
+            if (k1 < n) {
+                _lin_gemm(t->trans, false, n - k1, p, k1 - k0, -1,
+                          _lin_tri_block(t, k1, k0), t->ld,
+                          &b[k0 * ldb], ldb, 1, &b[k1 * ldb], ldb);
+            }
+        }
+        return;
+    }
+
+    // backward: solved rows update the rows above them
+    for (size_t k1 = n; k1 > 0;) {
+        size_t const k0 = k1 > bs ? k1 - bs : 0;
+        _lin_trsm_diag(t, k0, k1, p, b, ldb);
+        if (k0 > 0) {
+            _lin_gemm(t->trans, false, k0, p, k1 - k0, -1,
+                      _lin_tri_block(t, 0, k0), t->ld,
+                      &b[k0 * ldb], ldb, 1, b, ldb);
+        }
+        k1 = k0;
+    }
+}
+
+// b = op(T) * b for the [n x p] matrix b in place, blocked like `_lin_trsm`
+static void _lin_trmm(_lin_tri_view_t const *t, size_t p,
+                      lin_decimal_t *b, size_t ldb) {
+    size_t const n = t->n;
+    if (t->ld == 0) {
+        _lin_trmm_diag(t, 0, n, p, b, ldb);
+        return;
+    }
+
+    size_t const bs = LIN_TRI_BLOCK;
+    if (t->upper != t->trans) {
+        // rows only read the rows below them, which are still unchanged
+        for (size_t k0 = 0; k0 < n; k0 += bs) {
+            size_t const k1 = _lin_min(k0 + bs, n);
+            _lin_trmm_diag(t, k0, k1, p, b, ldb);
+            if (k1 < n) {
+                _lin_gemm(t->trans, false, k1 - k0, p, n - k1, 1,
+                          _lin_tri_block(t, k0, k1), t->ld,
+                          &b[k1 * ldb], ldb, 1, &b[k0 * ldb], ldb);
+            }
+        }
+        return;
+    }
+
+    for (size_t k1 = n; k1 > 0;) {
+        size_t const k0 = k1 > bs ? k1 - bs : 0;
+        _lin_trmm_diag(t, k0, k1, p, b, ldb);
+        if (k0 > 0) {
+            _lin_gemm(t->trans, false, k1 - k0, p, k0, 1,
+                      _lin_tri_block(t, k0, 0), t->ld,
+                      b, ldb, 1, &b[k0 * ldb], ldb);
+        }
+        k1 = k0;
+    }
+}
+
+lin_tri_t *lin_tri_create(size_t n, bool upper) {
+    _LIN_TRACE(_LIN_DIMS(n, n), _LIN_NO_DIMS);
+    // halve whichever of n and n + 1 is even so the product cannot wrap early
+    size_t bytes, block_bytes;
+    lin_tri_t *t = n < SIZE_MAX
+        && _lin_alloc_bytes(sizeof(lin_tri_t), n % 2 == 0 ? n / 2 : n,
+                            n % 2 == 0 ? n + 1 : (n + 1) / 2, &bytes)
+        ? (lin_tri_t *)_lin_pool_alloc(bytes, &block_bytes) : NULL;
+    if (t == NULL) {
+        LIN_LOG_ERROR("Failed to allocate memory for triangular matrix [%zu x %zu]",
+                      n, n);
+        return NULL;
+    }
+
+    t->n = n;
+    t->upper = upper;
+    t->elements = t->data;
+    t->capacity = (block_bytes - sizeof(lin_tri_t)) / sizeof(lin_decimal_t);
+    return t;
+}
+
+/// Packs the lower or upper triangle of the square matrix a
+lin_tri_t *lin_tri_pack(lin_mat_t const *a, bool upper) {
+    _LIN_TRACE(_LIN_MAT_DIMS(a), _LIN_NO_DIMS);
+    if (a->shape.rows != a->shape.columns) {
+        LIN_LOG_ERROR("Cannot pack triangle of non-square matrix [%zu x %zu]",
+                      a->shape.rows, a->shape.columns);
+        exit(EXIT_FAILURE);
+    }
+
+    if (a->layout == LIN_COL_MAJOR) {
+        lin_mat_t *rows_copy;
+        lin_mat_t const *rows = _lin_mat_rows(a, &rows_copy);
+        lin_tri_t *t = lin_tri_pack(rows, upper);
+        lin_mat_free(rows_copy);
+        return t;
+    }
+
+    size_t const n = a->shape.rows;
+    lin_tri_t *t = lin_tri_create(n, upper);
+    if (t == NULL) {
+        return NULL;
+    }
+
+    lin_decimal_t *dst = t->elements;
+    for (size_t i = 0; i < n; i++) {
+        size_t const begin = upper ? i : 0;
+        size_t const end = upper ? n : i + 1;
+        memcpy(dst, &a->elements[(i * n) + begin],
+               (end - begin) * sizeof(lin_decimal_t));
+        dst += end - begin;
+    }
+
+    return t;
+}
+
+/// Full [n x n] matrix with zeros outside the triangle
+lin_mat_t *lin_tri_unpack(lin_tri_t const *t) {
+    _LIN_TRACE(_LIN_DIMS(t->n, t->n), _LIN_NO_DIMS);
+    size_t const n = t->n;
+    lin_mat_t *res = lin_mat_create((lin_mat_shape_t){n, n});
+    if (res == NULL) {
+        return NULL;
+    }
+
+    lin_decimal_t const *src = t->elements;
+    for (size_t i = 0; i < n; i++) {
+        size_t const begin = t->upper ? i : 0;
+        size_t const end = t->upper ? n : i + 1;
+        lin_decimal_t *row = &res->elements[i * n];
+        for (size_t j = 0; j < n; j++) {
+            row[j] = (j >= begin && j < end) ? src[j - begin] : (lin_decimal_t)0;
+        }
+        src += end - begin;
+    }
+
+    return res;
+}
+
+lin_decimal_t lin_tri_get(lin_tri_t const *t, size_t row, size_t column) {
+    if (t->upper ? column < row : column > row) {
+        return (lin_decimal_t)0;
+    }
+
+    size_t const begin = t->upper ? row : 0;
+    return t->elements[_lin_tri_offset(t->n, t->upper, row) + column - begin];
+}
+
+static lin_mat_t *_lin_tri_apply(_lin_tri_view_t const *t, lin_mat_t const *b,
+                                 bool solve) {
+    if (t->n != b->shape.rows) {
+        LIN_LOG_ERROR(
+            "Dimension mismatch during triangular %s [%zu x %zu] [%zu x %zu]",
+            solve ? "solve" : "multiplication",
+            t->n, t->n, b->shape.rows, b->shape.columns
+        );
+        exit(EXIT_FAILURE);
+    }
+
+    lin_mat_t *res = _lin_mat_dup(b);
+    if (res == NULL) {
+        return NULL;
+    }
+
+    size_t const p = b->shape.columns;
+    if (solve) {
+        _lin_trsm(t, p, res->elements, p);
+    } else {
+        _lin_trmm(t, p, res->elements, p);
+    }
+    return res;
+}
+
+/// Solves op(t) * x = b, where op(t) is t^T if `flags` has LIN_TRI_TRANS
+lin_mat_t *lin_tri_solve(lin_tri_t const *t, lin_mat_t const *b, unsigned flags) {
+    _LIN_TRACE(_LIN_DIMS(t->n, t->n), _LIN_MAT_DIMS(b));
+    _lin_tri_view_t const view = {
+        t->elements, 0, t->n, t->upper,
+        (flags & LIN_TRI_TRANS) != 0, (flags & LIN_TRI_UNIT) != 0
+    };
+    return _lin_tri_apply(&view, b, true);
+}
+
+/// op(t) * b
+lin_mat_t *lin_tri_mult(lin_tri_t const *t, lin_mat_t const *b, unsigned flags) {
+    _LIN_TRACE(_LIN_DIMS(t->n, t->n), _LIN_MAT_DIMS(b));
+    _lin_tri_view_t const view = {
+        t->elements, 0, t->n, t->upper,
+        (flags & LIN_TRI_TRANS) != 0, (flags & LIN_TRI_UNIT) != 0
+    };
+    return _lin_tri_apply(&view, b, false);
+}
+
+void lin_tri_free(lin_tri_t *t) {
+    _LIN_TRACE(_LIN_NO_DIMS, _LIN_NO_DIMS);
+    if (t == NULL) {
+        return;
+    }
+
+    _lin_pool_free(t, sizeof(lin_tri_t) + (t->capacity * sizeof(lin_decimal_t)));
+}
+
+static _lin_tri_view_t _lin_tri_view_mat(lin_mat_t const *t, unsigned flags) {
+    if (t->shape.rows != t->shape.columns) {
+        LIN_LOG_ERROR("Triangular matrix must be square [%zu x %zu]",
+                      t->shape.rows, t->shape.columns);
+        exit(EXIT_FAILURE);
+    }
+
+    // column-major storage holds T^T, whose other triangle is the one selected
+    bool const col = t->layout == LIN_COL_MAJOR;
+    return (_lin_tri_view_t){
+        t->elements, t->shape.columns, t->shape.rows,
+        ((flags & LIN_TRI_UPPER) != 0) != col,
+        ((flags & LIN_TRI_TRANS) != 0) != col,
+        (flags & LIN_TRI_UNIT) != 0
+    };
+}
+
+/// Solves op(T) * x = b, where T is the triangle of `t` selected by `flags`.
+/// Elements outside the triangle are never read.
+lin_mat_t *lin_mat_trsm(lin_mat_t const *t, lin_mat_t const *b, unsigned flags) {
+    _LIN_TRACE(_LIN_MAT_DIMS(t), _LIN_MAT_DIMS(b));
+    _lin_tri_view_t const view = _lin_tri_view_mat(t, flags);
+    return _lin_tri_apply(&view, b, true);
+}
+
+/// op(T) * b, where T is the triangle of `t` selected by `flags`
+lin_mat_t *lin_mat_trmm(lin_mat_t const *t, lin_mat_t const *b, unsigned flags) {
+    _LIN_TRACE(_LIN_MAT_DIMS(t), _LIN_MAT_DIMS(b));
+    _lin_tri_view_t const view = _lin_tri_view_mat(t, flags);
+    return _lin_tri_apply(&view, b, false);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// SYMMETRIC DECLARATION
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// A symmetric matrix is kept either in full storage, where the routines below
+// read only the triangle selected by LIN_TRI_LOWER / LIN_TRI_UPPER, or packed
+// in a `lin_tri_t` whose triangle stands for both halves.
+
+lin_mat_t *lin_mat_syrk(lin_mat_t const *a, unsigned flags);
+lin_tri_t *lin_tri_syrk(lin_mat_t const *a, unsigned flags);
+lin_mat_t *lin_tri_sym_unpack(lin_tri_t const *s);
+lin_vec_t *lin_mat_sym_vec_mult(lin_mat_t const *s, lin_vec_t const *x,
+                                unsigned flags);
+lin_vec_t *lin_tri_sym_vec_mult(lin_tri_t const *s, lin_vec_t const *x);
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// SYMMETRIC IMPLEMENTATION
+//
+///////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+    lin_mat_t const *a;
+    bool trans;
+    bool upper;
+    size_t n;
+    size_t k;
+    lin_decimal_t *c;  // full storage result, NULL when packing
+    lin_tri_t *packed;
+} _lin_syrk_ctx_t;
+
+// Computes blocks [begin, end) of one triangle of op(A) * op(A)^T, with the
+// LIN_TRI_BLOCK sized blocks on and below the diagonal numbered row by row
+static void _lin_syrk_blocks(void *ctx, size_t chunk, size_t begin, size_t end) {
+    (void)chunk;
+    _lin_syrk_ctx_t const *g = (_lin_syrk_ctx_t const *)ctx;
+    size_t const bs = LIN_TRI_BLOCK;
+    size_t const n = g->n;
+    size_t const lda = g->a->shape.columns;
+    lin_decimal_t const *a = g->a->elements;
+    lin_decimal_t scratch[LIN_TRI_BLOCK * LIN_TRI_BLOCK];
+
+    size_t bi = 0;
+    while (((bi + 1) * (bi + 2)) / 2 <= begin) {
+        bi++;
+    }
+    size_t bj = begin - ((bi * (bi + 1)) / 2);
+
+    for (size_t blk = begin; blk < end; blk++) {
+        // the upper triangle holds the transposed block
+        size_t const r0 = (g->upper ? bj : bi) * bs;
+        size_t const c0 = (g->upper ? bi : bj) * bs;
+        size_t const rows = _lin_min(r0 + bs, n) - r0;
+        size_t const cols = _lin_min(c0 + bs, n) - c0;
+
+        lin_decimal_t *dst = g->c != NULL ? &g->c[(r0 * n) + c0] : scratch;
+        size_t const ldd = g->c != NULL ? n : cols;
+        if (g->trans) {
+            _lin_gemm(true, false, rows, cols, g->k, 1, &a[r0], lda,
+                      &a[c0], lda, 0, dst, ldd);
+        } else {
+            _lin_gemm(false, true, rows, cols, g->k, 1, &a[r0 * lda], lda,
+                      &a[c0 * lda], lda, 0, dst, ldd);
+        }
+
+        if (g->packed != NULL) {
+            for (size_t i = r0; i < r0 + rows; i++) {
+                size_t const j0 = g->upper ? _lin_max(i, c0) : c0;
+                size_t const j1 = g->upper ? c0 + cols : _lin_min(i + 1, c0 + cols);
+                lin_decimal_t *row = &g->packed->elements[
+                    _lin_tri_offset(n, g->upper, i) - (g->upper ? i : 0)
+                ];
+                for (size_t j = j0; j < j1; j++) {
+                    row[j] = scratch[((i - r0) * cols) + j - c0];
+                }
+            }
+        }
+
+        if (++bj > bi) {
+            bi++;
+            bj = 0;
+        }
+    }
+}
+
+static void _lin_syrk(_lin_syrk_ctx_t *ctx) {
+    size_t const nb = (ctx->n + LIN_TRI_BLOCK - 1) / LIN_TRI_BLOCK;
+    _lin_parallel_for((nb * (nb + 1)) / 2,
+                      LIN_TRI_BLOCK * LIN_TRI_BLOCK * ctx->k,
+                      _lin_syrk_blocks, ctx);
+}
+
+/// a * a^T, or a^T * a with LIN_TRI_TRANS. Only one triangle is computed and
+/// then mirrored, without forming the transpose of `a`.
+lin_mat_t *lin_mat_syrk(lin_mat_t const *a, unsigned flags) {
+    _LIN_TRACE(_LIN_MAT_DIMS(a), _LIN_NO_DIMS);
+    if (a->layout == LIN_COL_MAJOR) {
+        // a * a^T = s^T * s for the row-major storage s = a^T
+        lin_mat_t s;
+        _lin_mat_storage(a, &s);
+        return lin_mat_syrk(&s, flags ^ LIN_TRI_TRANS);
+    }
+
+    bool const trans = (flags & LIN_TRI_TRANS) != 0;
+    size_t const n = trans ? a->shape.columns : a->shape.rows;
+    lin_mat_t *res = lin_mat_create((lin_mat_shape_t){n, n});
+    if (res == NULL) {
+        return NULL;
+    }
+
+    _lin_syrk_ctx_t ctx = {
+        a, trans, false, n, trans ? a->shape.rows : a->shape.columns,
+        res->elements, NULL
+    };
+    _lin_syrk(&ctx);
+
+    lin_decimal_t *c = res->elements;
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = i + 1; j < n; j++) {
+            c[(i * n) + j] = c[(j * n) + i];
+        }
+    }
+
+    return res;
+}
+
+/// Packed a * a^T, or a^T * a with LIN_TRI_TRANS, storing the triangle
+/// selected by LIN_TRI_UPPER
+lin_tri_t *lin_tri_syrk(lin_mat_t const *a, unsigned flags) {
+    _LIN_TRACE(_LIN_MAT_DIMS(a), _LIN_NO_DIMS);
+    if (a->layout == LIN_COL_MAJOR) {
+        // a * a^T = s^T * s for the row-major storage s = a^T
+        lin_mat_t s;
+        _lin_mat_storage(a, &s);
+        return lin_tri_syrk(&s, flags ^ LIN_TRI_TRANS);
+    }
+
+    bool const trans = (flags & LIN_TRI_TRANS) != 0;
+    bool const upper = (flags & LIN_TRI_UPPER) != 0;
+    size_t const n = trans ? a->shape.columns : a->shape.rows;
+    lin_tri_t *res = lin_tri_create(n, upper);
+    if (res == NULL) {
+        return NULL;
+    }
+
+    _lin_syrk_ctx_t ctx = {
+        a, trans, upper, n, trans ? a->shape.rows : a->shape.columns,
+        NULL, res
+    };
+    _lin_syrk(&ctx);
+    return res;
+}
+
+/// Full [n x n] matrix with both halves filled from the packed triangle
+lin_mat_t *lin_tri_sym_unpack(lin_tri_t const *s) {
+    _LIN_TRACE(_LIN_DIMS(s->n, s->n), _LIN_NO_DIMS);
+    size_t const n = s->n;
+    lin_mat_t *res = lin_mat_create((lin_mat_shape_t){n, n});
+    if (res == NULL) {
+        return NULL;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < n; j++) {
+            res->elements[(i * n) + j] = (s->upper ? j >= i : j <= i)
+                ? lin_tri_get(s, i, j) : lin_tri_get(s, j, i);
+        }
+    }
+
+    return res;
+}
+
+// y = S * x, reading each stored element of the triangle once for both the
+// row it is in and the mirrored column
+static void _lin_symv(_lin_tri_view_t const *s, lin_decimal_t const *x,
+                      lin_decimal_t *y) {
+    size_t const n = s->n;
+    for (size_t i = 0; i < n; i++) {
+        y[i] = (lin_decimal_t)0;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        lin_decimal_t const *s_i = _lin_tri_row(s, i);
+        if (s->upper) {
+            y[i] += (s_i[i] * x[i]) + _lin_dot(&s_i[i + 1], &x[i + 1], n - i - 1);
+            _lin_axpy(n - i - 1, x[i], &s_i[i + 1], &y[i + 1]);
+        } else {
+            y[i] += _lin_dot(s_i, x, i) + (s_i[i] * x[i]);
+            _lin_axpy(i, x[i], s_i, y);
+        }
+    }
+}
+
+static lin_vec_t *_lin_sym_vec_mult(_lin_tri_view_t const *s,
+                                    lin_vec_t const *x) {
+    if (s->n != x->dim) {
+        LIN_LOG_ERROR(
+            "Dimension mismatch during symmetric matrix-vector multiplication [%zu x %zu] (%zu)",
+            s->n, s->n, x->dim
+        );
+        exit(EXIT_FAILURE);
+    }
+
+    lin_vec_t *res = lin_vec_create(s->n);
+    if (res == NULL) {
+        return NULL;
+    }
+
+    _lin_symv(s, x->elements, res->elements);
+    return res;
+}
+
+/// s * x for a symmetric `s`, reading only the triangle selected by `flags`
+lin_vec_t *lin_mat_sym_vec_mult(lin_mat_t const *s, lin_vec_t const *x,
+                                unsigned flags) {
+    _LIN_TRACE(_LIN_MAT_DIMS(s), _LIN_VEC_DIMS(x));
+    _lin_tri_view_t const view = _lin_tri_view_mat(s, flags & LIN_TRI_UPPER);
+    return _lin_sym_vec_mult(&view, x);
+}
+
+lin_vec_t *lin_tri_sym_vec_mult(lin_tri_t const *s, lin_vec_t const *x) {
+    _LIN_TRACE(_LIN_DIMS(s->n, s->n), _LIN_VEC_DIMS(x));
+    _lin_tri_view_t const view = {s->elements, 0, s->n, s->upper, false, false};
+    return _lin_sym_vec_mult(&view, x);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// QR DECLARATION
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef LIN_QR_BLOCK
+#define LIN_QR_BLOCK 32
+#endif
+
+// Compact Householder QR of an [m x n] matrix. R is stored on and above the
+// diagonal of `qr`, the Householder vectors (with an implicit leading 1) below
+// it, and `tau` holds the min(m, n) reflector scale factors, so that
+// Q = H_0 * H_1 * ... * H_{k-1} with H_i = I - tau_i * v_i * v_i^T.
+typedef struct {
+    lin_mat_t *qr;
+    lin_vec_t *tau;
+} lin_mat_qr_t;
+
+lin_mat_qr_t *lin_mat_qr(lin_mat_t const *a);
+lin_mat_t *lin_mat_qr_r(lin_mat_qr_t const *qr);
+lin_mat_t *lin_mat_qr_q_mult(lin_mat_qr_t const *qr, lin_mat_t const *b);
+lin_mat_t *lin_mat_qr_qt_mult(lin_mat_qr_t const *qr, lin_mat_t const *b);
+lin_mat_t *lin_mat_lstsq(lin_mat_t const *a, lin_mat_t const *b);
+void lin_mat_qr_free(lin_mat_qr_t *qr);
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// QR IMPLEMENTATION
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Unpacks the reflectors of block [j0, j0 + jb) into an explicit unit lower
+// trapezoidal [(m - j0) x jb] matrix `v`
+static void _lin_qr_block_v(lin_mat_t const *qr, size_t j0, size_t jb,
+                            lin_decimal_t *v) {
+    size_t const m = qr->shape.rows;
+    size_t const lda = qr->shape.columns;
+
+    for (size_t r = 0; r < m - j0; r++) {
+        for (size_t c = 0; c < jb; c++) {
+            lin_decimal_t el = (lin_decimal_t)0;
+            if (r == c) {
+                el = (lin_decimal_t)1;
+            } else if (r > c) {
+                el = qr->elements[((j0 + r) * lda) + j0 + c];
+            }
+            v[(r * jb) + c] = el;
+        }
+    }
+}
+
+// Builds the upper triangular [jb x jb] factor `t` of the compact WY form
+// H_0 * ... * H_{jb-1} = I - V * T * V^T
+static void _lin_qr_block_t(lin_decimal_t const *v, size_t rows, size_t jb,
+                            lin_decimal_t const *tau, lin_decimal_t *t) {
+    for (size_t i = 0; i < jb; i++) {
+        for (size_t r = 0; r < jb; r++) {
+            if (r > i) {
+                t[(r * jb) + i] = (lin_decimal_t)0;
+            }
+        }
+
+        // t[0:i, i] = -tau_i * V[:, 0:i]^T * v_i
+        for (size_t r = 0; r < i; r++) {
+            lin_decimal_t sum = 0;
+            for (size_t row = i; row < rows; row++) {
+                sum += v[(row * jb) + r] * v[(row * jb) + i];
+            }
+            t[(r * jb) + i] = -tau[i] * sum;
+        }
+
+        // t[0:i, i] = T[0:i, 0:i] * t[0:i, i]
+        for (size_t r = 0; r < i; r++) {
+            lin_decimal_t sum = 0;
+            for (size_t q = r; q < i; q++) {
+                sum += t[(r * jb) + q] * t[(q * jb) + i];
+            }
+            t[(r * jb) + i] = sum;
+        }
+
+        t[(i * jb) + i] = tau[i];
+    }
+}
+
+// c = (I - V * op(T) * V^T) * c, where op(T) is T^T when applying the
+// transposed block reflector
+static bool _lin_qr_block_apply(lin_decimal_t const *v, lin_decimal_t const *t,
+                                size_t rows, size_t jb, bool transpose,
+                                lin_decimal_t *c, size_t ldc, size_t cols) {
+    lin_decimal_t *w = (lin_decimal_t *)malloc(
+        2 * jb * cols * sizeof(lin_decimal_t)
+    );
+    if (w == NULL) {
+        LIN_LOG_ERROR("Failed to allocate QR workspace");
+        return false;
+    }
+    lin_decimal_t *tw = &w[jb * cols];
+
+    _lin_gemm(true, false, jb, cols, rows, 1, v, jb, c, ldc, 0, w, cols);
+    _lin_gemm(transpose, false, jb, cols, jb, 1, t, jb, w, cols, 0, tw, cols);
+    _lin_gemm(false, false, rows, cols, jb, -1, v, jb, tw, cols, 1, c, ldc);
+
+    free(w);
+    return true;
+}
+
+// Unblocked factorization of columns [j0, j0 + jb), applying each reflector to
+// the remaining columns of the panel only
+static void _lin_qr_panel(lin_mat_t *qr, lin_decimal_t *tau, size_t j0,
+                          size_t jb, lin_decimal_t *w) {
+    size_t const m = qr->shape.rows;
+    size_t const lda = qr->shape.columns;
+    lin_decimal_t *a = qr->elements;
+
+    for (size_t j = j0; j < j0 + jb; j++) {
+        double norm_sq = 0;
+        for (size_t i = j + 1; i < m; i++) {
+            double const el = (double)a[(i * lda) + j];
+            norm_sq += el * el;
+        }
+
+        if (norm_sq == 0.0) {
+            tau[j] = (lin_decimal_t)0;
+            continue;
+        }
+
+        double const alpha = (double)a[(j * lda) + j];
+        double const beta = -copysign(sqrt((alpha * alpha) + norm_sq), alpha);
+        tau[j] = (lin_decimal_t)((beta - alpha) / beta);
+
+        lin_decimal_t const scale = (lin_decimal_t)(1.0 / (alpha - beta));
+        for (size_t i = j + 1; i < m; i++) {
+            a[(i * lda) + j] *= scale;
+        }
+        a[(j * lda) + j] = (lin_decimal_t)beta;
+
+        // w = v^T * A[j:m, j+1:end], then A -= tau * v * w
+        size_t const end = j0 + jb;
+        for (size_t c = j + 1; c < end; c++) {
+            w[c] = a[(j * lda) + c];
+        }
+        for (size_t i = j + 1; i < m; i++) {
+            lin_decimal_t const v_i = a[(i * lda) + j];
+            for (size_t c = j + 1; c < end; c++) {
+                w[c] += v_i * a[(i * lda) + c];
+            }
+        }
+        for (size_t c = j + 1; c < end; c++) {
+            a[(j * lda) + c] -= tau[j] * w[c];
+        }
+        for (size_t i = j + 1; i < m; i++) {
+            lin_decimal_t const v_i = tau[j] * a[(i * lda) + j];
+            for (size_t c = j + 1; c < end; c++) {
+                a[(i * lda) + c] -= v_i * w[c];
+            }
+        }
+    }
+}
+
+// Applies Q (or Q^T) to `b` in place, block by block
+static bool _lin_qr_apply(lin_mat_qr_t const *qr, lin_mat_t *b, bool transpose) {
+    size_t const m = qr->qr->shape.rows;
+    size_t const k = qr->tau->dim;
+    size_t const nb = LIN_QR_BLOCK;
+
+    lin_decimal_t *v = (lin_decimal_t *)malloc(
+        ((m * nb) + (nb * nb)) * sizeof(lin_decimal_t)
+    );
+    if (v == NULL) {
+        LIN_LOG_ERROR("Failed to allocate QR workspace");
+        return false;
+    }
+    lin_decimal_t *t = &v[m * nb];
+
+    size_t const blocks = (k + nb - 1) / nb;
+    for (size_t blk = 0; blk < blocks; blk++) {
+        // Q^T = H_{k-1} * ... * H_0 applies the first block first
+        size_t const j0 = (transpose ? blk : blocks - 1 - blk) * nb;
+        size_t const jb = _lin_min(nb, k - j0);
+
+        _lin_qr_block_v(qr->qr, j0, jb, v);
+        _lin_qr_block_t(v, m - j0, jb, &qr->tau->elements[j0], t);
+        if (!_lin_qr_block_apply(v, t, m - j0, jb, transpose,
+                                 &b->elements[j0 * b->shape.columns],
+                                 b->shape.columns, b->shape.columns)) {
+            free(v);
+            return false;
+        }
+    }
+
+    free(v);
+    return true;
+}
+
+lin_mat_qr_t *lin_mat_qr(lin_mat_t const *a) {
+    _LIN_TRACE(_LIN_MAT_DIMS(a), _LIN_NO_DIMS);
+    size_t const m = a->shape.rows;
+    size_t const n = a->shape.columns;
+    size_t const k = _lin_min(m, n);
+    size_t const nb = LIN_QR_BLOCK;
+
+    lin_mat_qr_t *res = (lin_mat_qr_t *)malloc(sizeof(lin_mat_qr_t));
+    if (res == NULL) {
+        LIN_LOG_ERROR("Failed to allocate memory for lin_mat_qr_t");
+        return NULL;
+    }
+    res->qr = _lin_mat_dup(a);
+    res->tau = lin_vec_create(k);
+
+    lin_decimal_t *work = (lin_decimal_t *)malloc(
+        (n + (m * nb) + (nb * nb)) * sizeof(lin_decimal_t)
+    );
+    if (res->qr == NULL || res->tau == NULL || work == NULL) {
+        LIN_LOG_ERROR("Failed to allocate QR workspace");
+        free(work);
+        lin_mat_qr_free(res);
+        return NULL;
+    }
+    lin_decimal_t *v = &work[n];
+    lin_decimal_t *t = &v[m * nb];
+
+    for (size_t j0 = 0; j0 < k; j0 += nb) {
+        size_t const jb = _lin_min(nb, k - j0);
+        _lin_qr_panel(res->qr, res->tau->elements, j0, jb, work);
+
+        if (j0 + jb >= n) {
+            continue;
+        }
+
+        // A[j0:m, j0+jb:n] = (I - V * T^T * V^T) * A[j0:m, j0+jb:n]
+        _lin_qr_block_v(res->qr, j0, jb, v);
+        _lin_qr_block_t(v, m - j0, jb, &res->tau->elements[j0], t);
+        if (!_lin_qr_block_apply(v, t, m - j0, jb, true,
+                                 &res->qr->elements[(j0 * n) + j0 + jb], n,
+                                 n - j0 - jb)) {
+            free(work);
+            lin_mat_qr_free(res);
+            return NULL;
+        }
+    }
+
+    free(work);
+    return res;
+}
+
+/// Where the output is the [min(m, n) x n] upper triangular factor
+lin_mat_t *lin_mat_qr_r(lin_mat_qr_t const *qr) {
+    _LIN_TRACE(_LIN_MAT_DIMS((qr)->qr), _LIN_NO_DIMS);
+    size_t const k = qr->tau->dim;
+    size_t const n = qr->qr->shape.columns;
+    lin_mat_t *res = lin_mat_create((lin_mat_shape_t){k, n});
+
+    for (size_t row = 0; row < k; row++) {
+        for (size_t col = 0; col < n; col++) {
+            res->elements[(row * n) + col] = col < row
+                ? (lin_decimal_t)0 : qr->qr->elements[(row * n) + col];
+        }
+    }
+
+    return res;
+}
+
+lin_mat_t *lin_mat_qr_q_mult(lin_mat_qr_t const *qr, lin_mat_t const *b) {
+    _LIN_TRACE(_LIN_MAT_DIMS((qr)->qr), _LIN_MAT_DIMS(b));
+    if (qr->qr->shape.rows != b->shape.rows) {
+        LIN_LOG_ERROR(
+            "Dimension mismatch while applying Q [%zu x %zu] [%zu x %zu]",
+            qr->qr->shape.rows, qr->qr->shape.rows,
+            b->shape.rows, b->shape.columns
+        );
+        exit(EXIT_FAILURE);
+    }
+
+    lin_mat_t *res = _lin_mat_dup(b);
+    if (!_lin_qr_apply(qr, res, false)) {
+        lin_mat_free(res);
+        return NULL;
+    }
+
+    return res;
+}
+
+lin_mat_t *lin_mat_qr_qt_mult(lin_mat_qr_t const *qr, lin_mat_t const *b) {
+    _LIN_TRACE(_LIN_MAT_DIMS((qr)->qr), _LIN_MAT_DIMS(b));
+    if (qr->qr->shape.rows != b->shape.rows) {
+        LIN_LOG_ERROR(
+            "Dimension mismatch while applying Q^T [%zu x %zu] [%zu x %zu]",
+            qr->qr->shape.rows, qr->qr->shape.rows,
+            b->shape.rows, b->shape.columns
+        );
+        exit(EXIT_FAILURE);
+    }
+
+    lin_mat_t *res = _lin_mat_dup(b);
+    if (!_lin_qr_apply(qr, res, true)) {
+        lin_mat_free(res);
+        return NULL;
+    }
+
+    return res;
+}
+
+/// Minimizes ||a * x - b|| for an [m x n] matrix `a` with m >= n and full
+/// column rank. Returns NULL if `a` is rank deficient.
+lin_mat_t *lin_mat_lstsq(lin_mat_t const *a, lin_mat_t const *b) {
+    _LIN_TRACE(_LIN_MAT_DIMS(a), _LIN_MAT_DIMS(b));
+    if (a->shape.rows != b->shape.rows) {
+        LIN_LOG_ERROR(
+            "Dimension mismatch during least squares [%zu x %zu] [%zu x %zu]",
+            a->shape.rows, a->shape.columns, b->shape.rows, b->shape.columns
+        );
+        exit(EXIT_FAILURE);
+    }
+
+    if (a->shape.rows < a->shape.columns) {
+        LIN_LOG_ERROR(
+            "Cannot solve underdetermined least squares system [%zu x %zu]",
+            a->shape.rows, a->shape.columns
+        );
+        exit(EXIT_FAILURE);
+    }
+
+    size_t const n = a->shape.columns;
+    size_t const p = b->shape.columns;
+
+    lin_mat_qr_t *qr = lin_mat_qr(a);
+    if (qr == NULL) {
+        return NULL;
+    }
+
+    lin_mat_t *y = lin_mat_qr_qt_mult(qr, b);
+    if (y == NULL) {
+        lin_mat_qr_free(qr);
+        return NULL;
+    }
+
+    // diagonal entries of R this small relative to the largest one mean the
+    // columns of `a` are linearly dependent to working precision
+    lin_decimal_t const *r = qr->qr->elements;
+    lin_decimal_t max_diag = 0;
+    for (size_t row = 0; row < n; row++) {
+        lin_decimal_t const diag = (lin_decimal_t)fabs((double)r[(row * n) + row]);
+        max_diag = diag > max_diag ? diag : max_diag;
+    }
+    lin_decimal_t const tol = max_diag * LIN_EPSILON * (lin_decimal_t)a->shape.rows;
+
+    for (size_t row = 0; row < n; row++) {
+        if ((lin_decimal_t)fabs((double)r[(row * n) + row]) <= tol) {
+            LIN_LOG_ERROR(
+                "Cannot solve least squares for rank deficient matrix [%zu x %zu]",
+                a->shape.rows, a->shape.columns
+            );
+            lin_mat_free(y);
+            lin_mat_qr_free(qr);
+            return NULL;
+        }
+    }
+
+    // back substitution on R[0:n, 0:n] * x = y[0:n, :]
+    _lin_tri_view_t const view = {r, n, n, true, false, false};
+    _lin_trsm(&view, p, y->elements, p);
+
+    // the solution occupies the first n rows of y
+    lin_mat_t *res = lin_mat_create_from_array((lin_mat_shape_t){n, p},
+                                               y->elements);
+    lin_mat_free(y);
+    lin_mat_qr_free(qr);
+    return res;
+}
+
+void lin_mat_qr_free(lin_mat_qr_t *qr) {
+    _LIN_TRACE(_LIN_NO_DIMS, _LIN_NO_DIMS);
+    if (qr == NULL) {
+        return;
+    }
+
+    lin_mat_free(qr->qr);
+    lin_vec_free(qr->tau);
+    free(qr);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// CHOLESKY DECLARATION
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef LIN_CHOLESKY_BLOCK
+#define LIN_CHOLESKY_BLOCK 32
+#endif
+
+bool lin_mat_cholesky(lin_mat_t *a);
+lin_mat_t *lin_mat_cholesky_solve(lin_mat_t const *l, lin_mat_t const *b);
+lin_decimal_t lin_mat_cholesky_logdet(lin_mat_t const *l);
+lin_mat_t *lin_mat_spd_solve(lin_mat_t const *a, lin_mat_t const *b);
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// CHOLESKY IMPLEMENTATION
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Unblocked factorization of the diagonal block [k0, k1), which has already
+// received the updates from all previous blocks
+static bool _lin_cholesky_block(lin_decimal_t *a, size_t lda, size_t k0,
+                                size_t k1) {
+    for (size_t j = k0; j < k1; j++) {
+        lin_decimal_t *a_j = &a[j * lda];
+        lin_decimal_t d = a_j[j];
+        for (size_t q = k0; q < j; q++) {
+            d -= a_j[q] * a_j[q];
+        }
+
+        // also rejects NaN
+        if (!(d > (lin_decimal_t)0)) {
+            LIN_LOG_ERROR(
+                "Matrix is not positive definite (leading minor of order %zu)",
+                j + 1
+            );
+            return false;
+        }
+
+        lin_decimal_t const l_jj = (lin_decimal_t)sqrt((double)d);
+        a_j[j] = l_jj;
+
+        for (size_t i = j + 1; i < k1; i++) {
+            lin_decimal_t *a_i = &a[i * lda];
+            lin_decimal_t sum = a_i[j];
+            for (size_t q = k0; q < j; q++) {
+                sum -= a_i[q] * a_j[q];
+            }
+            a_i[j] = sum / l_jj;
+        }
+    }
+
+    return true;
+}
+
+/// Overwrites the symmetric positive definite matrix `a` with its lower
+/// triangular Cholesky factor L such that a = L * L^T. Only the lower triangle
+/// of `a` is read. Returns false, leaving `a` partially overwritten, if `a` is
+/// not positive definite.
+bool lin_mat_cholesky(lin_mat_t *a) {
+    _LIN_TRACE(_LIN_MAT_DIMS(a), _LIN_NO_DIMS);
+    if (a->shape.rows != a->shape.columns) {
+        LIN_LOG_ERROR(
+            "Cannot take Cholesky factorization of non-square matrix [%zu x %zu]",
+            a->shape.rows, a->shape.columns
+        );
+        exit(EXIT_FAILURE);
+    }
+
+    // the factor is written in place in row-major order
+    if (!lin_mat_set_layout(a, LIN_ROW_MAJOR)) {
+        return false;
+    }
+
+    size_t const n = a->shape.rows;
+    size_t const nb = LIN_CHOLESKY_BLOCK;
+    lin_decimal_t *el = a->elements;
+    lin_mat_touch(a);
+
+    for (size_t k0 = 0; k0 < n; k0 += nb) {
+        size_t const k1 = _lin_min(k0 + nb, n);
+
+        if (!_lin_cholesky_block(el, n, k0, k1)) {
+            return false;
+        }
+
+        // L21 = A21 * L11^-T, one row at a time by forward substitution
+        for (size_t i = k1; i < n; i++) {
+            lin_decimal_t *a_i = &el[i * n];
+            for (size_t j = k0; j < k1; j++) {
+                lin_decimal_t const *l_j = &el[j * n];
+                lin_decimal_t sum = a_i[j];
+                for (size_t q = k0; q < j; q++) {
+                    sum -= a_i[q] * l_j[q];
+                }
+                a_i[j] = sum / l_j[j];
+            }
+        }
+
+        // A22 -= L21 * L21^T, lower triangle only (block rows up to diagonal)
+        for (size_t i0 = k1; i0 < n; i0 += nb) {
+            size_t const i1 = _lin_min(i0 + nb, n);
+            _lin_gemm(false, true, i1 - i0, i1 - k1, k1 - k0, -1,
+                      &el[(i0 * n) + k0], n, &el[(k1 * n) + k0], n,
+                      1, &el[(i0 * n) + k1], n);
+        }
+    }
+
+    for (size_t row = 0; row < n; row++) {
+        for (size_t col = row + 1; col < n; col++) {
+            el[(row * n) + col] = (lin_decimal_t)0;
+        }
+    }
+
+    return true;
+}
+
+/// Solves a * x = b given the Cholesky factor `l` of a
+lin_mat_t *lin_mat_cholesky_solve(lin_mat_t const *l, lin_mat_t const *b) {
+    _LIN_TRACE(_LIN_MAT_DIMS(l), _LIN_MAT_DIMS(b));
+    if (l->shape.rows != l->shape.columns || l->shape.rows != b->shape.rows) {
+        LIN_LOG_ERROR(
+            "Dimension mismatch during Cholesky solve [%zu x %zu] [%zu x %zu]",
+            l->shape.rows, l->shape.columns, b->shape.rows, b->shape.columns
+        );
+        exit(EXIT_FAILURE);
+    }
+
+    size_t const n = l->shape.rows;
+    size_t const p = b->shape.columns;
+    lin_mat_t *res = _lin_mat_dup(b);
+    lin_decimal_t *x = res->elements;
+
+    // L * y = b, then L^T * x = y. Column-major storage holds L^T.
+    bool const col = l->layout == LIN_COL_MAJOR;
+    _lin_tri_view_t view = {l->elements, n, n, col, col, false};
+    _lin_trsm(&view, p, x, p);
+    view.trans = !col;
+    _lin_trsm(&view, p, x, p);
+
+    return res;
+}
+
+/// Log-determinant of a given its Cholesky factor `l`
+lin_decimal_t lin_mat_cholesky_logdet(lin_mat_t const *l) {
+    _LIN_TRACE(_LIN_MAT_DIMS(l), _LIN_NO_DIMS);
+    if (l->shape.rows != l->shape.columns) {
+        LIN_LOG_ERROR(
+            "Cannot take determinant of non-square matrix [%zu x %zu]",
+            l->shape.rows, l->shape.columns
+        );
+        exit(EXIT_FAILURE);
+    }
+
+    double sum = 0;
+    for (size_t i = 0; i < l->shape.rows; i++) {
+        sum += log((double)l->elements[(i * l->shape.columns) + i]);
+    }
+
+    return (lin_decimal_t)(2.0 * sum);
+}
+
+/// Solves a * x = b for symmetric positive definite `a`. Returns NULL if `a`
+/// is not positive definite.
+lin_mat_t *lin_mat_spd_solve(lin_mat_t const *a, lin_mat_t const *b) {
+    _LIN_TRACE(_LIN_MAT_DIMS(a), _LIN_MAT_DIMS(b));
+    lin_mat_t *l = _lin_mat_dup(a);
+    if (!lin_mat_cholesky(l)) {
+        lin_mat_free(l);
+        return NULL;
+    }
+
+    lin_mat_t *res = lin_mat_cholesky_solve(l, b);
+    lin_mat_free(l);
+    return res;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// LU DECLARATION
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// LU factorization with partial pivoting, P * a = L * U. L (unit lower
+// triangular, diagonal not stored) and U share `lu`, row i of P * a is row
+// perm[i] of a, and `sign` is the determinant of P.
+typedef struct {
+    lin_mat_t *lu;
+    size_t *perm;
+    int sign;
+} lin_mat_lu_t;
+
+lin_mat_lu_t *lin_mat_lu(lin_mat_t const *a);
+lin_mat_t *lin_mat_lu_solve(lin_mat_lu_t const *lu, lin_mat_t const *b);
+lin_decimal_t lin_mat_lu_det(lin_mat_lu_t const *lu);
+void lin_mat_lu_free(lin_mat_lu_t *lu);
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// LU IMPLEMENTATION
+//
+///////////////////////////////////////////////////////////////////////////////
+
+static lin_mat_lu_t *_lin_mat_lu(lin_mat_t const *a, bool log_singular) {
+    if (a->shape.rows != a->shape.columns) {
+        LIN_LOG_ERROR(
+            "Cannot take LU factorization of non-square matrix [%zu x %zu]",
+            a->shape.rows, a->shape.columns
+        );
+        exit(EXIT_FAILURE);
+    }
+
+    size_t const n = a->shape.rows;
+    lin_mat_lu_t *res = (lin_mat_lu_t *)malloc(sizeof(lin_mat_lu_t));
+    if (res == NULL) {
+        LIN_LOG_ERROR("Failed to allocate memory for lin_mat_lu_t");
+        return NULL;
+    }
+    res->lu = _lin_mat_dup(a);
+    res->perm = (size_t *)malloc(n * sizeof(size_t));
+    res->sign = 1;
+    if (res->perm == NULL) {
+        LIN_LOG_ERROR("Failed to allocate memory for LU permutation");
+        lin_mat_lu_free(res);
+        return NULL;
+    }
+
+    lin_decimal_t *el = res->lu->elements;
+    for (size_t i = 0; i < n; i++) {
+        res->perm[i] = i;
+    }
+
+    for (size_t k = 0; k < n; k++) {
+        size_t pivot = k;
+        lin_decimal_t pivot_abs = (lin_decimal_t)fabs((double)el[(k * n) + k]);
+        for (size_t i = k + 1; i < n; i++) {
+            lin_decimal_t const el_abs = (lin_decimal_t)fabs((double)el[(i * n) + k]);
+            if (el_abs > pivot_abs) {
+                pivot = i;
+                pivot_abs = el_abs;
+            }
+        }
+
+        if (pivot_abs == (lin_decimal_t)0) {
+            if (log_singular) {
+                LIN_LOG_ERROR("Cannot take LU factorization of singular matrix");
+            }
+            lin_mat_lu_free(res);
+            return NULL;
+        }
+
+        if (pivot != k) {
+            for (size_t j = 0; j < n; j++) {
+                lin_decimal_t const tmp = el[(k * n) + j];
+                el[(k * n) + j] = el[(pivot * n) + j];
+                el[(pivot * n) + j] = tmp;
+            }
+            size_t const tmp = res->perm[k];
+            res->perm[k] = res->perm[pivot];
+            res->perm[pivot] = tmp;
+            res->sign = -res->sign;
+        }
+
+        lin_decimal_t const *u_k = &el[k * n];
+        for (size_t i = k + 1; i < n; i++) {
+            lin_decimal_t *row = &el[i * n];
+            row[k] /= u_k[k];
+            _lin_axpy(n - k - 1, -row[k], &u_k[k + 1], &row[k + 1]);
+        }
+    }
+
+    return res;
+}
+
+/// Returns NULL if `a` is singular
+lin_mat_lu_t *lin_mat_lu(lin_mat_t const *a) {
+    _LIN_TRACE(_LIN_MAT_DIMS(a), _LIN_NO_DIMS);
+    return _lin_mat_lu(a, true);
+}
+
+lin_mat_t *lin_mat_lu_solve(lin_mat_lu_t const *lu, lin_mat_t const *b) {
+    _LIN_TRACE(_LIN_MAT_DIMS((lu)->lu), _LIN_MAT_DIMS(b));
+    size_t const n = lu->lu->shape.rows;
+    if (n != b->shape.rows) {
+        LIN_LOG_ERROR(
+            "Dimension mismatch during LU solve [%zu x %zu] [%zu x %zu]",
+            n, n, b->shape.rows, b->shape.columns
+        );
+        exit(EXIT_FAILURE);
+    }
+
+    if (b->layout == LIN_COL_MAJOR) {
+        lin_mat_t *rows_copy;
+        lin_mat_t const *rows = _lin_mat_rows(b, &rows_copy);
+        lin_mat_t *res = lin_mat_lu_solve(lu, rows);
+        lin_mat_free(rows_copy);
+        return res;
+    }
+
+    size_t const p = b->shape.columns;
+    lin_mat_t *res = lin_mat_create(b->shape);
+    if (res == NULL) {
+        return NULL;
+    }
+    lin_decimal_t *x = res->elements;
+    lin_decimal_t const *el = lu->lu->elements;
+
+    for (size_t i = 0; i < n; i++) {
+        memcpy(&x[i * p], &b->elements[lu->perm[i] * p],
+               p * sizeof(lin_decimal_t));
+    }
+
+    // L * y = P * b, then U * x = y
+    _lin_tri_view_t view = {el, n, n, false, false, true};
+    _lin_trsm(&view, p, x, p);
+    view.upper = true;
+    view.unit = false;
+    _lin_trsm(&view, p, x, p);
+
+    return res;
+}
+
+lin_decimal_t lin_mat_lu_det(lin_mat_lu_t const *lu) {
+    _LIN_TRACE(_LIN_MAT_DIMS((lu)->lu), _LIN_NO_DIMS);
+    size_t const n = lu->lu->shape.rows;
+    lin_decimal_t det = (lin_decimal_t)lu->sign;
+    for (size_t i = 0; i < n; i++) {
+        det *= lu->lu->elements[(i * n) + i];
+    }
+
+    return det;
+}
+
+void lin_mat_lu_free(lin_mat_lu_t *lu) {
+    _LIN_TRACE(_LIN_NO_DIMS, _LIN_NO_DIMS);
+    if (lu == NULL) {
+        return;
+    }
+
+    lin_mat_free(lu->lu);
+    free(lu->perm);
+    free(lu);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// BANDED DECLARATION
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Banded [n x n] matrix with `lower` subdiagonals and `upper` superdiagonals.
+// Row i is stored in `lower + upper + 1` consecutive elements holding columns
+// i - lower .. i + upper, the slots falling outside the matrix are kept zero.
+typedef struct {
+    size_t n;
+    size_t lower;
+    size_t upper;
+    lin_decimal_t *elements;
+    size_t capacity;
+    _Alignas(LIN_ALIGNMENT) lin_decimal_t data[];
+} lin_band_t;
+
+// Banded LU factorization with partial pivoting. U has `lower + upper`
+// superdiagonals from the row swaps, and the multipliers of L are kept below
+// the diagonal in the order they were applied. At step k row k was swapped
+// with row `piv[k]`.
+typedef struct {
+    lin_band_t *lu;
+    size_t *piv;
+} lin_band_lu_t;
+
+lin_band_t *lin_band_create(size_t n, size_t lower, size_t upper);
+lin_band_t *lin_band_from_mat(lin_mat_t const *a, size_t lower, size_t upper);
+lin_mat_t *lin_band_to_mat(lin_band_t const *a);
+lin_decimal_t lin_band_get(lin_band_t const *a, size_t row, size_t column);
+void lin_band_set(lin_band_t *a, size_t row, size_t column, lin_decimal_t value);
+lin_vec_t *lin_band_vec_mult(lin_band_t const *a, lin_vec_t const *x);
+lin_band_lu_t *lin_band_lu(lin_band_t const *a);
+lin_mat_t *lin_band_lu_solve(lin_band_lu_t const *lu, lin_mat_t const *b);
+lin_mat_t *lin_band_solve(lin_band_t const *a, lin_mat_t const *b);
+void lin_band_free(lin_band_t *a);
+void lin_band_lu_free(lin_band_lu_t *lu);
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// BANDED IMPLEMENTATION
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Pointer `p` such that p[j] is element (i, j) for every column j in the band
+static inline lin_decimal_t *_lin_band_row(lin_band_t const *a, size_t i) {
+    size_t const width = a->lower + a->upper + 1;
+    return &a->elements[(i * width) + a->lower - i];
+}
+
+static inline bool _lin_band_contains(lin_band_t const *a, size_t row,
+                                      size_t column) {
+    return column + a->lower >= row && column <= row + a->upper;
+}
+
+lin_band_t *lin_band_create(size_t n, size_t lower, size_t upper) {
+    _LIN_TRACE(_LIN_DIMS(n, n), _LIN_DIMS(lower, upper));
+    size_t width, bytes, block_bytes;
+    lin_band_t *a = !__builtin_add_overflow(lower, upper, &width)
+        && width < SIZE_MAX
+        && _lin_alloc_bytes(sizeof(lin_band_t), n, width + 1, &bytes)
+        ? (lin_band_t *)_lin_pool_alloc(bytes, &block_bytes) : NULL;
+    if (a == NULL) {
+        LIN_LOG_ERROR(
+            "Failed to allocate memory for banded matrix [%zu x %zu] (%zu, %zu)",
+            n, n, lower, upper
+        );
+        return NULL;
+    }
+
+    a->n = n;
+    a->lower = lower;
+    a->upper = upper;
+    a->elements = a->data;
+    a->capacity = (block_bytes - sizeof(lin_band_t)) / sizeof(lin_decimal_t);
+    memset(a->elements, 0, n * (lower + upper + 1) * sizeof(lin_decimal_t));
+    return a;
+}
+
+/// Band of the square matrix a, elements outside of it are dropped
+lin_band_t *lin_band_from_mat(lin_mat_t const *a, size_t lower, size_t upper) {
+    _LIN_TRACE(_LIN_MAT_DIMS(a), _LIN_DIMS(lower, upper));
+    if (a->shape.rows != a->shape.columns) {
+        LIN_LOG_ERROR("Cannot take band of non-square matrix [%zu x %zu]",
+                      a->shape.rows, a->shape.columns);
+        exit(EXIT_FAILURE);
+    }
+
+    size_t const n = a->shape.rows;
+    lin_band_t *res = lin_band_create(n, lower, upper);
+    if (res == NULL) {
+        return NULL;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        lin_decimal_t *row = _lin_band_row(res, i);
+        size_t const j0 = i > lower ? i - lower : 0;
+        size_t const j1 = _lin_min(n, i + upper + 1);
+        for (size_t j = j0; j < j1; j++) {
+            row[j] = a->elements[_lin_mat_index(a, i, j)];
+        }
+    }
+
+    return res;
+}
+
+lin_mat_t *lin_band_to_mat(lin_band_t const *a) {
+    _LIN_TRACE(_LIN_DIMS(a->n, a->n), _LIN_DIMS(a->lower, a->upper));
+    size_t const n = a->n;
+    lin_mat_t *res = lin_mat_create((lin_mat_shape_t){n, n});
+    if (res == NULL) {
+        return NULL;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < n; j++) {
+            res->elements[(i * n) + j] = lin_band_get(a, i, j);
+        }
+    }
+
+    return res;
+}
+
+lin_decimal_t lin_band_get(lin_band_t const *a, size_t row, size_t column) {
+    if (!_lin_band_contains(a, row, column)) {
+        return (lin_decimal_t)0;
+    }
+
+    return _lin_band_row(a, row)[column];
+}
+
+void lin_band_set(lin_band_t *a, size_t row, size_t column, lin_decimal_t value) {
+    if (row >= a->n || column >= a->n || !_lin_band_contains(a, row, column)) {
+        LIN_LOG_ERROR(
+            "Element (%zu, %zu) is outside of banded matrix [%zu x %zu] (%zu, %zu)",
+            row, column, a->n, a->n, a->lower, a->upper
+        );
+        exit(EXIT_FAILURE);
+    }
+
+    _lin_band_row(a, row)[column] = value;
+}
+
+typedef struct {
+    lin_band_t const *a;
+    lin_decimal_t const *x;
+    lin_decimal_t *y;
+} _lin_gbmv_ctx_t;
+
+// y[begin:end] = A[begin:end, :] * x, one dot product over the band per row
+static void _lin_gbmv_rows(void *ctx, size_t chunk, size_t begin, size_t end) {
+    (void)chunk;
+    _lin_gbmv_ctx_t const *g = (_lin_gbmv_ctx_t const *)ctx;
+    size_t const n = g->a->n;
+    for (size_t i = begin; i < end; i++) {
+        size_t const j0 = i > g->a->lower ? i - g->a->lower : 0;
+        size_t const j1 = _lin_min(n, i + g->a->upper + 1);
+        g->y[i] = _lin_dot(&_lin_band_row(g->a, i)[j0], &g->x[j0], j1 - j0);
+    }
+}
+
+lin_vec_t *lin_band_vec_mult(lin_band_t const *a, lin_vec_t const *x) {
+    _LIN_TRACE(_LIN_DIMS(a->n, a->n), _LIN_VEC_DIMS(x));
+    if (a->n != x->dim) {
+        LIN_LOG_ERROR(
+            "Dimension mismatch during banded matrix-vector multiplication [%zu x %zu] (%zu)",
+            a->n, a->n, x->dim
+        );
+        exit(EXIT_FAILURE);
+    }
+
+    lin_vec_t *res = lin_vec_create(a->n);
+    if (res == NULL) {
+        return NULL;
+    }
+
+    _lin_gbmv_ctx_t ctx = {a, x->elements, res->elements};
+    _lin_parallel_for(a->n, a->lower + a->upper + 1, _lin_gbmv_rows, &ctx);
+
+    return res;
+}
+
+/// Returns NULL if `a` is singular
+lin_band_lu_t *lin_band_lu(lin_band_t const *a) {
+    _LIN_TRACE(_LIN_DIMS(a->n, a->n), _LIN_DIMS(a->lower, a->upper));
+    size_t const n = a->n;
+    size_t const kl = a->lower;
+    size_t const ku = a->lower + a->upper;
+
+    lin_band_lu_t *res = (lin_band_lu_t *)malloc(sizeof(lin_band_lu_t));
+    if (res == NULL) {
+        LIN_LOG_ERROR("Failed to allocate memory for lin_band_lu_t");
+        return NULL;
+    }
+    res->lu = lin_band_create(n, kl, ku);
+    res->piv = (size_t *)malloc((n == 0 ? 1 : n) * sizeof(size_t));
+    if (res->lu == NULL || res->piv == NULL) {
+        LIN_LOG_ERROR("Failed to allocate memory for banded LU factorization");
+        lin_band_lu_free(res);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        lin_decimal_t const *src = _lin_band_row(a, i);
+        lin_decimal_t *dst = _lin_band_row(res->lu, i);
+        size_t const j0 = i > kl ? i - kl : 0;
+        size_t const j1 = _lin_min(n, i + a->upper + 1);
+        for (size_t j = j0; j < j1; j++) {
+            dst[j] = src[j];
+        }
+    }
+
+    for (size_t k = 0; k < n; k++) {
+        size_t const r1 = _lin_min(n, k + kl + 1);
+        size_t const j1 = _lin_min(n, k + ku + 1);
+
+        size_t pivot = k;
+        lin_decimal_t pivot_abs =
+            (lin_decimal_t)fabs((double)_lin_band_row(res->lu, k)[k]);
+        for (size_t r = k + 1; r < r1; r++) {
+            lin_decimal_t const el_abs =
+                (lin_decimal_t)fabs((double)_lin_band_row(res->lu, r)[k]);
+            if (el_abs > pivot_abs) {
+                pivot = r;
+                pivot_abs = el_abs;
+            }
+        }
+
+        if (pivot_abs == (lin_decimal_t)0) {
+            LIN_LOG_ERROR("Cannot take LU factorization of singular banded matrix");
+            lin_band_lu_free(res);
+            return NULL;
+        }
+
+        res->piv[k] = pivot;
+        lin_decimal_t *u_k = _lin_band_row(res->lu, k);
+        if (pivot != k) {
+            // earlier multipliers stay in place, only columns k.. move
+            lin_decimal_t *u_p = _lin_band_row(res->lu, pivot);
+            for (size_t j = k; j < j1; j++) {
+                lin_decimal_t const tmp = u_k[j];
+                u_k[j] = u_p[j];
+                u_p[j] = tmp;
+            }
+        }
+
+        for (size_t r = k + 1; r < r1; r++) {
+            lin_decimal_t *row = _lin_band_row(res->lu, r);
+            row[k] /= u_k[k];
+            _lin_axpy(j1 - k - 1, -row[k], &u_k[k + 1], &row[k + 1]);
+        }
+    }
+
+    return res;
+}
+
+lin_mat_t *lin_band_lu_solve(lin_band_lu_t const *lu, lin_mat_t const *b) {
+    _LIN_TRACE(_LIN_DIMS((lu)->lu->n, (lu)->lu->n), _LIN_MAT_DIMS(b));
+    size_t const n = lu->lu->n;
+    if (n != b->shape.rows) {
+        LIN_LOG_ERROR(
+            "Dimension mismatch during banded LU solve [%zu x %zu] [%zu x %zu]",
+            n, n, b->shape.rows, b->shape.columns
+        );
+        exit(EXIT_FAILURE);
+    }
+
+    size_t const p = b->shape.columns;
+    size_t const kl = lu->lu->lower;
+    size_t const ku = lu->lu->upper;
+    lin_mat_t *res = _lin_mat_dup(b);
+    if (res == NULL) {
+        return NULL;
+    }
+    lin_decimal_t *x = res->elements;
+
+    // L * y = P * b, applying the swaps and multipliers step by step
+    for (size_t k = 0; k < n; k++) {
+        size_t const pivot = lu->piv[k];
+        if (pivot != k) {
+            for (size_t col = 0; col < p; col++) {
+                lin_decimal_t const tmp = x[(k * p) + col];
+                x[(k * p) + col] = x[(pivot * p) + col];
+                x[(pivot * p) + col] = tmp;
+            }
+        }
+
+        size_t const r1 = _lin_min(n, k + kl + 1);
+        for (size_t r = k + 1; r < r1; r++) {
+            _lin_axpy(p, -_lin_band_row(lu->lu, r)[k], &x[k * p], &x[r * p]);
+        }
+    }
+
+    // U * x = y
+    for (size_t i = n; i-- > 0;) {
+        lin_decimal_t const *u_i = _lin_band_row(lu->lu, i);
+        size_t const j1 = _lin_min(n, i + ku + 1);
+        for (size_t j = i + 1; j < j1; j++) {
+            _lin_axpy(p, -u_i[j], &x[j * p], &x[i * p]);
+        }
+        _lin_scale(p, (lin_decimal_t)1 / u_i[i], &x[i * p]);
+    }
+
+    return res;
+}
+
+// Thomas algorithm for a diagonally dominant tridiagonal `a`, solving in
+// place on the [n x p] right-hand sides `x`. Returns false, leaving `x`
+// partially updated, when `a` is not dominant or a pivot vanishes.
+static bool _lin_band_thomas(lin_band_t const *a, lin_decimal_t *x, size_t p) {
+    size_t const n = a->n;
+    for (size_t i = 0; i < n; i++) {
+        lin_decimal_t const *row = _lin_band_row(a, i);
+        lin_decimal_t off = 0;
+        if (i > 0) {
+            off += (lin_decimal_t)fabs((double)row[i - 1]);
+        }
+        if (i + 1 < n) {
+            off += (lin_decimal_t)fabs((double)row[i + 1]);
+        }
+        lin_decimal_t const diag = (lin_decimal_t)fabs((double)row[i]);
+        if (diag == (lin_decimal_t)0 || diag < off) {
+            return false;
+        }
+    }
+
+    // the modified superdiagonal
+    lin_decimal_t *c = (lin_decimal_t *)malloc(
+        (n == 0 ? 1 : n) * sizeof(lin_decimal_t)
+    );
+    if (c == NULL) {
+        return false;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        lin_decimal_t const *row = _lin_band_row(a, i);
+        lin_decimal_t m = row[i];
+        if (i > 0) {
+            m -= row[i - 1] * c[i - 1];
+            _lin_axpy(p, -row[i - 1], &x[(i - 1) * p], &x[i * p]);
+        }
+        if (m == (lin_decimal_t)0) {
+            free(c);
+            return false;
+        }
+        _lin_scale(p, (lin_decimal_t)1 / m, &x[i * p]);
+        c[i] = i + 1 < n ? row[i + 1] / m : (lin_decimal_t)0;
+    }
+
+    for (size_t i = n; i-- > 1;) {
+        _lin_axpy(p, -c[i - 1], &x[i * p], &x[(i - 1) * p]);
+    }
+
+    free(c);
+    return true;
+}
+
+/// Solves a * x = b, with the Thomas algorithm when `a` is a diagonally
+/// dominant tridiagonal matrix and a pivoted banded LU factorization
+/// otherwise. Returns NULL if `a` is singular.
+lin_mat_t *lin_band_solve(lin_band_t const *a, lin_mat_t const *b) {
+    _LIN_TRACE(_LIN_DIMS(a->n, a->n), _LIN_MAT_DIMS(b));
+    if (a->n != b->shape.rows) {
+        LIN_LOG_ERROR(
+            "Dimension mismatch during banded solve [%zu x %zu] [%zu x %zu]",
+            a->n, a->n, b->shape.rows, b->shape.columns
+        );
+        exit(EXIT_FAILURE);
+    }
+
+    if (a->lower == 1 && a->upper == 1) {
+        lin_mat_t *res = _lin_mat_dup(b);
+        if (res == NULL) {
+            return NULL;
+        }
+        if (_lin_band_thomas(a, res->elements, b->shape.columns)) {
+            return res;
+        }
+        lin_mat_free(res);
+    }
+
+    lin_band_lu_t *lu = lin_band_lu(a);
+    if (lu == NULL) {
+        return NULL;
+    }
+
+    lin_mat_t *res = lin_band_lu_solve(lu, b);
+    lin_band_lu_free(lu);
+    return res;
+}
+
+void lin_band_free(lin_band_t *a) {
+    _LIN_TRACE(_LIN_NO_DIMS, _LIN_NO_DIMS);
+    if (a == NULL) {
+        return;
+    }
+
+    _lin_pool_free(a, sizeof(lin_band_t) + (a->capacity * sizeof(lin_decimal_t)));
+}
+
+void lin_band_lu_free(lin_band_lu_t *lu) {
+    _LIN_TRACE(_LIN_NO_DIMS, _LIN_NO_DIMS);
+    if (lu == NULL) {
+        return;
+    }
+
+    lin_band_free(lu->lu);
+    free(lu->piv);
+    free(lu);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// ITERATIVE DECLARATION
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Linear operator given only by its action y = A * x. `ctx` is passed through
+// unchanged, and `y` never aliases `x`.
+typedef void (*lin_op_fn_t)(void *ctx, lin_vec_t const *x, lin_vec_t *y);
+
+// Settings of the iterative solvers, zeroed fields take the defaults. A NULL
+// pointer may be passed for all defaults.
+typedef struct {
+    size_t max_iter;        // operator applications, 0 means 10 * n
+    lin_decimal_t tol;      // on ||b - A * x|| / ||b||, 0 means sqrt(LIN_EPSILON)
+    size_t restart;         // GMRES Krylov dimension, 0 means min(n, 30)
+    lin_vec_t const *diag;  // diagonal of A for Jacobi preconditioning, or NULL
+} lin_iter_opts_t;
+
+typedef struct {
+    size_t iterations;
+    lin_decimal_t residual; // relative residual norm at the last iteration
+    bool converged;
+} lin_iter_info_t;
+
+void lin_op_mat(void *ctx, lin_vec_t const *x, lin_vec_t *y);
+void lin_op_band(void *ctx, lin_vec_t const *x, lin_vec_t *y);
+bool lin_cg(lin_op_fn_t op, void *ctx, lin_vec_t const *b, lin_vec_t *x,
+            lin_iter_opts_t const *opts, lin_iter_info_t *info);
+bool lin_gmres(lin_op_fn_t op, void *ctx, lin_vec_t const *b, lin_vec_t *x,
+               lin_iter_opts_t const *opts, lin_iter_info_t *info);
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// ITERATIVE IMPLEMENTATION
+//
+///////////////////////////////////////////////////////////////////////////////
+
+/// Operator for a dense square `lin_mat_t` passed as `ctx`
+void lin_op_mat(void *ctx, lin_vec_t const *x, lin_vec_t *y) {
+    lin_mat_t const *a = (lin_mat_t const *)ctx;
+    if (a->layout == LIN_COL_MAJOR) {
+        // y = s^T * x over the row-major storage s, a strip of y per thread
+        lin_mat_t s;
+        _lin_mat_storage(a, &s);
+        _lin_gemv_ctx_t g = {&s, x->elements, y->elements};
+        _lin_parallel_run(s.shape.columns,
+                          _lin_parallel_chunks(s.shape.rows, s.shape.columns),
+                          _lin_gemv_t_cols, &g);
+        return;
+    }
+
+    _lin_gemv_ctx_t g = {a, x->elements, y->elements};
+    _lin_parallel_for(a->shape.rows, a->shape.columns, _lin_gemv_rows, &g);
+}
+
+/// Operator for a `lin_band_t` passed as `ctx`
+void lin_op_band(void *ctx, lin_vec_t const *x, lin_vec_t *y) {
+    lin_band_t const *a = (lin_band_t const *)ctx;
+    _lin_gbmv_ctx_t g = {a, x->elements, y->elements};
+    _lin_parallel_for(a->n, a->lower + a->upper + 1, _lin_gbmv_rows, &g);
+}
+
+static void _lin_iter_check(lin_vec_t const *b, lin_vec_t const *x,
+                            lin_iter_opts_t const *opts) {
+    if (b->dim != x->dim
+        || (opts != NULL && opts->diag != NULL && opts->diag->dim != b->dim)) {
+        LIN_LOG_ERROR(
+            "Dimension mismatch during iterative solve (%zu) (%zu)",
+            b->dim, x->dim
+        );
+        exit(EXIT_FAILURE);
+    }
+}
+
+static inline lin_decimal_t _lin_norm(lin_decimal_t const *x, size_t n) {
+    return (lin_decimal_t)sqrt((double)_lin_dot(x, x, n));
+}
+
+// z = M^-1 * r for the Jacobi preconditioner M = diag(A)
+static void _lin_jacobi(lin_vec_t const *diag, lin_decimal_t const *r,
+                        lin_decimal_t *z, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        z[i] = r[i] / diag->elements[i];
+    }
+}
+
+/// Preconditioned conjugate gradient for a symmetric positive definite
+/// operator. `x` holds the initial guess and receives the solution. Returns
+/// whether the tolerance was reached, details go to `info` if not NULL.
+bool lin_cg(lin_op_fn_t op, void *ctx, lin_vec_t const *b, lin_vec_t *x,
+            lin_iter_opts_t const *opts, lin_iter_info_t *info) {
+    _LIN_TRACE(_LIN_VEC_DIMS(b), _LIN_VEC_DIMS(x));
+    _lin_iter_check(b, x, opts);
+
+    size_t const n = b->dim;
+    lin_iter_opts_t const o = opts != NULL ? *opts : (lin_iter_opts_t){0};
+    size_t const max_iter = o.max_iter != 0 ? o.max_iter : 10 * n;
+    lin_decimal_t const tol = o.tol != 0
+        ? o.tol : (lin_decimal_t)sqrt((double)LIN_EPSILON);
+
+    lin_decimal_t const b_norm = _lin_norm(b->elements, n);
+    if (b_norm == (lin_decimal_t)0) {
+        memset(x->elements, 0, n * sizeof(lin_decimal_t));
+        if (info != NULL) {
+            *info = (lin_iter_info_t){0, 0, true};
+        }
+        return true;
+    }
+
+    // r, p, A * p and, when preconditioning, z in one allocation
+    lin_decimal_t *work = (lin_decimal_t *)malloc(
+        ((o.diag != NULL ? 4 : 3) * n + 1) * sizeof(lin_decimal_t)
+    );
+    if (work == NULL) {
+        LIN_LOG_ERROR("Failed to allocate conjugate gradient workspace");
+        return false;
+    }
+    lin_decimal_t *r = work;
+    lin_vec_t p = {n, &work[n], 0, LIN_BORROW, 0};
+    lin_vec_t ap = {n, &work[2 * n], 0, LIN_BORROW, 0};
+    lin_decimal_t *z = o.diag != NULL ? &work[3 * n] : r;
+
+    lin_iter_info_t res = {0, 0, false};
+
+    // r = b - A * x
+    op(ctx, x, &ap);
+    for (size_t i = 0; i < n; i++) {
+        r[i] = b->elements[i] - ap.elements[i];
+    }
+    if (o.diag != NULL) {
+        _lin_jacobi(o.diag, r, z, n);
+    }
+    memcpy(p.elements, z, n * sizeof(lin_decimal_t));
+    lin_decimal_t rz = _lin_dot(r, z, n);
+
+    res.residual = _lin_norm(r, n) / b_norm;
+    while (res.residual > tol && res.iterations < max_iter) {
+        op(ctx, &p, &ap);
+        res.iterations++;
+
+        lin_decimal_t const p_ap = _lin_dot(p.elements, ap.elements, n);
+        if (!(p_ap > (lin_decimal_t)0)) {
+            // the operator is not positive definite along p
+            break;
+        }
+
+        lin_decimal_t const alpha = rz / p_ap;
+        _lin_axpy(n, alpha, p.elements, x->elements);
+        _lin_axpy(n, -alpha, ap.elements, r);
+        res.residual = _lin_norm(r, n) / b_norm;
+
+        if (o.diag != NULL) {
+            _lin_jacobi(o.diag, r, z, n);
+        }
+        lin_decimal_t const rz_next = _lin_dot(r, z, n);
+        lin_decimal_t const beta = rz_next / rz;
+        rz = rz_next;
+
+        // p = z + beta * p
+        for (size_t i = 0; i < n; i++) {
+            p.elements[i] = z[i] + (beta * p.elements[i]);
+        }
+    }
+    res.converged = res.residual <= tol;
+
+    free(work);
+    if (info != NULL) {
+        *info = res;
+    }
+    return res.converged;
+}
+
+/// Restarted GMRES for a general nonsingular operator, with the Jacobi
+/// preconditioner applied on the right. `x` holds the initial guess and
+/// receives the solution. Returns whether the tolerance was reached, details
+/// go to `info` if not NULL.
+bool lin_gmres(lin_op_fn_t op, void *ctx, lin_vec_t const *b, lin_vec_t *x,
+               lin_iter_opts_t const *opts, lin_iter_info_t *info) {
+    _LIN_TRACE(_LIN_VEC_DIMS(b), _LIN_VEC_DIMS(x));
+    _lin_iter_check(b, x, opts);
+
+    size_t const n = b->dim;
+    lin_iter_opts_t const o = opts != NULL ? *opts : (lin_iter_opts_t){0};
+    size_t const max_iter = o.max_iter != 0 ? o.max_iter : 10 * n;
+    lin_decimal_t const tol = o.tol != 0
+        ? o.tol : (lin_decimal_t)sqrt((double)LIN_EPSILON);
+    size_t const m = o.restart != 0 ? o.restart : _lin_min(n == 0 ? 1 : n, 30);
+
+    lin_decimal_t const b_norm = _lin_norm(b->elements, n);
+    if (b_norm == (lin_decimal_t)0) {
+        memset(x->elements, 0, n * sizeof(lin_decimal_t));
+        if (info != NULL) {
+            *info = (lin_iter_info_t){0, 0, true};
+        }
+        return true;
+    }
+
+    // Krylov basis V [(m + 1) x n], Hessenberg H [(m + 1) x m], the Givens
+    // rotations, the rotated residual g and a preconditioned vector z
+    size_t const count = ((m + 1) * n) + ((m + 1) * m) + (2 * m) + (m + 1) + n;
+    lin_decimal_t *work = (lin_decimal_t *)malloc(
+        (count + 1) * sizeof(lin_decimal_t)
+    );
+    if (work == NULL) {
+        LIN_LOG_ERROR("Failed to allocate GMRES workspace");
+        return false;
+    }
+    lin_decimal_t *v = work;
+    lin_decimal_t *h = &v[(m + 1) * n];
+    lin_decimal_t *cs = &h[(m + 1) * m];
+    lin_decimal_t *sn = &cs[m];
+    lin_decimal_t *g = &sn[m];
+    lin_decimal_t *z = &g[m + 1];
+
+    lin_iter_info_t res = {0, 0, false};
+
+    for (;;) {
+        // v_0 = r / ||r|| with r = b - A * x
+        lin_vec_t v_0 = {n, v, 0, LIN_BORROW, 0};
+        op(ctx, x, &v_0);
+        for (size_t i = 0; i < n; i++) {
+            v[i] = b->elements[i] - v[i];
+        }
+        lin_decimal_t const beta = _lin_norm(v, n);
+        res.residual = beta / b_norm;
+        if (res.residual <= tol || res.iterations >= max_iter) {
+            break;
+        }
+        _lin_scale(n, (lin_decimal_t)1 / beta, v);
+        memset(g, 0, (m + 1) * sizeof(lin_decimal_t));
+        g[0] = beta;
+
+        // Arnoldi with modified Gram-Schmidt, keeping H upper triangular
+        // with Givens rotations so the residual norm is |g[j + 1]|
+        size_t k = 0;
+        while (k < m && res.iterations < max_iter) {
+            lin_decimal_t *v_k = &v[k * n];
+            lin_vec_t in = {n, v_k, 0, LIN_BORROW, 0};
+            if (o.diag != NULL) {
+                _lin_jacobi(o.diag, v_k, z, n);
+                in.elements = z;
+            }
+            lin_vec_t w = {n, &v[(k + 1) * n], 0, LIN_BORROW, 0};
+            op(ctx, &in, &w);
+            res.iterations++;
+
+            for (size_t i = 0; i <= k; i++) {
+                lin_decimal_t const h_ik = _lin_dot(w.elements, &v[i * n], n);
+                h[(i * m) + k] = h_ik;
+                _lin_axpy(n, -h_ik, &v[i * n], w.elements);
+            }
+            lin_decimal_t const h_next = _lin_norm(w.elements, n);
+            if (h_next != (lin_decimal_t)0) {
+                _lin_scale(n, (lin_decimal_t)1 / h_next, w.elements);
+            }
+
+            for (size_t i = 0; i < k; i++) {
+                lin_decimal_t const top = h[(i * m) + k];
+                lin_decimal_t const bottom = h[((i + 1) * m) + k];
+                h[(i * m) + k] = (cs[i] * top) + (sn[i] * bottom);
+                h[((i + 1) * m) + k] = (cs[i] * bottom) - (sn[i] * top);
+            }
+
+            lin_decimal_t const h_kk = h[(k * m) + k];
+            lin_decimal_t const denom = (lin_decimal_t)hypot((double)h_kk,
+                                                             (double)h_next);
+            if (denom == (lin_decimal_t)0) {
+                // A * v_k is zero, column k adds nothing to the solution
+                break;
+            }
+            cs[k] = h_kk / denom;
+            sn[k] = h_next / denom;
+            h[(k * m) + k] = denom;
+            g[k + 1] = -sn[k] * g[k];
+            g[k] = cs[k] * g[k];
+            k++;
+
+            res.residual = (lin_decimal_t)fabs((double)g[k]) / b_norm;
+            if (res.residual <= tol || h_next == (lin_decimal_t)0) {
+                break;
+            }
+        }
+
+        if (k == 0) {
+            break;
+        }
+
+        // y = H[0:k, 0:k]^-1 * g[0:k] in place, then x += M^-1 * V^T y
+        _lin_tri_view_t const view = {h, m, k, true, false, false};
+        _lin_trsm(&view, 1, g, 1);
+        memset(z, 0, n * sizeof(lin_decimal_t));
+        for (size_t i = 0; i < k; i++) {
+            _lin_axpy(n, g[i], &v[i * n], z);
+        }
+        if (o.diag != NULL) {
+            _lin_jacobi(o.diag, z, z, n);
+        }
+        _lin_axpy(n, 1, z, x->elements);
+    }
+    res.converged = res.residual <= tol;
+
+    free(work);
+    if (info != NULL) {
+        *info = res;
+    }
+    return res.converged;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// EIGEN DECLARATION
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// The k eigenvalues of largest magnitude of a symmetric operator, largest
+// first, with the matching orthonormal eigenvectors in the columns of the
+// [n x k] matrix `vectors`
+typedef struct {
+    lin_vec_t *values;
+    lin_mat_t *vectors;
+    size_t iterations;  // operator applications
+    bool converged;
+} lin_eig_t;
+
+lin_eig_t *lin_eig_subspace(lin_op_fn_t op, void *ctx, size_t n, size_t k,
+                            lin_iter_opts_t const *opts);
+lin_eig_t *lin_eig_lanczos(lin_op_fn_t op, void *ctx, size_t n, size_t k,
+                           lin_iter_opts_t const *opts);
+void lin_eig_free(lin_eig_t *eig);
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// EIGEN IMPLEMENTATION
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Eigenvalues `w` and eigenvectors (the columns of `v`) of the symmetric
+// [n x n] matrix `a` by cyclic Jacobi rotations. Only meant for the small
+// projected problems, `a` is overwritten.
+static void _lin_sym_eig_small(size_t n, double *a, double *w, double *v) {
+    for (size_t i = 0; i < n * n; i++) {
+        v[i] = 0;
+    }
+    double norm = 0;
+    for (size_t i = 0; i < n; i++) {
+        v[(i * n) + i] = 1;
+        for (size_t j = 0; j < n; j++) {
+            norm += a[(i * n) + j] * a[(i * n) + j];
+        }
+    }
+
+    for (int sweep = 0; sweep < 64; sweep++) {
+        double off = 0;
+        for (size_t p = 0; p < n; p++) {
+            for (size_t q = p + 1; q < n; q++) {
+                off += 2 * a[(p * n) + q] * a[(p * n) + q];
+            }
+        }
+        if (off <= norm * DBL_EPSILON * DBL_EPSILON) {
+            break;
+        }
+
+        for (size_t p = 0; p < n; p++) {
+            for (size_t q = p + 1; q < n; q++) {
+                double const a_pq = a[(p * n) + q];
+                if (a_pq == 0) {
+                    continue;
+                }
+
+                double const theta = (a[(q * n) + q] - a[(p * n) + p]) / (2 * a_pq);
+                double const t = (theta >= 0 ? 1.0 : -1.0)
+                    / (fabs(theta) + sqrt((theta * theta) + 1));
+                double const c = 1 / sqrt((t * t) + 1);
+                double const s = t * c;
+
+                for (size_t r = 0; r < n; r++) {
+                    double const a_rp = a[(r * n) + p];
+                    double const a_rq = a[(r * n) + q];
+                    a[(r * n) + p] = (c * a_rp) - (s * a_rq);
+                    a[(r * n) + q] = (s * a_rp) + (c * a_rq);
+
+                    double const v_rp = v[(r * n) + p];
+                    double const v_rq = v[(r * n) + q];
+                    v[(r * n) + p] = (c * v_rp) - (s * v_rq);
+                    v[(r * n) + q] = (s * v_rp) + (c * v_rq);
+                }
+                for (size_t r = 0; r < n; r++) {
+                    double const a_pr = a[(p * n) + r];
+                    double const a_qr = a[(q * n) + r];
+                    a[(p * n) + r] = (c * a_pr) - (s * a_qr);
+                    a[(q * n) + r] = (s * a_pr) + (c * a_qr);
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        w[i] = a[(i * n) + i];
+    }
+}
+
+// Indices of `w` sorted by decreasing magnitude
+static void _lin_eig_order(size_t n, double const *w, size_t *order) {
+    for (size_t i = 0; i < n; i++) {
+        size_t const idx = i;
+        size_t j = i;
+        while (j > 0 && fabs(w[order[j - 1]]) < fabs(w[idx])) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = idx;
+    }
+}
+
+// Fills `x` with a reproducible pseudo-random start vector
+static void _lin_eig_start(lin_decimal_t *x, size_t n, uint64_t *state) {
+    for (size_t i = 0; i < n; i++) {
+        // xorshift64*
+        *state ^= *state >> 12;
+        *state ^= *state << 25;
+        *state ^= *state >> 27;
+        uint64_t const r = *state * UINT64_C(2685821657736338717);
+        x[i] = (lin_decimal_t)((double)(r >> 11) / 9007199254740992.0 - 0.5);
+    }
+}
+
+// Orthogonalizes row `j` of the [? x n] basis `q` against rows [0, j) with
+// two passes of modified Gram-Schmidt and normalizes it. A row that is
+// dependent on the previous ones is replaced by a fresh start vector. Returns
+// false if no independent direction is left.
+static bool _lin_eig_orthonormalize(lin_decimal_t *q, size_t j, size_t n,
+                                    uint64_t *state) {
+    lin_decimal_t *q_j = &q[j * n];
+    for (int attempt = 0; attempt < 4; attempt++) {
+        lin_decimal_t const before = _lin_norm(q_j, n);
+        for (int pass = 0; pass < 2; pass++) {
+            for (size_t i = 0; i < j; i++) {
+                _lin_axpy(n, -_lin_dot(q_j, &q[i * n], n), &q[i * n], q_j);
+            }
+        }
+
+        lin_decimal_t const after = _lin_norm(q_j, n);
+        if (after > before * (lin_decimal_t)1e-3 && after > (lin_decimal_t)0) {
+            _lin_scale(n, (lin_decimal_t)1 / after, q_j);
+            return true;
+        }
+        _lin_eig_start(q_j, n, state);
+    }
+
+    return false;
+}
+
+static void _lin_eig_check(size_t n, size_t k) {
+    if (k == 0 || k > n) {
+        LIN_LOG_ERROR("Cannot compute %zu eigenvalues of a [%zu x %zu] operator",
+                      k, n, n);
+        exit(EXIT_FAILURE);
+    }
+}
+
+static lin_eig_t *_lin_eig_create(size_t n, size_t k) {
+    lin_eig_t *eig = (lin_eig_t *)malloc(sizeof(lin_eig_t));
+    if (eig == NULL) {
+        LIN_LOG_ERROR("Failed to allocate memory for lin_eig_t");
+        return NULL;
+    }
+
+    eig->values = lin_vec_create(k);
+    eig->vectors = lin_mat_create((lin_mat_shape_t){n, k});
+    eig->iterations = 0;
+    eig->converged = false;
+    if (eig->values == NULL || eig->vectors == NULL) {
+        lin_eig_free(eig);
+        return NULL;
+    }
+
+    memset(eig->values->elements, 0, k * sizeof(lin_decimal_t));
+    memset(eig->vectors->elements, 0, n * k * sizeof(lin_decimal_t));
+
+    return eig;
+}
+
+// Stores the Ritz pairs picked by `order`: values theta and vectors
+// basis^T * s, where `basis` holds `m` rows of length n and the columns of the
+// [m x m] `s` are the eigenvectors of the projected problem
+static void _lin_eig_ritz(lin_eig_t *eig, lin_decimal_t const *basis,
+                          size_t m, double const *theta, double const *s,
+                          size_t const *order, lin_decimal_t *y) {
+    size_t const n = eig->vectors->shape.rows;
+    size_t const k = eig->vectors->shape.columns;
+    for (size_t c = 0; c < k; c++) {
+        memset(y, 0, n * sizeof(lin_decimal_t));
+        for (size_t i = 0; i < m; i++) {
+            _lin_axpy(n, (lin_decimal_t)s[(i * m) + order[c]], &basis[i * n], y);
+        }
+        eig->values->elements[c] = (lin_decimal_t)theta[order[c]];
+        for (size_t row = 0; row < n; row++) {
+            eig->vectors->elements[(row * k) + c] = y[row];
+        }
+    }
+}
+
+/// Subspace iteration with Rayleigh-Ritz projection for the k eigenvalues of
+/// largest magnitude of a symmetric operator, power iteration for k = 1.
+/// Iterates on a block of min(n, 2k) vectors until the residuals
+/// ||A * v - lambda * v|| of the k wanted pairs are below `tol` times the
+/// largest eigenvalue. `opts->restart` and `opts->diag` are unused.
+lin_eig_t *lin_eig_subspace(lin_op_fn_t op, void *ctx, size_t n, size_t k,
+                            lin_iter_opts_t const *opts) {
+    _LIN_TRACE(_LIN_DIMS(n, n), _LIN_DIMS(k, 1));
+    _lin_eig_check(n, k);
+
+    lin_iter_opts_t const o = opts != NULL ? *opts : (lin_iter_opts_t){0};
+    size_t const max_iter = o.max_iter != 0 ? o.max_iter : 10 * n;
+    lin_decimal_t const tol = o.tol != 0
+        ? o.tol : (lin_decimal_t)sqrt((double)LIN_EPSILON);
+    size_t const s = _lin_min(n, 2 * k);
+
+    lin_eig_t *eig = _lin_eig_create(n, k);
+    if (eig == NULL) {
+        return NULL;
+    }
+
+    // Q and Z = A * Q as rows, the projected problem and its eigenvectors
+    lin_decimal_t *q = (lin_decimal_t *)malloc(
+        ((3 * s * n) + n) * sizeof(lin_decimal_t)
+    );
+    double *h = (double *)malloc(((2 * s * s) + s) * sizeof(double));
+    size_t *order = (size_t *)malloc(s * sizeof(size_t));
+    if (q == NULL || h == NULL || order == NULL) {
+        LIN_LOG_ERROR("Failed to allocate subspace iteration workspace");
+        free(q);
+        free(h);
+        free(order);
+        lin_eig_free(eig);
+        return NULL;
+    }
+    lin_decimal_t *z = &q[s * n];
+    lin_decimal_t *ritz = &z[s * n];
+    lin_decimal_t *y = &ritz[s * n];
+    double *w = &h[s * s];
+    double *vecs = &w[s];
+
+    uint64_t state = UINT64_C(0x9e3779b97f4a7c15);
+    for (size_t j = 0; j < s; j++) {
+        _lin_eig_start(&q[j * n], n, &state);
+        _lin_eig_orthonormalize(q, j, n, &state);
+    }
+
+    while (eig->iterations + s <= max_iter || eig->iterations == 0) {
+        for (size_t j = 0; j < s; j++) {
+            lin_vec_t in = {n, &q[j * n], 0, LIN_BORROW, 0};
+            lin_vec_t out = {n, &z[j * n], 0, LIN_BORROW, 0};
+            op(ctx, &in, &out);
+        }
+        eig->iterations += s;
+
+        // H = Q^T * A * Q, symmetrized against rounding
+        for (size_t i = 0; i < s; i++) {
+            for (size_t j = i; j < s; j++) {
+                double const el = 0.5 * ((double)_lin_dot(&q[i * n], &z[j * n], n)
+                    + (double)_lin_dot(&q[j * n], &z[i * n], n));
+                h[(i * s) + j] = el;
+                h[(j * s) + i] = el;
+            }
+        }
+        _lin_sym_eig_small(s, h, w, vecs);
+        _lin_eig_order(s, w, order);
+
+        // residual of pair c is ||Z * v_c - theta_c * Q * v_c||
+        bool converged = true;
+        double const scale = fabs(w[order[0]]);
+        for (size_t c = 0; c < k && converged; c++) {
+            memset(y, 0, n * sizeof(lin_decimal_t));
+            for (size_t i = 0; i < s; i++) {
+                double const s_ic = vecs[(i * s) + order[c]];
+                _lin_axpy(n, (lin_decimal_t)s_ic, &z[i * n], y);
+                _lin_axpy(n, (lin_decimal_t)(-w[order[c]] * s_ic), &q[i * n], y);
+            }
+            converged = (double)_lin_norm(y, n) <= (double)tol * scale;
+        }
+
+        _lin_eig_ritz(eig, q, s, w, vecs, order, y);
+        if (converged) {
+            eig->converged = true;
+            break;
+        }
+
+        // next block: orthonormalized A * (Q * V), the Ritz vectors after a
+        // power step, ordered by decreasing magnitude
+        for (size_t c = 0; c < s; c++) {
+            lin_decimal_t *r = &ritz[c * n];
+            memset(r, 0, n * sizeof(lin_decimal_t));
+            for (size_t i = 0; i < s; i++) {
+                _lin_axpy(n, (lin_decimal_t)vecs[(i * s) + order[c]], &z[i * n], r);
+            }
+        }
+        for (size_t c = 0; c < s; c++) {
+            _lin_eig_orthonormalize(ritz, c, n, &state);
+        }
+        memcpy(q, ritz, s * n * sizeof(lin_decimal_t));
+    }
+
+    free(q);
+    free(h);
+    free(order);
+    return eig;
+}
+
+/// Lanczos iteration with full reorthogonalization for the k eigenvalues of
+/// largest magnitude of a symmetric operator. The Krylov basis holds up to
+/// `opts->restart` vectors (0 means min(n, max(2k, 20))), after which it
+/// restarts from the sum of the wanted Ritz vectors. Converged when the
+/// residuals of the k wanted pairs are below `tol` times the largest
+/// eigenvalue. `opts->diag` is unused.
+lin_eig_t *lin_eig_lanczos(lin_op_fn_t op, void *ctx, size_t n, size_t k,
+                           lin_iter_opts_t const *opts) {
+    _LIN_TRACE(_LIN_DIMS(n, n), _LIN_DIMS(k, 1));
+    _lin_eig_check(n, k);
+
+    lin_iter_opts_t const o = opts != NULL ? *opts : (lin_iter_opts_t){0};
+    size_t const max_iter = o.max_iter != 0 ? o.max_iter : 10 * n;
+    lin_decimal_t const tol = o.tol != 0
+        ? o.tol : (lin_decimal_t)sqrt((double)LIN_EPSILON);
+    size_t const m = _lin_min(n, _lin_max(k, o.restart != 0
+        ? o.restart : _lin_max(2 * k, 20)));
+
+    lin_eig_t *eig = _lin_eig_create(n, k);
+    if (eig == NULL) {
+        return NULL;
+    }
+
+    // Lanczos basis V [(m + 1) x n], the tridiagonal T (its diagonal and
+    // off-diagonal), T as a dense matrix and its eigen decomposition
+    lin_decimal_t *v = (lin_decimal_t *)malloc(
+        (((m + 1) * n) + n) * sizeof(lin_decimal_t)
+    );
+    double *alpha = (double *)malloc(((2 * m) + (2 * m * m) + m) * sizeof(double));
+    size_t *order = (size_t *)malloc(m * sizeof(size_t));
+    if (v == NULL || alpha == NULL || order == NULL) {
+        LIN_LOG_ERROR("Failed to allocate Lanczos workspace");
+        free(v);
+        free(alpha);
+        free(order);
+        lin_eig_free(eig);
+        return NULL;
+    }
+    lin_decimal_t *y = &v[(m + 1) * n];
+    double *beta = &alpha[m];
+    double *t = &beta[m];
+    double *s = &t[m * m];
+    double *theta = &s[m * m];
+
+    uint64_t state = UINT64_C(0x9e3779b97f4a7c15);
+    _lin_eig_start(v, n, &state);
+    _lin_eig_orthonormalize(v, 0, n, &state);
+
+    for (;;) {
+        size_t j = 0;
+        for (; j < m && eig->iterations < max_iter; j++) {
+            lin_vec_t in = {n, &v[j * n], 0, LIN_BORROW, 0};
+            lin_vec_t out = {n, &v[(j + 1) * n], 0, LIN_BORROW, 0};
+            op(ctx, &in, &out);
+            eig->iterations++;
+
+            lin_decimal_t *w = out.elements;
+            alpha[j] = (double)_lin_dot(w, &v[j * n], n);
+            _lin_axpy(n, (lin_decimal_t)-alpha[j], &v[j * n], w);
+            if (j > 0) {
+                _lin_axpy(n, (lin_decimal_t)-beta[j - 1], &v[(j - 1) * n], w);
+            }
+
+            // full reorthogonalization against the whole basis
+            for (size_t i = 0; i <= j; i++) {
+                _lin_axpy(n, -_lin_dot(w, &v[i * n], n), &v[i * n], w);
+            }
+            beta[j] = (double)_lin_norm(w, n);
+
+            if (j + 1 < n && beta[j] <= fabs(alpha[j]) * (double)LIN_EPSILON) {
+                // invariant subspace, continue with a new direction
+                beta[j] = 0;
+                _lin_eig_start(w, n, &state);
+                if (!_lin_eig_orthonormalize(v, j + 1, n, &state)) {
+                    j++;
+                    break;
+                }
+            } else if (beta[j] > 0) {
+                _lin_scale(n, (lin_decimal_t)(1 / beta[j]), w);
+            }
+        }
+
+        size_t const steps = j;
+        for (size_t r = 0; r < steps * steps; r++) {
+            t[r] = 0;
+        }
+        for (size_t r = 0; r < steps; r++) {
+            t[(r * steps) + r] = alpha[r];
+            if (r + 1 < steps) {
+                t[(r * steps) + r + 1] = beta[r];
+                t[((r + 1) * steps) + r] = beta[r];
+            }
+        }
+        _lin_sym_eig_small(steps, t, theta, s);
+        _lin_eig_order(steps, theta, order);
+
+        // residual of Ritz pair c is beta_last * |last component of s_c|
+        bool converged = steps >= k;
+        double const scale = steps > 0 ? fabs(theta[order[0]]) : 0;
+        for (size_t c = 0; c < k && c < steps && converged; c++) {
+            double const resid = beta[steps - 1]
+                * fabs(s[((steps - 1) * steps) + order[c]]);
+            converged = resid <= (double)tol * scale;
+        }
+        converged = converged || (steps == n && steps >= k);
+
+        if (steps >= k) {
+            _lin_eig_ritz(eig, v, steps, theta, s, order, y);
+        }
+        if (converged || eig->iterations >= max_iter || steps < k) {
+            eig->converged = converged;
+            break;
+        }
+
+        // explicit restart from the sum of the wanted Ritz vectors
+        memset(v, 0, n * sizeof(lin_decimal_t));
+        for (size_t c = 0; c < k; c++) {
+            for (size_t row = 0; row < n; row++) {
+                v[row] += eig->vectors->elements[(row * k) + c];
+            }
+        }
+        _lin_eig_orthonormalize(v, 0, n, &state);
+    }
+
+    free(v);
+    free(alpha);
+    free(order);
+    return eig;
+}
+
+void lin_eig_free(lin_eig_t *eig) {
+    _LIN_TRACE(_LIN_NO_DIMS, _LIN_NO_DIMS);
+    if (eig == NULL) {
+        return;
+    }
+
+    lin_vec_free(eig->values);
+    lin_mat_free(eig->vectors);
+    free(eig);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// CONVOLUTION DECLARATION
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Geometry of a 2D convolution. The input holds `channels` images of
+// [height x width] one after another, so a plain [height x width] matrix is a
+// single-channel input. The filters are the rows of a matrix with
+// channels * kernel_height * kernel_width columns, ordered the same way. Each
+// filter produces one row of the [filters x (out_height * out_width)] result.
+typedef struct {
+    size_t channels;
+    size_t height;
+    size_t width;
+    size_t kernel_height;
+    size_t kernel_width;
+    size_t stride;          // 0 means 1
+    size_t padding;         // zeros added on every side
+} lin_conv2d_t;
+
+lin_mat_t *lin_mat_conv2d(lin_mat_t const *input, lin_mat_t const *filters,
+                          lin_conv2d_t const *conv);
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// CONVOLUTION IMPLEMENTATION
+//
+///////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+    lin_conv2d_t const *conv;
+    size_t stride;
+    size_t out_height;
+    size_t out_width;
+    size_t filters;
+    lin_decimal_t const *in;
+    lin_decimal_t const *w;
+    lin_decimal_t *col;     // im2col matrix, unused by the direct path
+    lin_decimal_t *out;
+} _lin_conv_ctx_t;
+
+// Element (y, x) of channel c in padded coordinates, zero in the padding
+static inline lin_decimal_t _lin_conv_at(_lin_conv_ctx_t const *g, size_t c,
+                                         size_t y, size_t x) {
+    lin_conv2d_t const *conv = g->conv;
+    if (y < conv->padding || x < conv->padding) {
+        return (lin_decimal_t)0;
+    }
+    y -= conv->padding;
+    x -= conv->padding;
+    if (y >= conv->height || x >= conv->width) {
+        return (lin_decimal_t)0;
+    }
+    return g->in[(((c * conv->height) + y) * conv->width) + x];
+}
+
+// Output pixels [begin, end): lowers their receptive fields into columns of
+// the im2col matrix, then multiplies the filters by that strip
+static void _lin_conv_im2col(void *ctx, size_t chunk, size_t begin, size_t end) {
+    (void)chunk;
+    _lin_conv_ctx_t const *g = (_lin_conv_ctx_t const *)ctx;
+    lin_conv2d_t const *conv = g->conv;
+    size_t const pixels = g->out_height * g->out_width;
+    size_t const k = conv->channels * conv->kernel_height * conv->kernel_width;
+
+    lin_decimal_t *col_row = g->col;
+    for (size_t c = 0; c < conv->channels; c++) {
+        for (size_t ky = 0; ky < conv->kernel_height; ky++) {
+            for (size_t kx = 0; kx < conv->kernel_width; kx++) {
+                for (size_t q = begin; q < end; q++) {
+                    size_t const oy = q / g->out_width;
+                    size_t const ox = q % g->out_width;
+                    col_row[q] = _lin_conv_at(g, c, (oy * g->stride) + ky,
+                                              (ox * g->stride) + kx);
+                }
+                col_row += pixels;
+            }
+        }
+    }
+
+    _lin_gemm(false, false, g->filters, end - begin, k, 1, g->w, k,
+              &g->col[begin], pixels, 0, &g->out[begin], pixels);
+}
+
+// Output rows [begin, end), numbered across filters: 3x3 kernels applied
+// directly, three taps of a kernel row at a time
+static void _lin_conv_3x3(void *ctx, size_t chunk, size_t begin, size_t end) {
+    (void)chunk;
+    _lin_conv_ctx_t const *g = (_lin_conv_ctx_t const *)ctx;
+    lin_conv2d_t const *conv = g->conv;
+    size_t const s = g->stride;
+    size_t const p = conv->padding;
+    size_t const ow = g->out_width;
+
+    for (size_t r = begin; r < end; r++) {
+        size_t const f = r / g->out_height;
+        size_t const oy = r % g->out_height;
+        lin_decimal_t *out = &g->out[r * ow];
+        for (size_t ox = 0; ox < ow; ox++) {
+            out[ox] = (lin_decimal_t)0;
+        }
+
+        for (size_t c = 0; c < conv->channels; c++) {
+            lin_decimal_t const *w = &g->w[((f * conv->channels) + c) * 9];
+            for (size_t ky = 0; ky < 3; ky++) {
+                size_t const y = (oy * s) + ky;
+                if (y < p || y - p >= conv->height) {
+                    continue;
+                }
+                lin_decimal_t const *row =
+                    &g->in[((c * conv->height) + y - p) * conv->width];
+                lin_decimal_t const w0 = w[ky * 3];
+                lin_decimal_t const w1 = w[(ky * 3) + 1];
+                lin_decimal_t const w2 = w[(ky * 3) + 2];
+
+                for (size_t ox = 0; ox < ow; ox++) {
+                    size_t const x = ox * s;
+                    if (x >= p && x + 2 - p < conv->width) {
+                        lin_decimal_t const *in = &row[x - p];
+                        out[ox] += (w0 * in[0]) + (w1 * in[1]) + (w2 * in[2]);
+                        continue;
+                    }
+                    // a tap falls in the padding
+                    for (size_t kx = 0; kx < 3; kx++) {
+                        if (x + kx >= p && x + kx - p < conv->width) {
+                            out[ox] += w[(ky * 3) + kx] * row[x + kx - p];
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+/// Cross-correlation of `input` with each filter, as in CNN layers. 3x3
+/// kernels are applied directly, others are lowered to one GEMM via im2col.
+lin_mat_t *lin_mat_conv2d(lin_mat_t const *input, lin_mat_t const *filters,
+                          lin_conv2d_t const *conv) {
+    _LIN_TRACE(_LIN_MAT_DIMS(input), _LIN_MAT_DIMS(filters));
+    size_t const k = conv->channels * conv->kernel_height * conv->kernel_width;
+    size_t const stride = conv->stride == 0 ? 1 : conv->stride;
+    size_t const padded_h = conv->height + (2 * conv->padding);
+    size_t const padded_w = conv->width + (2 * conv->padding);
+    if (input->shape.rows * input->shape.columns
+            != conv->channels * conv->height * conv->width
+        || filters->shape.columns != k || k == 0
+        || conv->kernel_height > padded_h || conv->kernel_width > padded_w) {
+        LIN_LOG_ERROR(
+            "Dimension mismatch during convolution [%zu x %zu] [%zu x %zu] (%zu x %zu x %zu, kernel %zu x %zu)",
+            input->shape.rows, input->shape.columns,
+            filters->shape.rows, filters->shape.columns,
+            conv->channels, conv->height, conv->width,
+            conv->kernel_height, conv->kernel_width
+        );
+        exit(EXIT_FAILURE);
+    }
+
+    if (input->layout == LIN_COL_MAJOR || filters->layout == LIN_COL_MAJOR) {
+        lin_mat_t *in_rows_copy;
+        lin_mat_t const *in_rows = _lin_mat_rows(input, &in_rows_copy);
+        lin_mat_t *w_rows_copy;
+        lin_mat_t const *w_rows = _lin_mat_rows(filters, &w_rows_copy);
+        lin_mat_t *res = lin_mat_conv2d(in_rows, w_rows, conv);
+        lin_mat_free(in_rows_copy);
+        lin_mat_free(w_rows_copy);
+        return res;
+    }
+
+    _lin_conv_ctx_t g = {
+        conv, stride,
+        ((padded_h - conv->kernel_height) / stride) + 1,
+        ((padded_w - conv->kernel_width) / stride) + 1,
+        filters->shape.rows, input->elements, filters->elements, NULL, NULL
+    };
+    size_t const pixels = g.out_height * g.out_width;
+    lin_mat_t *res = lin_mat_create((lin_mat_shape_t){g.filters, pixels});
+    if (res == NULL) {
+        return NULL;
+    }
+    g.out = res->elements;
+
+    if (conv->kernel_height == 3 && conv->kernel_width == 3) {
+        _lin_parallel_for(g.filters * g.out_height, conv->channels * 9 * g.out_width,
+                          _lin_conv_3x3, &g);
+        return res;
+    }
+
+    g.col = (lin_decimal_t *)malloc(k * pixels * sizeof(lin_decimal_t));
+    if (g.col == NULL) {
+        LIN_LOG_ERROR("Failed to allocate im2col workspace");
+        lin_mat_free(res);
+        return NULL;
+    }
+
+    _lin_parallel_for(pixels, k * (g.filters + 1), _lin_conv_im2col, &g);
+    free(g.col);
+    return res;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// RANDOM DECLARATION
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Seedable xoshiro256+ generator. A seed gives the same numbers with any
+// number of threads, and the same uniform bits on every platform.
+typedef struct {
+    uint64_t s[4];
+} lin_rng_t;
+
+void lin_rng_seed(lin_rng_t *rng, uint64_t seed);
+void lin_rng_split(lin_rng_t *rng, lin_rng_t *stream);
+uint64_t lin_rng_next(lin_rng_t *rng);
+lin_decimal_t lin_rng_uniform(lin_rng_t *rng);
+lin_decimal_t lin_rng_normal(lin_rng_t *rng);
+void lin_vec_fill_uniform(lin_vec_t *vec, lin_rng_t *rng, lin_decimal_t low, lin_decimal_t high);
+void lin_vec_fill_normal(lin_vec_t *vec, lin_rng_t *rng, lin_decimal_t mean, lin_decimal_t stddev);
+void lin_mat_fill_uniform(lin_mat_t *mat, lin_rng_t *rng, lin_decimal_t low, lin_decimal_t high);
+void lin_mat_fill_normal(lin_mat_t *mat, lin_rng_t *rng, lin_decimal_t mean, lin_decimal_t stddev);
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// RANDOM IMPLEMENTATION
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Bulk fills draw each block of elements from its own generator, run as
+// independent lanes so the update vectorizes. Both are fixed rather than
+// configurable, as changing them changes the numbers a seed produces.
+#define _LIN_RNG_BLOCK 1024
+#define _LIN_RNG_LANES 8
+
+static inline uint64_t _lin_splitmix64(uint64_t *x) {
+    uint64_t z = (*x += UINT64_C(0x9E3779B97F4A7C15));
+    z = (z ^ (z >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+    z = (z ^ (z >> 27)) * UINT64_C(0x94D049BB133111EB);
+    return z ^ (z >> 31);
+}
+
+static inline uint64_t _lin_rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+// Uniform in [0, 1) from the high bits of `r`, as many as lin_decimal_t holds
+static inline lin_decimal_t _lin_rng_unit(uint64_t r) {
+    if (sizeof(lin_decimal_t) > sizeof(float)) {
+        return (lin_decimal_t)((double)(r >> 11) * 0x1.0p-53);
+    }
+    return (lin_decimal_t)((float)(r >> 40) * 0x1.0p-24f);
+}
+
+// Maps pairs of uniforms in [0, 1) to pairs of standard normals
+static void _lin_box_muller(lin_decimal_t *u, size_t n) {
+    for (size_t i = 0; i + 1 < n; i += 2) {
+        double const r = sqrt(-2.0 * log(1.0 - (double)u[i]));
+        double const theta = 6.283185307179586 * (double)u[i + 1];
+        u[i] = (lin_decimal_t)(r * cos(theta));
+        u[i + 1] = (lin_decimal_t)(r * sin(theta));
+    }
+}
+
+void lin_rng_seed(lin_rng_t *rng, uint64_t seed) {
+    _LIN_TRACE(_LIN_NO_DIMS, _LIN_NO_DIMS);
+    for (size_t i = 0; i < 4; i++) {
+        rng->s[i] = _lin_splitmix64(&seed);
+    }
+}
+
+uint64_t lin_rng_next(lin_rng_t *rng) {
+    uint64_t *s = rng->s;
+    uint64_t const res = s[0] + s[3];
+    uint64_t const t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = _lin_rotl(s[3], 45);
+    return res;
+}
+
+/// Hands the current sequence of `rng` to `stream` and moves `rng` 2^128
+/// draws ahead, so repeated splits give non-overlapping per-thread streams
+void lin_rng_split(lin_rng_t *rng, lin_rng_t *stream) {
+    _LIN_TRACE(_LIN_NO_DIMS, _LIN_NO_DIMS);
+    static uint64_t const jump[4] = {
+        UINT64_C(0x180EC6D33CFD0ABA), UINT64_C(0xD5A61266F0C9392C),
+        UINT64_C(0xA9582618E03FC9AA), UINT64_C(0x39ABDC4529B1661C),
+    };
+
+    *stream = *rng;
+    uint64_t s[4] = {0, 0, 0, 0};
+    for (size_t i = 0; i < 4; i++) {
+        for (int b = 0; b < 64; b++) {
+            if ((jump[i] & (UINT64_C(1) << b)) != 0) {
+                for (size_t j = 0; j < 4; j++) {
+                    s[j] ^= rng->s[j];
+                }
+            }
+            lin_rng_next(rng);
+        }
+    }
+    memcpy(rng->s, s, sizeof(s));
+}
+
+/// Uniform in [0, 1)
+lin_decimal_t lin_rng_uniform(lin_rng_t *rng) {
+    return _lin_rng_unit(lin_rng_next(rng));
+}
+
+/// Standard normal, by Box-Muller
+lin_decimal_t lin_rng_normal(lin_rng_t *rng) {
+    lin_decimal_t u[2] = {lin_rng_uniform(rng), lin_rng_uniform(rng)};
+    _lin_box_muller(u, 2);
+    return u[0];
+}
+
+typedef struct {
+    uint64_t key;
+    bool normal;
+    lin_decimal_t shift;
+    lin_decimal_t scale;
+    lin_decimal_t *x;
+    size_t n;
+} _lin_rng_fill_ctx_t;
+
+// Blocks [begin, end) of the fill, each from lanes seeded by the key and the
+// block index alone
+static void _lin_rng_fill_blocks(void *ctx, size_t chunk, size_t begin, size_t end) {
+    (void)chunk;
+    _lin_rng_fill_ctx_t const *g = (_lin_rng_fill_ctx_t const *)ctx;
+    uint64_t s[4][_LIN_RNG_LANES];
+    lin_decimal_t u[_LIN_RNG_BLOCK];
+
+    for (size_t blk = begin; blk < end; blk++) {
+        uint64_t seed = g->key ^ ((uint64_t)blk * UINT64_C(0xD1342543DE82EF95));
+        for (size_t l = 0; l < _LIN_RNG_LANES; l++) {
+            for (size_t i = 0; i < 4; i++) {
+                s[i][l] = _lin_splitmix64(&seed);
+            }
+        }
+
+        for (size_t i = 0; i < _LIN_RNG_BLOCK; i += _LIN_RNG_LANES) {
+            for (size_t l = 0; l < _LIN_RNG_LANES; l++) {
+                uint64_t const r = s[0][l] + s[3][l];
+                uint64_t const t = s[1][l] << 17;
+                s[2][l] ^= s[0][l];
+                s[3][l] ^= s[1][l];
+                s[1][l] ^= s[2][l];
+                s[0][l] ^= s[3][l];
+                s[2][l] ^= t;
+                s[3][l] = _lin_rotl(s[3][l], 45);
+                u[i + l] = _lin_rng_unit(r);
+            }
+        }
+
+        if (g->normal) {
+            _lin_box_muller(u, _LIN_RNG_BLOCK);
+        }
+
+        size_t const i0 = blk * _LIN_RNG_BLOCK;
+        size_t const count = _lin_min(_LIN_RNG_BLOCK, g->n - i0);
+        lin_decimal_t *x = &g->x[i0];
+        for (size_t i = 0; i < count; i++) {
+            x[i] = g->shift + (g->scale * u[i]);
+        }
+    }
+}
+
+static void _lin_rng_fill(lin_rng_t *rng, lin_decimal_t *x, size_t n, bool normal,
+                          lin_decimal_t shift, lin_decimal_t scale) {
+    _lin_rng_fill_ctx_t g = {lin_rng_next(rng), normal, shift, scale, x, n};
+    _lin_parallel_for((n + _LIN_RNG_BLOCK - 1) / _LIN_RNG_BLOCK,
+                      _LIN_RNG_BLOCK * (normal ? 16 : 2),
+                      _lin_rng_fill_blocks, &g);
+}
+
+/// Fills `vec` with values uniform in [low, high), advancing `rng` by one draw
+void lin_vec_fill_uniform(lin_vec_t *vec, lin_rng_t *rng, lin_decimal_t low, lin_decimal_t high) {
+    _LIN_TRACE(_LIN_VEC_DIMS(vec), _LIN_NO_DIMS);
+    _lin_rng_fill(rng, vec->elements, vec->dim, false, low, high - low);
+}
+
+void lin_vec_fill_normal(lin_vec_t *vec, lin_rng_t *rng, lin_decimal_t mean, lin_decimal_t stddev) {
+    _LIN_TRACE(_LIN_VEC_DIMS(vec), _LIN_NO_DIMS);
+    _lin_rng_fill(rng, vec->elements, vec->dim, true, mean, stddev);
+}
+
+void lin_mat_fill_uniform(lin_mat_t *mat, lin_rng_t *rng, lin_decimal_t low, lin_decimal_t high) {
+    _LIN_TRACE(_LIN_MAT_DIMS(mat), _LIN_NO_DIMS);
+    lin_mat_touch(mat);
+    _lin_rng_fill(rng, mat->elements, mat->shape.rows * mat->shape.columns,
+                  false, low, high - low);
+}
+
+void lin_mat_fill_normal(lin_mat_t *mat, lin_rng_t *rng, lin_decimal_t mean, lin_decimal_t stddev) {
+    _LIN_TRACE(_LIN_MAT_DIMS(mat), _LIN_NO_DIMS);
+    lin_mat_touch(mat);
+    _lin_rng_fill(rng, mat->elements, mat->shape.rows * mat->shape.columns,
+                  true, mean, stddev);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// UPDATE DECLARATION
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Low-rank modifications of an existing inverse or factorization in O(n^2)
+// (O(n^2 k) for rank k) instead of recomputing it from scratch
+
+bool lin_mat_inv_rank1_update(lin_mat_t *a_inv, lin_vec_t const *u, lin_vec_t const *v);
+bool lin_mat_inv_woodbury_update(lin_mat_t *a_inv, lin_mat_t const *u, lin_mat_t const *v);
+bool lin_mat_cholesky_update(lin_mat_t *l, lin_vec_t const *x);
+bool lin_mat_cholesky_downdate(lin_mat_t *l, lin_vec_t const *x);
+bool lin_mat_lu_update(lin_mat_lu_t *lu, lin_vec_t const *u, lin_vec_t const *v);
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// UPDATE IMPLEMENTATION
+//
+///////////////////////////////////////////////////////////////////////////////
+
+/// Sherman-Morrison: replaces the inverse of a with the inverse of
+/// a + u * v^T. Returns false, leaving `a_inv` unchanged, if the updated
+/// matrix is singular.
+bool lin_mat_inv_rank1_update(lin_mat_t *a_inv, lin_vec_t const *u, lin_vec_t const *v) {
+    _LIN_TRACE(_LIN_MAT_DIMS(a_inv), _LIN_VEC_DIMS(u));
+    size_t const n = a_inv->shape.rows;
+    if (a_inv->shape.columns != n || u->dim != n || v->dim != n) {
+        LIN_LOG_ERROR(
+            "Dimension mismatch during rank-1 inverse update [%zu x %zu] (%zu) (%zu)",
+            a_inv->shape.rows, a_inv->shape.columns, u->dim, v->dim
+        );
+        exit(EXIT_FAILURE);
+    }
+
+    lin_vec_t *w = lin_mat_vec_mult(a_inv, u);
+    lin_vec_t *z = lin_mat_vec_mult_transposed(a_inv, v);
+    if (w == NULL || z == NULL) {
+        lin_vec_free(w);
+        lin_vec_free(z);
+        return false;
+    }
+
+    // (a + u v^T)^-1 = a^-1 - (a^-1 u)(v^T a^-1) / (1 + v^T a^-1 u)
+    lin_decimal_t const denom = 1 + _lin_dot(v->elements, w->elements, n);
+    bool const ok = (lin_decimal_t)fabs((double)denom) > LIN_EPSILON;
+    if (ok) {
+        // column-major storage holds the transpose, so w and z swap roles
+        bool const col = a_inv->layout == LIN_COL_MAJOR;
+        lin_decimal_t const *outer = col ? z->elements : w->elements;
+        lin_decimal_t const *inner = col ? w->elements : z->elements;
+        lin_mat_touch(a_inv);
+        for (size_t i = 0; i < n; i++) {
+            _lin_axpy(n, -outer[i] / denom, inner, &a_inv->elements[i * n]);
+        }
+    } else {
+        LIN_LOG_ERROR("Rank-1 update makes the matrix singular");
+    }
+
+    lin_vec_free(w);
+    lin_vec_free(z);
+    return ok;
+}
+
+/// Woodbury: replaces the inverse of a with the inverse of a + u * v^T, where
+/// `u` and `v` are [n x k]. Returns false, leaving `a_inv` unchanged, if the
+/// updated matrix is singular.
+bool lin_mat_inv_woodbury_update(lin_mat_t *a_inv, lin_mat_t const *u, lin_mat_t const *v) {
+    _LIN_TRACE(_LIN_MAT_DIMS(a_inv), _LIN_MAT_DIMS(u));
+    size_t const n = a_inv->shape.rows;
+    size_t const k = u->shape.columns;
+    if (a_inv->shape.columns != n || u->shape.rows != n
+        || v->shape.rows != n || v->shape.columns != k) {
+        LIN_LOG_ERROR(
+            "Dimension mismatch during Woodbury inverse update [%zu x %zu] [%zu x %zu] [%zu x %zu]",
+            a_inv->shape.rows, a_inv->shape.columns,
+            u->shape.rows, u->shape.columns, v->shape.rows, v->shape.columns
+        );
+        exit(EXIT_FAILURE);
+    }
+
+    // w = a^-1 u [n x k], z = v^T a^-1 [k x n], s = I + v^T w [k x k]
+    lin_mat_t *w = lin_mat_create((lin_mat_shape_t){n, k});
+    lin_mat_t *z = lin_mat_create((lin_mat_shape_t){k, n});
+    lin_mat_t *cap = lin_mat_identity(k);
+    bool const a_t = a_inv->layout == LIN_COL_MAJOR;
+    bool const u_t = u->layout == LIN_COL_MAJOR;
+    bool const v_t = v->layout != LIN_COL_MAJOR;
+    _lin_gemm(a_t, u_t, n, k, n, 1, a_inv->elements, n, u->elements,
+              _lin_mat_ld(u), 0, w->elements, k);
+    _lin_gemm(v_t, a_t, k, n, n, 1, v->elements, _lin_mat_ld(v),
+              a_inv->elements, n, 0, z->elements, n);
+    _lin_gemm(v_t, false, k, k, n, 1, v->elements, _lin_mat_ld(v),
+              w->elements, k, 1, cap->elements, k);
+
+    // a^-1 -= w * s^-1 * z
+    lin_mat_lu_t *cap_lu = lin_mat_lu(cap);
+    lin_mat_t *sz = cap_lu == NULL ? NULL : lin_mat_lu_solve(cap_lu, z);
+    bool const ok = sz != NULL;
+    if (ok) {
+        lin_mat_touch(a_inv);
+        if (a_t) {
+            _lin_gemm(true, true, n, n, k, -1, sz->elements, n, w->elements, k,
+                      1, a_inv->elements, n);
+        } else {
+            _lin_gemm(false, false, n, n, k, -1, w->elements, k, sz->elements,
+                      n, 1, a_inv->elements, n);
+        }
+        lin_mat_free(sz);
+    } else {
+        LIN_LOG_ERROR("Woodbury update makes the matrix singular");
+    }
+
+    lin_mat_lu_free(cap_lu);
+    lin_mat_free(w);
+    lin_mat_free(z);
+    lin_mat_free(cap);
+    return ok;
+}
+
+// Applies the rotations that turn L * L^T into L * L^T + sign * x * x^T
+static bool _lin_cholesky_rank1(lin_mat_t *l, lin_vec_t const *x, bool downdate) {
+    size_t const n = l->shape.rows;
+    if (l->shape.columns != n || x->dim != n) {
+        LIN_LOG_ERROR(
+            "Dimension mismatch during Cholesky update [%zu x %zu] (%zu)",
+            l->shape.rows, l->shape.columns, x->dim
+        );
+        exit(EXIT_FAILURE);
+    }
+
+    if (!lin_mat_set_layout(l, LIN_ROW_MAJOR)) {
+        return false;
+    }
+
+    lin_decimal_t *w = (lin_decimal_t *)malloc(n * sizeof(lin_decimal_t));
+    if (w == NULL) {
+        LIN_LOG_ERROR("Failed to allocate Cholesky update workspace");
+        return false;
+    }
+    memcpy(w, x->elements, n * sizeof(lin_decimal_t));
+    lin_mat_touch(l);
+
+    lin_decimal_t *el = l->elements;
+    for (size_t k = 0; k < n; k++) {
+        double const l_kk = (double)el[(k * n) + k];
+        double const w_k = (double)w[k];
+        double const r_sq = downdate
+            ? (l_kk * l_kk) - (w_k * w_k) : (l_kk * l_kk) + (w_k * w_k);
+        if (!(r_sq > 0.0)) {
+            LIN_LOG_ERROR(
+                "Cholesky downdate leaves matrix not positive definite (leading minor of order %zu)",
+                k + 1
+            );
+            free(w);
+            return false;
+        }
+
+        double const r = sqrt(r_sq);
+        lin_decimal_t const c = (lin_decimal_t)(r / l_kk);
+        lin_decimal_t const s = (lin_decimal_t)(w_k / l_kk);
+        el[(k * n) + k] = (lin_decimal_t)r;
+
+        for (size_t i = k + 1; i < n; i++) {
+            lin_decimal_t *l_ik = &el[(i * n) + k];
+            *l_ik = downdate ? (*l_ik - (s * w[i])) / c : (*l_ik + (s * w[i])) / c;
+            w[i] = (c * w[i]) - (s * *l_ik);
+        }
+    }
+
+    free(w);
+    return true;
+}
+
+/// Replaces the Cholesky factor of a with that of a + x * x^T
+bool lin_mat_cholesky_update(lin_mat_t *l, lin_vec_t const *x) {
+    _LIN_TRACE(_LIN_MAT_DIMS(l), _LIN_VEC_DIMS(x));
+    return _lin_cholesky_rank1(l, x, false);
+}
+
+/// Replaces the Cholesky factor of a with that of a - x * x^T. Returns false,
+/// leaving `l` partially updated, if the result is not positive definite.
+bool lin_mat_cholesky_downdate(lin_mat_t *l, lin_vec_t const *x) {
+    _LIN_TRACE(_LIN_MAT_DIMS(l), _LIN_VEC_DIMS(x));
+    return _lin_cholesky_rank1(l, x, true);
+}
+
+/// Replaces the LU factorization of a with that of a + u * v^T, keeping the
+/// existing row permutation (Bennett's algorithm). Returns false, leaving
+/// `lu` invalid, if a zero pivot is encountered; refactorize in that case.
+bool lin_mat_lu_update(lin_mat_lu_t *lu, lin_vec_t const *u, lin_vec_t const *v) {
+    _LIN_TRACE(_LIN_MAT_DIMS((lu)->lu), _LIN_VEC_DIMS(u));
+    size_t const n = lu->lu->shape.rows;
+    if (u->dim != n || v->dim != n) {
+        LIN_LOG_ERROR(
+            "Dimension mismatch during LU update [%zu x %zu] (%zu) (%zu)",
+            n, n, u->dim, v->dim
+        );
+        exit(EXIT_FAILURE);
+    }
+
+    // P * (a + u v^T) = L * U + (P u) v^T
+    lin_decimal_t *x = (lin_decimal_t *)malloc(2 * n * sizeof(lin_decimal_t));
+    if (x == NULL) {
+        LIN_LOG_ERROR("Failed to allocate LU update workspace");
+        return false;
+    }
+    lin_decimal_t *y = &x[n];
+    for (size_t i = 0; i < n; i++) {
+        x[i] = u->elements[lu->perm[i]];
+    }
+    memcpy(y, v->elements, n * sizeof(lin_decimal_t));
+
+    lin_decimal_t *el = lu->lu->elements;
+    for (size_t i = 0; i < n; i++) {
+        lin_decimal_t *u_i = &el[i * n];
+        lin_decimal_t const u_ii = u_i[i];
+        lin_decimal_t const x_i = x[i];
+        lin_decimal_t const y_i = y[i];
+
+        u_i[i] += x_i * y_i;
+        if (u_i[i] == (lin_decimal_t)0) {
+            LIN_LOG_ERROR("LU update produced a zero pivot at row %zu", i);
+            free(x);
+            return false;
+        }
+
+        // new row of U, then the remaining update vectors for the trailing
+        // block: x' = x - x_i * l_old, y' = y - (y_i / u_ii') * u_row'
+        _lin_axpy(n - i - 1, x_i, &y[i + 1], &u_i[i + 1]);
+        for (size_t r = i + 1; r < n; r++) {
+            lin_decimal_t *l_ri = &el[(r * n) + i];
+            lin_decimal_t const l_old = *l_ri;
+            *l_ri = ((l_old * u_ii) + (x[r] * y_i)) / u_i[i];
+            x[r] -= x_i * l_old;
+        }
+        _lin_axpy(n - i - 1, -y_i / u_i[i], &u_i[i + 1], &y[i + 1]);
+    }
+
+    free(x);
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// CACHE DECLARATION
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Once enabled on a matrix, its LU factorization, determinant, inverse and
+// transpose are computed at most once and reused by `lin_mat_det`,
+// `lin_mat_inv` and `lin_mat_transpose` (which still return copies) and by the
+// `lin_mat_cached_*` functions (which return results owned by the matrix).
+// Library functions that modify a matrix invalidate its cache; code writing
+// to `elements` directly must call `lin_mat_touch` afterwards. Threads, such
+// as jobs sharing an operand, may read the cache of the same matrix
+// concurrently; each result is still computed only once.
+struct lin_mat_cache {
+    bool has_lu, has_det;
+    lin_mat_lu_t *lu;
+    lin_decimal_t det;
+    lin_mat_t *inv, *transpose;
+#ifndef LIN_NO_THREADS
+    // held while looking up or filling any of the above
+    pthread_mutex_t lock;
+#endif
+};
+
+lin_mat_lu_t const *lin_mat_cached_lu(lin_mat_t const *mat);
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// CACHE IMPLEMENTATION
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef LIN_NO_THREADS
+#define _LIN_CACHE_LOCK(c) pthread_mutex_lock(&(c)->lock)
+#define _LIN_CACHE_UNLOCK(c) pthread_mutex_unlock(&(c)->lock)
+#else
+#define _LIN_CACHE_LOCK(c) ((void)0)
+#define _LIN_CACHE_UNLOCK(c) ((void)0)
+#endif
+
+static void _lin_mat_cache_clear(struct lin_mat_cache *cache) {
+    lin_mat_lu_free(cache->lu);
+    lin_mat_free(cache->inv);
+    lin_mat_free(cache->transpose);
+    cache->has_lu = false;
+    cache->has_det = false;
+    cache->lu = NULL;
+    cache->det = 0;
+    cache->inv = NULL;
+    cache->transpose = NULL;
+}
+
+static struct lin_mat_cache *_lin_mat_cache_get(lin_mat_t const *mat) {
+    if (mat->cache == NULL) {
+        LIN_LOG_ERROR("Matrix cache is not enabled, see lin_mat_cache_enable");
+        exit(EXIT_FAILURE);
+    }
+
+    return mat->cache;
+}
+
+void lin_mat_cache_enable(lin_mat_t *mat) {
+    _LIN_TRACE(_LIN_MAT_DIMS(mat), _LIN_NO_DIMS);
+    if (mat->cache != NULL) {
+        return;
+    }
+
+    mat->cache = (struct lin_mat_cache *)calloc(1, sizeof(struct lin_mat_cache));
+    if (mat->cache == NULL) {
+        LIN_LOG_ERROR("Failed to allocate memory for matrix cache");
+        return;
+    }
+#ifndef LIN_NO_THREADS
+    pthread_mutex_init(&mat->cache->lock, NULL);
+#endif
+}
+
+/// Frees everything cached for `mat`
+void lin_mat_cache_disable(lin_mat_t *mat) {
+    _LIN_TRACE(_LIN_NO_DIMS, _LIN_NO_DIMS);
+    if (mat->cache == NULL) {
+        return;
+    }
+
+    _lin_mat_cache_clear(mat->cache);
+#ifndef LIN_NO_THREADS
+    pthread_mutex_destroy(&mat->cache->lock);
+#endif
+    free(mat->cache);
+    mat->cache = NULL;
+}
+
+/// Marks the elements of `mat` as modified, discarding cached results
+void lin_mat_touch(lin_mat_t *mat) {
+    _LIN_TRACE(_LIN_MAT_DIMS(mat), _LIN_NO_DIMS);
+    if (mat->cache != NULL) {
+        _LIN_CACHE_LOCK(mat->cache);
+        _lin_mat_cache_clear(mat->cache);
+        _LIN_CACHE_UNLOCK(mat->cache);
+    }
+}
+
+// The cached LU factorization of `mat`, NULL if it is singular. Called with
+// the cache locked.
+static lin_mat_lu_t const *_lin_mat_cache_lu(lin_mat_t const *mat,
+                                             struct lin_mat_cache *cache) {
+    if (!cache->has_lu) {
+        cache->lu = _lin_mat_lu(mat, false);
+        cache->has_lu = true;
+    }
+
+    return cache->lu;
+}
+
+/// Returns NULL if `mat` is singular
+lin_mat_lu_t const *lin_mat_cached_lu(lin_mat_t const *mat) {
+    _LIN_TRACE(_LIN_MAT_DIMS(mat), _LIN_NO_DIMS);
+    struct lin_mat_cache *cache = _lin_mat_cache_get(mat);
+    _LIN_CACHE_LOCK(cache);
+    lin_mat_lu_t const *lu = _lin_mat_cache_lu(mat, cache);
+    _LIN_CACHE_UNLOCK(cache);
+    return lu;
+}
+
+lin_decimal_t lin_mat_cached_det(lin_mat_t const *mat) {
+    _LIN_TRACE(_LIN_MAT_DIMS(mat), _LIN_NO_DIMS);
+    struct lin_mat_cache *cache = _lin_mat_cache_get(mat);
+    _LIN_CACHE_LOCK(cache);
+    if (!cache->has_det) {
+        lin_mat_lu_t const *lu = _lin_mat_cache_lu(mat, cache);
+        cache->det = lu == NULL ? (lin_decimal_t)0 : lin_mat_lu_det(lu);
+        cache->has_det = true;
+    }
+
+    lin_decimal_t const det = cache->det;
+    _LIN_CACHE_UNLOCK(cache);
+    return det;
+}
+
+/// Returns NULL if `mat` is singular
+lin_mat_t const *lin_mat_cached_inv(lin_mat_t const *mat) {
+    _LIN_TRACE(_LIN_MAT_DIMS(mat), _LIN_NO_DIMS);
+    struct lin_mat_cache *cache = _lin_mat_cache_get(mat);
+    _LIN_CACHE_LOCK(cache);
+    if (cache->inv == NULL) {
+        lin_mat_lu_t const *lu = _lin_mat_cache_lu(mat, cache);
+        if (lu != NULL) {
+            lin_mat_t *identity = lin_mat_identity(mat->shape.rows);
+            cache->inv = lin_mat_lu_solve(lu, identity);
+            lin_mat_free(identity);
+        }
+    }
+
+    lin_mat_t const *inv = cache->inv;
+    _LIN_CACHE_UNLOCK(cache);
+    return inv;
+}
+
+lin_mat_t const *lin_mat_cached_transpose(lin_mat_t const *mat) {
+    _LIN_TRACE(_LIN_MAT_DIMS(mat), _LIN_NO_DIMS);
+    struct lin_mat_cache *cache = _lin_mat_cache_get(mat);
+    _LIN_CACHE_LOCK(cache);
+    if (cache->transpose == NULL) {
+        cache->transpose = _lin_mat_transpose(mat);
+    }
+
+    lin_mat_t const *transpose = cache->transpose;
+    _LIN_CACHE_UNLOCK(cache);
+    return transpose;
+}
 
-lin_mat_t *lin_mat_sub(lin_mat_t const *a, lin_mat_t const *b) {
-    if (a->shape.rows != b->shape.rows
-        || a->shape.columns != b->shape.columns) {
+///////////////////////////////////////////////////////////////////////////////
+//
+// FILE DECLARATION
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Binary matrix files consist of a 24 byte header followed by the elements in
+// row-major order, in native byte order:
+//
+// bytes 0..3   magic "LINM"
+// bytes 4..7   uint32_t size of one element in bytes
+// bytes 8..15  uint64_t number of rows
+// bytes 16..23 uint64_t number of columns
+
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define LIN_FILE_HEADER_SIZE 24
+
+#ifndef LIN_FILE_TILE
+#define LIN_FILE_TILE 2048
+#endif
+
+bool lin_mat_save(lin_mat_t const *mat, char const *path);
+lin_mat_t *lin_mat_load(char const *path);
+bool lin_mat_mult_file(char const *a_path, char const *b_path,
+                       char const *c_path, size_t tile);
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// FILE IMPLEMENTATION
+//
+///////////////////////////////////////////////////////////////////////////////
+
+static void _lin_file_header(lin_mat_shape_t shape,
+                             unsigned char header[LIN_FILE_HEADER_SIZE]) {
+    uint32_t const el_size = (uint32_t)sizeof(lin_decimal_t);
+    uint64_t const dims[2] = {shape.rows, shape.columns};
+    memcpy(header, "LINM", 4);
+    memcpy(&header[4], &el_size, sizeof(el_size));
+    memcpy(&header[8], dims, sizeof(dims));
+}
+
+static bool _lin_file_write_header(FILE *file, lin_mat_shape_t shape) {
+    unsigned char header[LIN_FILE_HEADER_SIZE];
+    _lin_file_header(shape, header);
+    return fwrite(header, 1, sizeof(header), file) == sizeof(header);
+}
+
+static bool _lin_file_read_header(FILE *file, char const *path,
+                                  lin_mat_shape_t *shape) {
+    char magic[4];
+    uint32_t el_size;
+    uint64_t dims[2];
+    if (fread(magic, 1, 4, file) != 4 ||
+        fread(&el_size, sizeof(el_size), 1, file) != 1 ||
+        fread(dims, sizeof(dims[0]), 2, file) != 2 ||
+        memcmp(magic, "LINM", 4) != 0) {
+        LIN_LOG_ERROR("%s is not a lin matrix file", path);
+        return false;
+    }
+
+    if (el_size != sizeof(lin_decimal_t)) {
         LIN_LOG_ERROR(
-            "Dimension mismatch during matrix addition [%zu x %zu] [%zu x %zu]",
-            a->shape.rows, a->shape.columns, b->shape.rows, b->shape.columns
+            "%s holds %u byte elements but lin_decimal_t is %zu bytes",
+            path, el_size, sizeof(lin_decimal_t)
         );
-        exit(EXIT_FAILURE);
+        return false;
+    }
+
+    // the header is untrusted, so its size must both be representable and
+    // match the file before anything is allocated for it
+    struct stat st;
+    size_t bytes;
+    if ((uint64_t)(size_t)dims[0] != dims[0] ||
+        (uint64_t)(size_t)dims[1] != dims[1] ||
+        !_lin_alloc_bytes(LIN_FILE_HEADER_SIZE, (size_t)dims[0],
+                          (size_t)dims[1], &bytes)) {
+        LIN_LOG_ERROR("%s has an invalid size [%llu x %llu]", path,
+                      (unsigned long long)dims[0], (unsigned long long)dims[1]);
+        return false;
+    }
+    if (fstat(fileno(file), &st) != 0 || !S_ISREG(st.st_mode) ||
+        (uintmax_t)st.st_size != (uintmax_t)bytes) {
+        LIN_LOG_ERROR("%s does not hold [%llu x %llu] elements", path,
+                      (unsigned long long)dims[0], (unsigned long long)dims[1]);
+        return false;
+    }
+
+    shape->rows = (size_t)dims[0];
+    shape->columns = (size_t)dims[1];
+    return true;
+}
+
+bool lin_mat_save(lin_mat_t const *mat, char const *path) {
+    _LIN_TRACE(_LIN_MAT_DIMS(mat), _LIN_NO_DIMS);
+    if (mat->layout == LIN_COL_MAJOR) {
+        // files are always row-major
+        lin_mat_t *rows_copy;
+        lin_mat_t const *rows = _lin_mat_rows(mat, &rows_copy);
+        bool const ok = rows != NULL && lin_mat_save(rows, path);
+        lin_mat_free(rows_copy);
+        return ok;
+    }
+
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+        LIN_LOG_ERROR("Failed to open %s for writing", path);
+        return false;
+    }
+
+    size_t const count = mat->shape.rows * mat->shape.columns;
+    bool const ok = _lin_file_write_header(file, mat->shape) &&
+        fwrite(mat->elements, sizeof(lin_decimal_t), count, file) == count;
+    if (fclose(file) != 0 || !ok) {
+        LIN_LOG_ERROR("Failed to write matrix to %s", path);
+        return false;
+    }
+
+    return true;
+}
+
+lin_mat_t *lin_mat_load(char const *path) {
+    _LIN_TRACE(_LIN_NO_DIMS, _LIN_NO_DIMS);
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        LIN_LOG_ERROR("Failed to open %s for reading", path);
+        return NULL;
+    }
+
+    lin_mat_shape_t shape;
+    if (!_lin_file_read_header(file, path, &shape)) {
+        fclose(file);
+        return NULL;
+    }
+
+    lin_mat_t *mat = lin_mat_create(shape);
+    if (mat == NULL) {
+        fclose(file);
+        return NULL;
+    }
+
+    size_t const count = shape.rows * shape.columns;
+    if (fread(mat->elements, sizeof(lin_decimal_t), count, file) != count) {
+        LIN_LOG_ERROR("%s is truncated", path);
+        lin_mat_free(mat);
+        fclose(file);
+        return NULL;
+    }
+
+    fclose(file);
+    return mat;
+}
+
+// A matrix file opened for tiled access
+typedef struct {
+    int fd;
+    lin_mat_shape_t shape;
+    // identity of the file, to tell whether two paths name the same one
+    dev_t dev;
+    ino_t ino;
+} _lin_file_mat_t;
+
+// Reads or writes the [rows x cols] tile at (row0, col0) to/from `buf`, whose
+// rows are `cols` elements apart
+static bool _lin_file_tile_io(_lin_file_mat_t const *f, bool write,
+                              size_t row0, size_t col0, size_t rows,
+                              size_t cols, lin_decimal_t *buf) {
+    size_t const bytes = cols * sizeof(lin_decimal_t);
+    for (size_t r = 0; r < rows; r++) {
+        off_t const offset = (off_t)(LIN_FILE_HEADER_SIZE +
+            ((((row0 + r) * f->shape.columns) + col0) * sizeof(lin_decimal_t)));
+        char *p = (char *)&buf[r * cols];
+        size_t done = 0;
+        while (done < bytes) {
+            ssize_t const n = write
+                ? pwrite(f->fd, p + done, bytes - done, offset + (off_t)done)
+                : pread(f->fd, p + done, bytes - done, offset + (off_t)done);
+            if (n <= 0) {
+                return false;
+            }
+            done += (size_t)n;
+        }
+    }
+
+    return true;
+}
+
+// One multiply-accumulate step: C(i, j) += A(i, p) * B(p, j)
+typedef struct {
+    size_t i, j, p;
+} _lin_file_step_t;
+
+// I/O performed in the background while the previous step computes: flush a
+// finished C tile, then read the A and B tiles of the next step
+typedef struct {
+    _lin_file_mat_t const *a, *b, *c;
+    size_t tile;
+    _lin_file_step_t const *next;
+    lin_decimal_t *a_buf, *b_buf;
+    _lin_file_step_t const *flush;
+    lin_decimal_t *c_buf;
+    bool ok;
+} _lin_file_io_t;
+
+static void _lin_file_io(_lin_file_io_t *io) {
+    size_t const t = io->tile;
+    io->ok = true;
+
+    if (io->flush != NULL) {
+        size_t const rows = _lin_min(t, io->c->shape.rows - io->flush->i);
+        size_t const cols = _lin_min(t, io->c->shape.columns - io->flush->j);
+        io->ok = _lin_file_tile_io(io->c, true, io->flush->i, io->flush->j,
+                                   rows, cols, io->c_buf);
+    }
+
+    if (io->ok && io->next != NULL) {
+        size_t const rows = _lin_min(t, io->a->shape.rows - io->next->i);
+        size_t const inner = _lin_min(t, io->a->shape.columns - io->next->p);
+        size_t const cols = _lin_min(t, io->b->shape.columns - io->next->j);
+        io->ok = _lin_file_tile_io(io->a, false, io->next->i, io->next->p,
+                                   rows, inner, io->a_buf) &&
+            _lin_file_tile_io(io->b, false, io->next->p, io->next->j,
+                              inner, cols, io->b_buf);
+    }
+}
+
+#ifndef LIN_NO_THREADS
+static void *_lin_file_io_thread(void *arg) {
+    _lin_file_io((_lin_file_io_t *)arg);
+    return NULL;
+}
+#endif
+
+static bool _lin_file_open(_lin_file_mat_t *f, char const *path) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        LIN_LOG_ERROR("Failed to open %s for reading", path);
+        return false;
+    }
+
+    bool const ok = _lin_file_read_header(file, path, &f->shape);
+    fclose(file);
+    if (!ok) {
+        return false;
+    }
+
+    struct stat st;
+    f->fd = open(path, O_RDONLY);
+    if (f->fd < 0 || fstat(f->fd, &st) != 0) {
+        LIN_LOG_ERROR("Failed to open %s for reading", path);
+        if (f->fd >= 0) {
+            close(f->fd);
+        }
+        return false;
+    }
+
+    f->dev = st.st_dev;
+    f->ino = st.st_ino;
+    return true;
+}
+
+// Creates the output file at `path`, refusing to if it is the same file as
+// either input since clearing it would destroy that input
+static bool _lin_file_create(_lin_file_mat_t *f, char const *path,
+                             lin_mat_shape_t shape,
+                             _lin_file_mat_t const *a,
+                             _lin_file_mat_t const *b) {
+    size_t size;
+    if (!_lin_alloc_bytes(LIN_FILE_HEADER_SIZE, shape.rows, shape.columns,
+                          &size) || (off_t)size < 0) {
+        LIN_LOG_ERROR("Matrix [%zu x %zu] is too large for %s", shape.rows,
+                      shape.columns, path);
+        return false;
+    }
+
+    struct stat st;
+    f->shape = shape;
+    f->fd = open(path, O_RDWR | O_CREAT, 0666);
+    if (f->fd < 0 || fstat(f->fd, &st) != 0) {
+        LIN_LOG_ERROR("Failed to open %s for writing", path);
+        if (f->fd >= 0) {
+            close(f->fd);
+        }
+        return false;
+    }
+
+    if ((st.st_dev == a->dev && st.st_ino == a->ino) ||
+        (st.st_dev == b->dev && st.st_ino == b->ino)) {
+        LIN_LOG_ERROR("Output %s is also an input", path);
+        close(f->fd);
+        return false;
+    }
+
+    unsigned char header[LIN_FILE_HEADER_SIZE];
+    _lin_file_header(shape, header);
+    if (ftruncate(f->fd, 0) != 0 || ftruncate(f->fd, (off_t)size) != 0 ||
+        pwrite(f->fd, header, sizeof(header), 0) != (ssize_t)sizeof(header)) {
+        LIN_LOG_ERROR("Failed to write matrix header to %s", path);
+        close(f->fd);
+        return false;
+    }
+
+    return true;
+}
+
+/// Multiplies the matrices stored in the files at `a_path` and `b_path`,
+/// writing the result to `c_path`, without holding any of them in memory.
+/// Works on [tile x tile] blocks (LIN_FILE_TILE if `tile` is 0), keeping at
+/// most six of them in memory, and reads the next pair of input tiles and
+/// writes finished output tiles while the current pair is being multiplied.
+bool lin_mat_mult_file(char const *a_path, char const *b_path,
+                       char const *c_path, size_t tile) {
+    _LIN_TRACE(_LIN_NO_DIMS, _LIN_NO_DIMS);
+    size_t const t = tile == 0 ? LIN_FILE_TILE : tile;
+
+    _lin_file_mat_t a, b, c;
+    if (!_lin_file_open(&a, a_path)) {
+        return false;
+    }
+    if (!_lin_file_open(&b, b_path)) {
+        close(a.fd);
+        return false;
+    }
+
+    if (a.shape.columns != b.shape.rows) {
+        LIN_LOG_ERROR(
+            "Dimension mismatch during matrix multiplication [%zu x %zu] [%zu x %zu]",
+            a.shape.rows, a.shape.columns, b.shape.rows, b.shape.columns
+        );
+        close(a.fd);
+        close(b.fd);
+        return false;
+    }
+
+    if (!_lin_file_create(&c, c_path,
+                          (lin_mat_shape_t){a.shape.rows, b.shape.columns},
+                          &a, &b)) {
+        close(a.fd);
+        close(b.fd);
+        return false;
+    }
+
+    size_t const m = a.shape.rows;
+    size_t const k = a.shape.columns;
+    size_t const n = b.shape.columns;
+    size_t const ti = (m + t - 1) / t;
+    size_t const tj = (n + t - 1) / t;
+    size_t const tp = k == 0 ? 1 : (k + t - 1) / t;
+    size_t const steps = ti * tj * tp;
+
+    // two buffers each for the A, B and C tiles
+    size_t bufs_bytes;
+    lin_decimal_t *bufs = t <= SIZE_MAX / 6
+        && _lin_alloc_bytes(0, 6 * t, t, &bufs_bytes)
+        ? (lin_decimal_t *)malloc(bufs_bytes) : NULL;
+    if (bufs == NULL) {
+        LIN_LOG_ERROR("Failed to allocate tiles of [%zu x %zu]", t, t);
+        close(a.fd);
+        close(b.fd);
+        close(c.fd);
+        return false;
+    }
+    lin_decimal_t *a_buf[2] = {&bufs[0], &bufs[t * t]};
+    lin_decimal_t *b_buf[2] = {&bufs[2 * t * t], &bufs[3 * t * t]};
+    lin_decimal_t *c_buf[2] = {&bufs[4 * t * t], &bufs[5 * t * t]};
+
+    _lin_file_step_t step = {0, 0, 0};
+    _lin_file_step_t next = {0, 0, 0};
+    _lin_file_step_t flush = {0, 0, 0};
+    bool pending_flush = false;
+    size_t c_cur = 0;
+
+    _lin_file_io_t io = {&a, &b, &c, t, &step, a_buf[0], b_buf[0], NULL, NULL, true};
+    _lin_file_io(&io);
+    bool ok = io.ok;
+
+    for (size_t s = 0; ok && s < steps; s++) {
+        // steps run p fastest, so each C tile is finished after tp steps
+        step = (_lin_file_step_t){
+            ((s / tp) / tj) * t, ((s / tp) % tj) * t, (s % tp) * t
+        };
+        bool const has_next = s + 1 < steps;
+        if (has_next) {
+            next = (_lin_file_step_t){
+                (((s + 1) / tp) / tj) * t, (((s + 1) / tp) % tj) * t,
+                ((s + 1) % tp) * t
+            };
+        }
+
+        io = (_lin_file_io_t){
+            &a, &b, &c, t,
+            has_next ? &next : NULL, a_buf[(s + 1) % 2], b_buf[(s + 1) % 2],
+            pending_flush ? &flush : NULL, c_buf[1 - c_cur], true
+        };
+
+#ifndef LIN_NO_THREADS
+        pthread_t io_thread;
+        bool const async = pthread_create(&io_thread, NULL,
+                                          _lin_file_io_thread, &io) == 0;
+        if (!async) {
+            _lin_file_io(&io);
+        }
+#else
+        _lin_file_io(&io);
+#endif
+
+        size_t const rows = _lin_min(t, m - step.i);
+        size_t const cols = _lin_min(t, n - step.j);
+        size_t const inner = _lin_min(t, k - step.p);
+        _lin_gemm(false, false, rows, cols, inner, 1,
+                  a_buf[s % 2], inner, b_buf[s % 2], cols,
+                  step.p == 0 ? (lin_decimal_t)0 : (lin_decimal_t)1,
+                  c_buf[c_cur], cols);
+
+#ifndef LIN_NO_THREADS
+        if (async) {
+            pthread_join(io_thread, NULL);
+        }
+#endif
+        ok = io.ok;
+        pending_flush = false;
+
+        if ((s + 1) % tp == 0) {
+            flush = step;
+            pending_flush = true;
+            c_cur = 1 - c_cur;
+        }
+    }
+
+    if (ok && pending_flush) {
+        io = (_lin_file_io_t){
+            &a, &b, &c, t, NULL, NULL, NULL, &flush, c_buf[1 - c_cur], true
+        };
+        _lin_file_io(&io);
+        ok = io.ok;
+    }
+
+    if (!ok) {
+        LIN_LOG_ERROR("I/O error while multiplying %s and %s into %s",
+                      a_path, b_path, c_path);
+    }
+
+    free(bufs);
+    close(a.fd);
+    close(b.fd);
+    if (close(c.fd) != 0) {
+        ok = false;
+    }
+    return ok;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// TEXT DECLARATION
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Matrices as text: one row per line, values separated by whitespace, commas
+// or semicolons. Blank lines and anything after a `#` are ignored. Input is
+// read and output written through a buffer of LIN_TEXT_BUFFER bytes, so only
+// the matrix itself is ever held in memory, and `lin_mat_text_to_file` /
+// `lin_mat_file_to_text` convert to and from matrix files without even that.
+
+#ifndef LIN_TEXT_BUFFER
+#define LIN_TEXT_BUFFER ((size_t)1 << 16)
+#endif
+
+lin_mat_t *lin_mat_read_text(FILE *text);
+bool lin_mat_write_text(lin_mat_t const *mat, FILE *text, char sep);
+bool lin_mat_text_to_file(FILE *text, char const *path);
+bool lin_mat_file_to_text(char const *path, FILE *text, char sep);
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// TEXT IMPLEMENTATION
+//
+///////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+    FILE *file;
+    char *buf;
+    size_t pos, len;
+    bool eof, error;
+    // 1-based numbers of the line being read and of the line the last row
+    // was read from, for error messages
+    size_t line, row_line;
+    // values of the last row read
+    lin_decimal_t *row;
+    size_t row_capacity;
+} _lin_text_reader_t;
+
+static bool _lin_text_reader_init(_lin_text_reader_t *r, FILE *file) {
+    *r = (_lin_text_reader_t){file, NULL, 0, 0, false, false, 1, 1, NULL, 0};
+    r->buf = (char *)malloc(LIN_TEXT_BUFFER);
+    if (r->buf == NULL) {
+        LIN_LOG_ERROR("Failed to allocate text buffer");
+        return false;
+    }
+    return true;
+}
+
+static void _lin_text_reader_free(_lin_text_reader_t *r) {
+    free(r->buf);
+    free(r->row);
+}
+
+// Makes sure at least `need` bytes are buffered, unless the input ends first.
+// Returns false once everything has been consumed.
+static bool _lin_text_fill_n(_lin_text_reader_t *r, size_t need) {
+    if (r->len - r->pos >= need || r->eof) {
+        return r->pos < r->len;
+    }
+
+    memmove(r->buf, &r->buf[r->pos], r->len - r->pos);
+    r->len -= r->pos;
+    r->pos = 0;
+
+    size_t const want = LIN_TEXT_BUFFER - r->len;
+    size_t const got = fread(&r->buf[r->len], 1, want, r->file);
+    r->len += got;
+    if (got < want) {
+        r->eof = true;
+        if (ferror(r->file)) {
+            LIN_LOG_ERROR("Failed to read text input");
+            r->error = true;
+            return false;
+        }
+    }
+
+    return r->pos < r->len;
+}
+
+// Makes sure a token of typical length is buffered
+static bool _lin_text_fill(_lin_text_reader_t *r) {
+    return _lin_text_fill_n(r, _LIN_DECIMAL_TOKEN);
+}
+
+// Makes sure the whole token at `r->pos` is buffered, however long, unless it
+// does not fit in the buffer at all
+static void _lin_text_fill_token(_lin_text_reader_t *r) {
+    size_t scanned = 0;
+    for (;;) {
+        while (r->pos + scanned < r->len
+               && !_lin_decimal_is_sep(r->buf[r->pos + scanned])) {
+            scanned++;
+        }
+        if (r->pos + scanned < r->len || r->eof || scanned == LIN_TEXT_BUFFER
+            || !_lin_text_fill_n(r, scanned + 1) || r->error) {
+            return;
+        }
+    }
+}
+
+// Reads the next non-empty row into `r->row`, storing its length in `n`.
+// Returns false at the end of the input or on error.
+static bool _lin_text_read_row(_lin_text_reader_t *r, size_t *n) {
+    *n = 0;
+    while (_lin_text_fill(r)) {
+        char const c = r->buf[r->pos];
+        if (c == '\n') {
+            r->pos++;
+            r->line++;
+            if (*n > 0) {
+                return true;
+            }
+            continue;
+        }
+
+        if (c == '#') {
+            while (_lin_text_fill(r) && r->buf[r->pos] != '\n') {
+                r->pos++;
+            }
+            continue;
+        }
+
+        if (_lin_decimal_is_sep(c)) {
+            r->pos++;
+            continue;
+        }
+
+        _lin_text_fill_token(r);
+        if (r->error) {
+            return false;
+        }
+        lin_decimal_t value;
+        char const *const end = &r->buf[r->len];
+        char const *next = _lin_decimal_parse(&r->buf[r->pos], end, &value);
+        if (next == NULL || (next == end && !r->eof)
+            || (next < end && !_lin_decimal_is_sep(*next))) {
+            LIN_LOG_ERROR("Invalid number on line %zu of text input", r->line);
+            r->error = true;
+            return false;
+        }
+        r->pos = (size_t)(next - r->buf);
+        if (*n == 0) {
+            r->row_line = r->line;
+        }
+
+        if (*n == r->row_capacity) {
+            size_t const capacity = r->row_capacity == 0 ? 16 : 2 * r->row_capacity;
+            lin_decimal_t *row = (lin_decimal_t *)realloc(
+                r->row, capacity * sizeof(lin_decimal_t)
+            );
+            if (row == NULL) {
+                LIN_LOG_ERROR("Failed to allocate row of %zu values", capacity);
+                r->error = true;
+                return false;
+            }
+            r->row = row;
+            r->row_capacity = capacity;
+        }
+        r->row[(*n)++] = value;
+    }
+
+    return *n > 0;
+}
+
+// Checks that every row read has the same number of values as the first
+static bool _lin_text_check_row(_lin_text_reader_t *r, size_t rows,
+                                size_t columns, size_t n) {
+    if (rows > 0 && n != columns) {
+        LIN_LOG_ERROR("Line %zu of text input has %zu values, expected %zu",
+                      r->row_line, n, columns);
+        return false;
+    }
+    return true;
+}
+
+/// Reads a matrix written as text from `text`, up to the end of the input.
+/// Returns NULL if the input is malformed, empty, or has ragged rows.
+lin_mat_t *lin_mat_read_text(FILE *text) {
+    _LIN_TRACE(_LIN_NO_DIMS, _LIN_NO_DIMS);
+    _lin_text_reader_t r;
+    if (!_lin_text_reader_init(&r, text)) {
+        return NULL;
+    }
+
+    // rows are appended to the elements of `mat`, which grows geometrically
+    // and is given its real shape at the end
+    lin_mat_t *mat = NULL;
+    size_t rows = 0, columns = 0, n;
+    while (_lin_text_read_row(&r, &n)) {
+        if (!_lin_text_check_row(&r, rows, columns, n)) {
+            r.error = true;
+            break;
+        }
+        columns = n;
+
+        size_t const count = rows * columns;
+        if (mat == NULL || count + n > mat->capacity) {
+            lin_mat_t *grown = lin_mat_create((lin_mat_shape_t){
+                1, mat == NULL ? 16 * n : 2 * mat->capacity
+            });
+            if (grown == NULL) {
+                r.error = true;
+                break;
+            }
+            if (mat != NULL) {
+                memcpy(grown->elements, mat->elements,
+                       count * sizeof(lin_decimal_t));
+                lin_mat_free(mat);
+            }
+            mat = grown;
+        }
+
+        memcpy(&mat->elements[count], r.row, n * sizeof(lin_decimal_t));
+        rows++;
+    }
+
+    _lin_text_reader_free(&r);
+    if (r.error || mat == NULL) {
+        if (!r.error) {
+            LIN_LOG_ERROR("Text input holds no values");
+        }
+        if (mat != NULL) {
+            lin_mat_free(mat);
+        }
+        return NULL;
+    }
+
+    mat->shape = (lin_mat_shape_t){rows, columns};
+    return mat;
+}
+
+typedef struct {
+    FILE *file;
+    char *buf;
+    size_t len;
+    char sep;
+} _lin_text_writer_t;
+
+static bool _lin_text_flush(_lin_text_writer_t *w) {
+    bool const ok = fwrite(w->buf, 1, w->len, w->file) == w->len;
+    w->len = 0;
+    return ok;
+}
+
+// Appends `rows` rows of `columns` values, one line each
+static bool _lin_text_write_rows(_lin_text_writer_t *w,
+                                 lin_decimal_t const *elements,
+                                 size_t rows, size_t columns) {
+    for (size_t i = 0; i < rows; i++) {
+        for (size_t j = 0; j < columns; j++) {
+            if (LIN_TEXT_BUFFER - w->len < _LIN_DECIMAL_TOKEN + 2
+                && !_lin_text_flush(w)) {
+                return false;
+            }
+            if (j > 0) {
+                w->buf[w->len++] = w->sep;
+            }
+            w->len += _lin_decimal_format(elements[(i * columns) + j],
+                                          &w->buf[w->len]);
+        }
+        w->buf[w->len++] = '\n';
+    }
+    return true;
+}
+
+/// Writes `mat` as text, using `sep` (e.g. ' ' or ',') between values. Each
+/// value is written with the fewest digits that read back to the same value.
+bool lin_mat_write_text(lin_mat_t const *mat, FILE *text, char sep) {
+    _LIN_TRACE(_LIN_MAT_DIMS(mat), _LIN_NO_DIMS);
+    if (mat->layout == LIN_COL_MAJOR) {
+        lin_mat_t *rows_copy;
+        lin_mat_t const *rows = _lin_mat_rows(mat, &rows_copy);
+        bool const ok = rows != NULL && lin_mat_write_text(rows, text, sep);
+        lin_mat_free(rows_copy);
+        return ok;
+    }
+
+    _lin_text_writer_t w = {text, (char *)malloc(LIN_TEXT_BUFFER), 0, sep};
+    if (w.buf == NULL) {
+        LIN_LOG_ERROR("Failed to allocate text buffer");
+        return false;
+    }
+
+    bool const ok = _lin_text_write_rows(&w, mat->elements, mat->shape.rows,
+                                         mat->shape.columns)
+        && _lin_text_flush(&w) && fflush(text) == 0;
+    free(w.buf);
+    if (!ok) {
+        LIN_LOG_ERROR("Failed to write matrix as text");
+    }
+    return ok;
+}
+
+/// Converts a matrix written as text to a matrix file at `path`, a row at a
+/// time, so the matrix never has to fit in memory
+bool lin_mat_text_to_file(FILE *text, char const *path) {
+    _LIN_TRACE(_LIN_NO_DIMS, _LIN_NO_DIMS);
+    _lin_text_reader_t r;
+    if (!_lin_text_reader_init(&r, text)) {
+        return false;
+    }
+
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+        LIN_LOG_ERROR("Failed to open %s for writing", path);
+        _lin_text_reader_free(&r);
+        return false;
+    }
+
+    // the header is written again once the number of rows is known
+    bool ok = _lin_file_write_header(file, (lin_mat_shape_t){0, 0});
+    size_t rows = 0, columns = 0, n;
+    while (ok && _lin_text_read_row(&r, &n)) {
+        if (!_lin_text_check_row(&r, rows, columns, n)) {
+            r.error = true;
+            break;
+        }
+        columns = n;
+        ok = fwrite(r.row, sizeof(lin_decimal_t), n, file) == n;
+        rows++;
+    }
+
+    ok = ok && !r.error && rows > 0 && fseek(file, 0, SEEK_SET) == 0
+        && _lin_file_write_header(file, (lin_mat_shape_t){rows, columns});
+    if (fclose(file) != 0) {
+        ok = false;
+    }
+    if (!ok && !r.error) {
+        if (rows == 0) {
+            LIN_LOG_ERROR("Text input holds no values");
+        } else {
+            LIN_LOG_ERROR("Failed to write matrix to %s", path);
+        }
+    }
+
+    _lin_text_reader_free(&r);
+    return ok;
+}
+
+/// Converts the matrix file at `path` to text, a block of rows at a time
+bool lin_mat_file_to_text(char const *path, FILE *text, char sep) {
+    _LIN_TRACE(_LIN_NO_DIMS, _LIN_NO_DIMS);
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        LIN_LOG_ERROR("Failed to open %s for reading", path);
+        return false;
+    }
+
+    lin_mat_shape_t shape;
+    if (!_lin_file_read_header(file, path, &shape)) {
+        fclose(file);
+        return false;
+    }
+
+    // as many whole rows as fit in a text buffer's worth of elements
+    size_t const columns = shape.columns == 0 ? 1 : shape.columns;
+    size_t block = LIN_TEXT_BUFFER / sizeof(lin_decimal_t) / columns;
+    block = block == 0 ? 1 : block;
+
+    _lin_text_writer_t w = {text, (char *)malloc(LIN_TEXT_BUFFER), 0, sep};
+    lin_decimal_t *rows = (lin_decimal_t *)malloc(
+        block * columns * sizeof(lin_decimal_t)
+    );
+    bool ok = w.buf != NULL && rows != NULL;
+    if (!ok) {
+        LIN_LOG_ERROR("Failed to allocate text conversion buffers");
     }
 
-    lin_mat_t *res = lin_mat_create(a->shape);
-    for (size_t row = 0; row < a->shape.rows; row++) {
-        for (size_t col = 0; col < a->shape.columns; col++) {
-            res->elements[(row * res->shape.columns) + col] = 
-                a->elements[(row * a->shape.columns) + col] - 
-                b->elements[(row * b->shape.columns) + col];
+    for (size_t i = 0; ok && i < shape.rows; i += block) {
+        size_t const count = _lin_min(block, shape.rows - i);
+        if (fread(rows, sizeof(lin_decimal_t), count * shape.columns, file)
+            != count * shape.columns) {
+            LIN_LOG_ERROR("%s is truncated", path);
+            ok = false;
+            break;
         }
+        ok = _lin_text_write_rows(&w, rows, count, shape.columns);
     }
 
-    return res;
-}
-
-lin_mat_t *lin_mat_scalar_mult(lin_mat_t const *a, lin_decimal_t k) {
-    lin_mat_t *res = lin_mat_create(a->shape);
-    for (size_t row = 0; row < a->shape.rows; row++) {
-        for (size_t col = 0; col < a->shape.columns; col++) {
-            res->elements[(row * res->shape.columns) + col] = 
-                a->elements[(row * a->shape.columns) + col] * k;
-        }
+    if (ok && !(_lin_text_flush(&w) && fflush(text) == 0)) {
+        LIN_LOG_ERROR("Failed to write matrix as text");
+        ok = false;
     }
 
-    return res;
+    free(rows);
+    free(w.buf);
+    fclose(file);
+    return ok;
 }
 
-lin_mat_t *lin_mat_transpose(lin_mat_t const *a) {
-    lin_mat_t *res = lin_mat_create((lin_mat_shape_t){
-        a->shape.columns, a->shape.rows
-    });
-    for (size_t col = 0; col < a->shape.columns; col++) {
-        for (size_t row = 0; row < a->shape.rows; row++) {
-            res->elements[(col * res->shape.columns) + row] = 
-                a->elements[(row * res->shape.rows) + col];
-        }
-    }
+///////////////////////////////////////////////////////////////////////////////
+//
+// JOB DECLARATION
+//
+///////////////////////////////////////////////////////////////////////////////
 
-    return res;
-}
+// Asynchronous jobs run on a pool of `lin_get_num_threads()` worker threads,
+// started on first use. A job starts once the jobs it depends on have
+// finished, so a DAG of operations can be submitted up front and runs with
+// as much parallelism as its edges allow.
+//
+// Matrix operations take operands that are either matrices or the results
+// of other jobs, which adds the dependency edges implicitly:
+//
+// lin_job_t *ab = lin_job_mat_mult(LIN_JOB_MAT(a), LIN_JOB_MAT(b));
+// lin_job_t *cd = lin_job_mat_mult(LIN_JOB_MAT(c), LIN_JOB_MAT(d));
+// lin_job_t *sum = lin_job_mat_add(LIN_JOB_RESULT(ab), LIN_JOB_RESULT(cd));
+// lin_mat_t *res = lin_job_wait(sum);
+// lin_job_free(ab);
+// lin_job_free(cd);
+// lin_job_free(sum);
+//
+// As with the synchronous functions, the caller owns every result returned
+// by `lin_job_wait` and frees it once no pending job uses it. The matrix
+// results of operations that are never waited for are freed with the job,
+// once its handle is released and no job using the result is pending. If an operand
+// job produced NULL, so do the jobs using it. With `LIN_NO_THREADS`, or if
+// no worker thread can be started, jobs run on the calling thread as they are
+// submitted.
 
-lin_decimal_t lin_mat_det(lin_mat_t const *a) {
-    if (a->shape.rows != a->shape.columns) {
-        LIN_LOG_ERROR(
-            "Cannot take determinant of non-square matrix [%zu x %zu]",
-            a->shape.rows, a->shape.columns
-        );
-        exit(EXIT_FAILURE);
-    }
+typedef struct lin_job lin_job_t;
 
-    size_t n = a->shape.rows;
+typedef void *(*lin_job_fn_t)(void *arg);
 
-    if (n == 1) {
-        return a->elements[0];
+typedef struct {
+    lin_mat_t const *mat;
+    lin_job_t *job;
+} lin_job_operand_t;
+
+#define LIN_JOB_MAT(m) ((lin_job_operand_t){(m), NULL})
+#define LIN_JOB_RESULT(j) ((lin_job_operand_t){NULL, (j)})
+
+lin_job_t *lin_job_submit(lin_job_fn_t fn, void *arg,
+                          lin_job_t *const *deps, size_t dep_count);
+lin_job_t *lin_job_mat_mult(lin_job_operand_t a, lin_job_operand_t b);
+lin_job_t *lin_job_mat_add(lin_job_operand_t a, lin_job_operand_t b);
+lin_job_t *lin_job_mat_sub(lin_job_operand_t a, lin_job_operand_t b);
+lin_job_t *lin_job_mat_transpose(lin_job_operand_t a);
+lin_job_t *lin_job_mat_inv(lin_job_operand_t a);
+lin_job_t *lin_job_mat_solve(lin_job_operand_t a, lin_job_operand_t b);
+bool lin_job_poll(lin_job_t *job);
+void *lin_job_wait(lin_job_t *job);
+void lin_job_free(lin_job_t *job);
+void lin_job_shutdown(void);
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// JOB IMPLEMENTATION
+//
+///////////////////////////////////////////////////////////////////////////////
+
+typedef enum {
+    _LIN_JOB_FN,
+    _LIN_JOB_MULT,
+    _LIN_JOB_ADD,
+    _LIN_JOB_SUB,
+    _LIN_JOB_TRANSPOSE,
+    _LIN_JOB_INV,
+    _LIN_JOB_SOLVE,
+} _lin_job_op_t;
+
+struct lin_job {
+    _lin_job_op_t op;
+    lin_job_fn_t fn;
+    void *arg;
+    lin_job_operand_t operands[2];
+    // jobs this one waits for, each holding a reference until it finishes
+    lin_job_t **deps;
+    size_t dep_count;
+    // jobs waiting for this one
+    lin_job_t **dependents;
+    size_t dependent_count, dependent_capacity;
+    // unfinished dependencies, and references from the caller's handle,
+    // the pool until the job finishes, and dependent jobs
+    size_t pending, refs;
+    bool done;
+    void *result;
+    // whether `result` was handed to the caller by `lin_job_wait`, otherwise
+    // a matrix result is freed along with the job
+    bool claimed;
+    // next job in the ready queue
+    lin_job_t *next;
+};
+
+typedef struct {
+    bool started, stopping;
+    size_t workers;
+    lin_job_t *head, *tail;
+#ifndef LIN_NO_THREADS
+    pthread_t threads[LIN_MAX_THREADS];
+    pthread_mutex_t lock;
+    // signalled when a job becomes ready, and when one finishes
+    pthread_cond_t ready, finished;
+#endif
+} _lin_job_pool_t;
+
+static _lin_job_pool_t _lin_job_pool = {
+    false, false, 0, NULL, NULL,
+#ifndef LIN_NO_THREADS
+    {0}, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER,
+    PTHREAD_COND_INITIALIZER,
+#endif
+};
+
+#ifndef LIN_NO_THREADS
+#define _LIN_JOB_LOCK() pthread_mutex_lock(&_lin_job_pool.lock)
+#define _LIN_JOB_UNLOCK() pthread_mutex_unlock(&_lin_job_pool.lock)
+#else
+#define _LIN_JOB_LOCK() ((void)0)
+#define _LIN_JOB_UNLOCK() ((void)0)
+#endif
+
+static lin_mat_t const *_lin_job_operand(lin_job_operand_t operand) {
+    return operand.job != NULL ? (lin_mat_t const *)operand.job->result
+        : operand.mat;
+}
+
+// Drops a reference to `job`, freeing it with the last one. Called with the
+// pool locked.
+static void _lin_job_release(lin_job_t *job) {
+    if (--job->refs > 0) {
+        return;
     }
 
-    if (n == 2) {
-        return a->elements[0] * a->elements[3] -
-            a->elements[1] * a->elements[2];
+    // nobody can retrieve the result any more; what a user function returns
+    // is opaque, so only matrices from the built-in operations are freed
+    if (!job->claimed && job->op != _LIN_JOB_FN) {
+        lin_mat_free((lin_mat_t *)job->result);
     }
+    free(job->deps);
+    free(job->dependents);
+    free(job);
+}
 
-    if (n == 3) {
-        return (a->elements[0] * a->elements[4] * a->elements[8]) +
-        (a->elements[1] * a->elements[5] * a->elements[6]) +
-        (a->elements[2] * a->elements[3] * a->elements[7]) -
-        (a->elements[2] * a->elements[4] * a->elements[6]) -
-        (a->elements[1] * a->elements[3] * a->elements[8]) -
-        (a->elements[0] * a->elements[5] * a->elements[7]);
+static void *_lin_job_run_op(lin_job_t *job) {
+    if (job->op == _LIN_JOB_FN) {
+        return job->fn(job->arg);
     }
 
-    lin_decimal_t res = 0;
-    for (size_t col = 0; col < n; ++col) {
-        lin_mat_t *sub = lin_mat_create((lin_mat_shape_t){n - 1, n - 1});
-        for (size_t i = 1; i < n; ++i) {
-            int sub_col = 0;
-            for (size_t j = 0; j < n; j++) {
-                if (j == col) {
-                    continue;
-                }
+    lin_mat_t const *a = _lin_job_operand(job->operands[0]);
+    lin_mat_t const *b = _lin_job_operand(job->operands[1]);
+    bool const binary = job->op == _LIN_JOB_MULT || job->op == _LIN_JOB_ADD
+        || job->op == _LIN_JOB_SUB || job->op == _LIN_JOB_SOLVE;
+    if (a == NULL || (binary && b == NULL)) {
+        return NULL;
+    }
 
-                sub->elements[((i - 1) * sub->shape.columns) + sub_col] = 
-                    a->elements[(i * a->shape.columns) + j];
-                sub_col += 1;
+    switch (job->op) {
+        case _LIN_JOB_MULT: return lin_mat_mult(a, b);
+        case _LIN_JOB_ADD: return lin_mat_add(a, b);
+        case _LIN_JOB_SUB: return lin_mat_sub(a, b);
+        case _LIN_JOB_TRANSPOSE: return lin_mat_transpose(a);
+        case _LIN_JOB_INV: {
+            lin_mat_lu_t *lu = lin_mat_lu(a);
+            if (lu == NULL) {
+                return NULL;
             }
+            lin_mat_t *id = lin_mat_identity(a->shape.rows);
+            lin_mat_t *inv = lin_mat_lu_solve(lu, id);
+            lin_mat_free(id);
+            lin_mat_lu_free(lu);
+            return inv;
         }
-        int sign = (col % 2 == 0) ? 1: -1;
-        res += sign * a->elements[col] * lin_mat_det(sub);
+        case _LIN_JOB_SOLVE: {
+            lin_mat_lu_t *lu = lin_mat_lu(a);
+            if (lu == NULL) {
+                return NULL;
+            }
+            lin_mat_t *x = lin_mat_lu_solve(lu, b);
+            lin_mat_lu_free(lu);
+            return x;
+        }
+        case _LIN_JOB_FN: break;
+        default: break;
     }
+    return NULL;
+}
 
-    return res;
+// Appends a job whose dependencies have all finished to the ready queue.
+// Called with the pool locked.
+static void _lin_job_enqueue(lin_job_t *job) {
+    job->next = NULL;
+    if (_lin_job_pool.tail == NULL) {
+        _lin_job_pool.head = job;
+    } else {
+        _lin_job_pool.tail->next = job;
+    }
+    _lin_job_pool.tail = job;
+#ifndef LIN_NO_THREADS
+    pthread_cond_signal(&_lin_job_pool.ready);
+#endif
 }
 
-/// Where `n` is the dimension [n x n] of the output matrix
-lin_mat_t *lin_mat_identity(size_t n) {
-    lin_mat_t *res = lin_mat_create((lin_mat_shape_t){n, n});
+// Runs `job`, which must have been taken off the ready queue, and releases
+// its dependents. Called with the pool unlocked.
+static void _lin_job_execute(lin_job_t *job) {
+    void *result = _lin_job_run_op(job);
 
-    for (size_t i = 0; i < n; i++) {
-        for (size_t j = 0; j < n; j++) {
-            if (j != i) {
-                res->elements[(i * res->shape.columns) + j] = (lin_decimal_t)0;
-            }
+    _LIN_JOB_LOCK();
+    job->result = result;
+    job->done = true;
+    for (size_t i = 0; i < job->dependent_count; i++) {
+        if (--job->dependents[i]->pending == 0) {
+            _lin_job_enqueue(job->dependents[i]);
         }
-        res->elements[(i * res->shape.columns) + i] = (lin_decimal_t)1;
     }
-
-    return res;
+    for (size_t i = 0; i < job->dep_count; i++) {
+        _lin_job_release(job->deps[i]);
+    }
+    job->dep_count = 0;
+#ifndef LIN_NO_THREADS
+    pthread_cond_broadcast(&_lin_job_pool.finished);
+#endif
+    _lin_job_release(job);
+    _LIN_JOB_UNLOCK();
 }
 
-// zero indexed
-lin_mat_t *lin_mat_row(lin_mat_t const *a, size_t n) {
-    lin_mat_t *row = lin_mat_create((lin_mat_shape_t){1, a->shape.columns});
-    for (size_t i = 0; i < a->shape.columns; i++) {
-        row->elements[i] = a->elements[(n * a->shape.columns) + i];
+#ifndef LIN_NO_THREADS
+static void *_lin_job_worker(void *arg) {
+    (void)arg;
+    _LIN_JOB_LOCK();
+    for (;;) {
+        while (_lin_job_pool.head == NULL && !_lin_job_pool.stopping) {
+            pthread_cond_wait(&_lin_job_pool.ready, &_lin_job_pool.lock);
+        }
+        if (_lin_job_pool.head == NULL) {
+            break;
+        }
+
+        lin_job_t *job = _lin_job_pool.head;
+        _lin_job_pool.head = job->next;
+        if (_lin_job_pool.head == NULL) {
+            _lin_job_pool.tail = NULL;
+        }
+
+        _LIN_JOB_UNLOCK();
+        _lin_job_execute(job);
+        _LIN_JOB_LOCK();
     }
-    return row;
+    _LIN_JOB_UNLOCK();
+    return NULL;
 }
 
-// zero indexed
-lin_mat_t *lin_mat_col(lin_mat_t const *a, size_t n) {
-    lin_mat_t *col = lin_mat_create((lin_mat_shape_t){a->shape.rows, 1});
-    for (size_t i = 0; i < a->shape.rows; i++) {
-        col->elements[i] = a->elements[(i * a->shape.columns) + n];
+// Starts the workers if they are not running yet, returning false if none
+// could be started. Called with the pool locked.
+static bool _lin_job_start(void) {
+    if (_lin_job_pool.started) {
+        return true;
     }
-    return col;
-}
 
-// zero indexed
-lin_vec_t *lin_mat_row_vec(lin_mat_t const *a, size_t n) {
-    lin_vec_t *row = (lin_vec_t *)malloc(sizeof(lin_vec_t));
-    row->dim = a->shape.columns;
-    row->elements = (lin_decimal_t *)malloc(
-        sizeof(lin_decimal_t) * a->shape.columns
-    );
-    for (size_t i = 0; i < a->shape.columns; i++) {
-        row->elements[i] = a->elements[(n * a->shape.columns) + i];
+    _lin_job_pool.stopping = false;
+    _lin_job_pool.workers = 0;
+    size_t const threads = lin_get_num_threads();
+    for (size_t i = 0; i < threads; i++) {
+        if (pthread_create(&_lin_job_pool.threads[_lin_job_pool.workers], NULL,
+                           _lin_job_worker, NULL) == 0) {
+            _lin_job_pool.workers++;
+        }
     }
-    return row;
-}
 
-// zero indexed
-lin_vec_t *lin_mat_col_vec(lin_mat_t const *a, size_t n) {
-    lin_vec_t *col = (lin_vec_t *)malloc(sizeof(lin_vec_t));
-    col->dim = a->shape.columns;
-    col->elements = (lin_decimal_t *)malloc(
-        sizeof(lin_decimal_t) * a->shape.columns
-    );
-    for (size_t i = 0; i < a->shape.rows; i++) {
-        col->elements[i] = a->elements[(i * a->shape.columns) + n];
+    // tried again on the next submission
+    _lin_job_pool.started = _lin_job_pool.workers > 0;
+    if (!_lin_job_pool.started) {
+        LIN_LOG_ERROR("Failed to start job worker threads, running jobs on "
+                      "the calling thread");
     }
-    return col;
+    return _lin_job_pool.started;
 }
+#endif
 
-lin_decimal_t lin_mat_minor_of_element(lin_mat_t const *a, size_t row, size_t col) {
-    if (a->shape.rows != a->shape.columns) {
-        LIN_LOG_ERROR(
-            "Cannot take minor of element of non-square matrix [%zu x %zu]",
-            a->shape.rows, a->shape.columns
-        );
-        exit(EXIT_FAILURE);
+static lin_job_t *_lin_job_create(_lin_job_op_t op, lin_job_fn_t fn, void *arg,
+                                  lin_job_operand_t a, lin_job_operand_t b,
+                                  lin_job_t *const *deps, size_t dep_count) {
+    size_t const count = dep_count + (a.job != NULL) + (b.job != NULL);
+    lin_job_t *job = (lin_job_t *)malloc(sizeof(lin_job_t));
+    lin_job_t **job_deps = count == 0 ? NULL
+        : (lin_job_t **)malloc(count * sizeof(lin_job_t *));
+    if (job == NULL || (count > 0 && job_deps == NULL)) {
+        LIN_LOG_ERROR("Failed to allocate job");
+        free(job);
+        free(job_deps);
+        return NULL;
     }
 
-    size_t n = a->shape.rows;
-    lin_mat_t *sub = lin_mat_create((lin_mat_shape_t){n - 1, n - 1});
+    *job = (lin_job_t){
+        op, fn, arg, {a, b}, job_deps, 0, NULL, 0, 0, 0, 2, false, NULL, false,
+        NULL
+    };
+    for (size_t i = 0; i < dep_count; i++) {
+        job->deps[job->dep_count++] = deps[i];
+    }
+    if (a.job != NULL) {
+        job->deps[job->dep_count++] = a.job;
+    }
+    if (b.job != NULL) {
+        job->deps[job->dep_count++] = b.job;
+    }
 
-    bool passed_row = false;
-    for (size_t i = 0; i < a->shape.rows; i++) {
-        if (i == row) {
-            passed_row = true;
+    _LIN_JOB_LOCK();
+    // without workers every job runs as it is submitted, by which time the
+    // jobs it depends on have already run the same way
+#ifndef LIN_NO_THREADS
+    bool const threaded = _lin_job_start();
+#else
+    bool const threaded = false;
+#endif
+    bool ok = true;
+    for (size_t i = 0; i < job->dep_count; i++) {
+        lin_job_t *dep = job->deps[i];
+        dep->refs++;
+        if (dep->done || !ok) {
             continue;
         }
 
-        bool passed_col = false;
-        for (size_t j = 0; j < a->shape.columns; j++) {
-            if (j == col) {
-                passed_col = true;
+        if (dep->dependent_count == dep->dependent_capacity) {
+            size_t const capacity = dep->dependent_capacity == 0 ? 4
+                : 2 * dep->dependent_capacity;
+            lin_job_t **dependents = (lin_job_t **)realloc(
+                dep->dependents, capacity * sizeof(lin_job_t *)
+            );
+            if (dependents == NULL) {
+                ok = false;
                 continue;
             }
-
-            size_t sub_row = passed_row ? i - 1 : i;
-            size_t sub_col = passed_col ? j - 1 : j;
-            sub->elements[(sub_row * sub->shape.columns) + sub_col] = 
-                a->elements[(i * a->shape.columns) + j];
+            dep->dependents = dependents;
+            dep->dependent_capacity = capacity;
         }
+        dep->dependents[dep->dependent_count++] = job;
+        job->pending++;
     }
 
-    return lin_mat_det(sub);
-}
-
-lin_mat_t *lin_mat_minor(lin_mat_t const *a) {
-    if (a->shape.rows != a->shape.columns) {
-        LIN_LOG_ERROR(
-            "Cannot find minor matrix of non-square matrix [%zu x %zu]",
-            a->shape.rows, a->shape.columns
-        );
-        exit(EXIT_FAILURE);
+    if (!ok) {
+        // cannot be unlinked from the dependents lists of its dependencies
+        // any more, so let it finish with a NULL result
+        LIN_LOG_ERROR("Failed to allocate job dependency");
+        job->op = _LIN_JOB_MULT;
+        job->operands[0] = LIN_JOB_MAT(NULL);
     }
 
-    lin_mat_t *res = lin_mat_create(a->shape);
-
-    for (size_t row = 0; row < a->shape.rows; row++) {
-        for (size_t col = 0; col < a->shape.columns; col++) {
-            res->elements[(row * res->shape.columns) + col] = 
-                lin_mat_minor_of_element(a, row, col);
-        }
+    bool const ready = job->pending == 0;
+    if (ready && threaded) {
+        _lin_job_enqueue(job);
     }
+    _LIN_JOB_UNLOCK();
 
-    return res;
-}
-
-lin_decimal_t lin_mat_cofactor_of_element(lin_mat_t const *a, size_t row, size_t col) {
-    if (a->shape.rows != a->shape.columns) {
-        LIN_LOG_ERROR(
-            "Cannot find cofactor of element of non-square matrix [%zu x %zu]",
-            a->shape.rows, a->shape.columns
-        );
-        exit(EXIT_FAILURE);
+    if (ready && !threaded) {
+        _lin_job_execute(job);
     }
+    return job;
+}
 
-    lin_decimal_t min = lin_mat_minor_of_element(a, row, col);
-    lin_decimal_t mul  = (lin_decimal_t)pow(-1.0, (double)(row + col));
+/// Runs `fn(arg)` once the `dep_count` jobs in `deps` have finished. What
+/// `fn` returns becomes the job's result.
+lin_job_t *lin_job_submit(lin_job_fn_t fn, void *arg,
+                          lin_job_t *const *deps, size_t dep_count) {
+    _LIN_TRACE(_LIN_NO_DIMS, _LIN_NO_DIMS);
+    return _lin_job_create(_LIN_JOB_FN, fn, arg, LIN_JOB_MAT(NULL),
+                           LIN_JOB_MAT(NULL), deps, dep_count);
+}
 
-    return mul * min;
+lin_job_t *lin_job_mat_mult(lin_job_operand_t a, lin_job_operand_t b) {
+    _LIN_TRACE(_LIN_NO_DIMS, _LIN_NO_DIMS);
+    return _lin_job_create(_LIN_JOB_MULT, NULL, NULL, a, b, NULL, 0);
 }
 
-lin_mat_t *lin_mat_cofactor(lin_mat_t const *a) {
-    if (a->shape.rows != a->shape.columns) {
-        LIN_LOG_ERROR(
-            "Cannot find cofactor matrix of non-square matrix [%zu x %zu]",
-            a->shape.rows, a->shape.columns
-        );
-        exit(EXIT_FAILURE);
-    }
+lin_job_t *lin_job_mat_add(lin_job_operand_t a, lin_job_operand_t b) {
+    _LIN_TRACE(_LIN_NO_DIMS, _LIN_NO_DIMS);
+    return _lin_job_create(_LIN_JOB_ADD, NULL, NULL, a, b, NULL, 0);
+}
 
-    lin_mat_t *res = lin_mat_create(a->shape);
+lin_job_t *lin_job_mat_sub(lin_job_operand_t a, lin_job_operand_t b) {
+    _LIN_TRACE(_LIN_NO_DIMS, _LIN_NO_DIMS);
+    return _lin_job_create(_LIN_JOB_SUB, NULL, NULL, a, b, NULL, 0);
+}
 
-    for (size_t row = 0; row < a->shape.rows; row++) {
-        for (size_t col = 0; col < a->shape.columns; col++) {
-            res->elements[(row * res->shape.columns) + col] = 
-                lin_mat_cofactor_of_element(a, row, col);
-        }
-    }
+lin_job_t *lin_job_mat_transpose(lin_job_operand_t a) {
+    _LIN_TRACE(_LIN_NO_DIMS, _LIN_NO_DIMS);
+    return _lin_job_create(_LIN_JOB_TRANSPOSE, NULL, NULL, a, LIN_JOB_MAT(NULL),
+                           NULL, 0);
+}
 
-    return res;
+/// Inverse by LU factorization, NULL if `a` is singular
+lin_job_t *lin_job_mat_inv(lin_job_operand_t a) {
+    _LIN_TRACE(_LIN_NO_DIMS, _LIN_NO_DIMS);
+    return _lin_job_create(_LIN_JOB_INV, NULL, NULL, a, LIN_JOB_MAT(NULL),
+                           NULL, 0);
 }
 
-lin_mat_t *lin_mat_adj(lin_mat_t const *a) {
-    if (a->shape.rows != a->shape.columns) {
-        LIN_LOG_ERROR(
-            "Cannot find adjoint matrix of non-square matrix [%zu x %zu]",
-            a->shape.rows, a->shape.columns
-        );
-        exit(EXIT_FAILURE);
-    }
+/// Solution x of a * x = b by LU factorization, NULL if `a` is singular
+lin_job_t *lin_job_mat_solve(lin_job_operand_t a, lin_job_operand_t b) {
+    _LIN_TRACE(_LIN_NO_DIMS, _LIN_NO_DIMS);
+    return _lin_job_create(_LIN_JOB_SOLVE, NULL, NULL, a, b, NULL, 0);
+}
 
-    lin_mat_t *min = lin_mat_cofactor(a);
-    return lin_mat_transpose(min);
+/// Whether `job` has finished
+bool lin_job_poll(lin_job_t *job) {
+    _LIN_TRACE(_LIN_NO_DIMS, _LIN_NO_DIMS);
+    _LIN_JOB_LOCK();
+    bool const done = job->done;
+    _LIN_JOB_UNLOCK();
+    return done;
 }
 
-lin_mat_t *lin_mat_inv(lin_mat_t const *a) {
-    if (a->shape.rows != a->shape.columns) {
-        LIN_LOG_ERROR("Cannot find inverse of non-square matrix [%zu x %zu]",
-                      a->shape.rows, a->shape.columns);
-        exit(EXIT_FAILURE);
+/// Blocks until `job` has finished and returns its result
+void *lin_job_wait(lin_job_t *job) {
+    _LIN_TRACE(_LIN_NO_DIMS, _LIN_NO_DIMS);
+    _LIN_JOB_LOCK();
+#ifndef LIN_NO_THREADS
+    while (!job->done) {
+        pthread_cond_wait(&_lin_job_pool.finished, &_lin_job_pool.lock);
     }
+#endif
+    void *const result = job->result;
+    job->claimed = true;
+    _LIN_JOB_UNLOCK();
+    return result;
+}
 
-    lin_mat_t const *adj = lin_mat_adj(a);
-    lin_decimal_t det = lin_mat_det(a);
-
-    if (det == (lin_decimal_t)0) {
-        LIN_LOG_ERROR("Cannot find inverse of matrix with determinant of zero");
-        exit(EXIT_FAILURE);
+/// Releases the handle to `job`. A job that has not finished yet still runs,
+/// but its result can then no longer be retrieved and, for the matrix
+/// operations, is freed once no other job needs it.
+void lin_job_free(lin_job_t *job) {
+    _LIN_TRACE(_LIN_NO_DIMS, _LIN_NO_DIMS);
+    if (job == NULL) {
+        return;
     }
 
-    return lin_mat_scalar_mult(adj, (1.0 / det));
+    _LIN_JOB_LOCK();
+    _lin_job_release(job);
+    _LIN_JOB_UNLOCK();
 }
 
-lin_mat_t *lin_mat_map(lin_mat_t *mat, lin_decimal_t (*fn)(lin_decimal_t)) {
-    lin_mat_t *res = lin_mat_create(mat->shape);
-    for (size_t i = 0; i < mat->shape.rows; i++) {
-        for (size_t j = 0; j < mat->shape.columns; j++) {
-            size_t idx = i * mat->shape.columns + j;
-            res->elements[idx] = fn(mat->elements[idx]);
-        }
+/// Waits for all submitted jobs to finish and stops the worker threads. They
+/// are started again by the next submission.
+void lin_job_shutdown(void) {
+    _LIN_TRACE(_LIN_NO_DIMS, _LIN_NO_DIMS);
+#ifndef LIN_NO_THREADS
+    _LIN_JOB_LOCK();
+    if (!_lin_job_pool.started) {
+        _LIN_JOB_UNLOCK();
+        return;
     }
+    _lin_job_pool.stopping = true;
+    pthread_cond_broadcast(&_lin_job_pool.ready);
+    _LIN_JOB_UNLOCK();
 
-    return res;
-}
-
-void _lin_mat_print(lin_mat_t const *a) {
-    for (size_t row = 0; row < a->shape.rows; row++) {
-        printf("[ ");
-        for (size_t col = 0; col < a->shape.columns; col++) {
-            printf("%f ", a->elements[(row * a->shape.columns) + col]);
-        }
-        printf("]\n");
+    for (size_t i = 0; i < _lin_job_pool.workers; i++) {
+        pthread_join(_lin_job_pool.threads[i], NULL);
     }
+
+    _LIN_JOB_LOCK();
+    _lin_job_pool.started = false;
+    _LIN_JOB_UNLOCK();
+#endif
 }
 
 #endif // LIN_H
@@ -14,6 +14,7 @@ void create(void) {
     lin_mat_t *mat = lin_mat_create((lin_mat_shape_t){3, 3});
     TEST_ASSERT_NOT_NULL(mat);
     TEST_ASSERT_NOT_NULL(mat->elements);
+    lin_mat_free(mat);
 }
 
 void create_from_array(void) {
@@ -140,6 +141,32 @@ void scalar_mult(void) {
     TEST_ASSERT_EQUAL_FLOAT_ARRAY(exp2, res2->elements, 8);
 }
 
+void elementwise_large(void) {
+    // split across pinned threads with first touch allocation
+    lin_set_num_threads(4);
+    lin_set_numa_first_touch(true);
+
+    size_t const m = 600, n = 500;
+    lin_mat_t *a = lin_mat_create((lin_mat_shape_t){m, n});
+    lin_mat_t *b = lin_mat_create((lin_mat_shape_t){m, n});
+    for (size_t i = 0; i < m * n; i++) {
+        a->elements[i] = (float)(i % 101);
+        b->elements[i] = (float)(i % 7);
+    }
+
+    lin_mat_t *sum = lin_mat_add(a, b);
+    lin_mat_t *diff = lin_mat_sub(a, b);
+    lin_mat_t *scaled = lin_mat_scalar_mult(a, 3);
+    for (size_t i = 0; i < m * n; i++) {
+        TEST_ASSERT_EQUAL_FLOAT(a->elements[i] + b->elements[i], sum->elements[i]);
+        TEST_ASSERT_EQUAL_FLOAT(a->elements[i] - b->elements[i], diff->elements[i]);
+        TEST_ASSERT_EQUAL_FLOAT(a->elements[i] * 3, scaled->elements[i]);
+    }
+
+    lin_set_numa_first_touch(false);
+    lin_set_num_threads(0);
+}
+
 void transpose(void) {
     float els[2 * 4] = {
         1, 2, 3, 4,
@@ -463,14 +490,1641 @@ void map(void) {
     TEST_ASSERT_EQUAL_FLOAT_ARRAY(exp, res->elements, 4);
 }
 
+void mat_pow(void) {
+    float fib_els[2 * 2] = {
+        1, 1,
+        1, 0,
+    };
+    lin_mat_t *fib = lin_mat_create_from_array((lin_mat_shape_t){2, 2}, fib_els);
+    lin_mat_t *res = lin_mat_pow(fib, 10);
+    float exp[2 * 2] = {
+        89, 55,
+        55, 34,
+    };
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(exp, res->elements, 4);
+
+    lin_mat_t *work = lin_mat_create((lin_mat_shape_t){2, 2});
+    lin_mat_pow_into(fib, 0, res, work);
+    float identity[2 * 2] = {
+        1, 0,
+        0, 1,
+    };
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(identity, res->elements, 4);
+    lin_mat_pow_into(fib, 1, res, work);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(fib_els, res->elements, 4);
+
+    // generic path against repeated multiplication, column-major input too
+    size_t const n = 12;
+    lin_mat_t *a = lin_mat_create((lin_mat_shape_t){n, n});
+    for (size_t i = 0; i < n * n; i++) {
+        a->elements[i] = (float)((i * 7) % 5) * 0.1f - 0.2f;
+    }
+    lin_mat_t *exp_pow = lin_mat_create_from_array(a->shape, a->elements);
+    for (size_t i = 1; i < 13; i++) {
+        lin_mat_t *next = lin_mat_mult(exp_pow, a);
+        lin_mat_free(exp_pow);
+        exp_pow = next;
+    }
+    lin_mat_t *pow13 = lin_mat_pow(a, 13);
+    lin_mat_transpose_in_place(a);
+    lin_mat_t *t13 = lin_mat_pow(a, 13);
+    lin_mat_transpose_in_place(t13);
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < n; j++) {
+            float const el = exp_pow->elements[(i * n) + j];
+            TEST_ASSERT_FLOAT_WITHIN(1e-3, el, lin_mat_get(pow13, i, j));
+            TEST_ASSERT_FLOAT_WITHIN(1e-3, el, lin_mat_get(t13, i, j));
+        }
+    }
+
+    // a Markov chain converges to its stationary distribution
+    float p_els[2 * 2] = {
+        0.9f, 0.1f,
+        0.5f, 0.5f,
+    };
+    lin_mat_t *p = lin_mat_create_from_array((lin_mat_shape_t){2, 2}, p_els);
+    lin_mat_pow_into(p, 1000, res, work);
+    for (size_t i = 0; i < 2; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-3, 5.0f / 6.0f, res->elements[(i * 2)]);
+        TEST_ASSERT_FLOAT_WITHIN(1e-3, 1.0f / 6.0f, res->elements[(i * 2) + 1]);
+    }
+
+    lin_mat_free(fib);
+    lin_mat_free(res);
+    lin_mat_free(work);
+    lin_mat_free(a);
+    lin_mat_free(exp_pow);
+    lin_mat_free(pow13);
+    lin_mat_free(t13);
+    lin_mat_free(p);
+}
+
+void qr(void) {
+    float els[4 * 3] = {
+        12, -51, 4,
+        6, 167, -68,
+        -4, 24, -41,
+        -1, 1, 0,
+    };
+    lin_mat_t *mat = lin_mat_create_from_array((lin_mat_shape_t){4, 3}, els);
+
+    lin_mat_qr_t *qr = lin_mat_qr(mat);
+    lin_mat_t *r = lin_mat_qr_r(qr);
+
+    TEST_ASSERT_EQUAL(3, r->shape.rows);
+    TEST_ASSERT_EQUAL(3, r->shape.columns);
+    TEST_ASSERT_EQUAL_FLOAT(0, r->elements[3]);
+    TEST_ASSERT_EQUAL_FLOAT(0, r->elements[6]);
+    TEST_ASSERT_EQUAL_FLOAT(0, r->elements[7]);
+
+    // Q * (Q^T * A) == A without forming Q
+    lin_mat_t *qta = lin_mat_qr_qt_mult(qr, mat);
+    for (size_t i = 0; i < 3; i++) {
+        for (size_t j = 0; j < 3; j++) {
+            TEST_ASSERT_FLOAT_WITHIN(1e-3, r->elements[(i * 3) + j],
+                                     qta->elements[(i * 3) + j]);
+        }
+    }
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, 0, qta->elements[9]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, 0, qta->elements[10]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, 0, qta->elements[11]);
+
+    lin_mat_t *res = lin_mat_qr_q_mult(qr, qta);
+    for (size_t i = 0; i < 4 * 3; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-3, els[i], res->elements[i]);
+    }
+
+    lin_mat_qr_free(qr);
+}
+
+void qr_blocked(void) {
+    // wider than one LIN_QR_BLOCK so the compact WY update is exercised
+    size_t const m = 80, n = 45;
+    lin_mat_t *mat = lin_mat_create((lin_mat_shape_t){m, n});
+    for (size_t i = 0; i < m * n; i++) {
+        mat->elements[i] = (float)((i * 7919) % 23) - 11.0f;
+    }
+
+    lin_mat_qr_t *qr = lin_mat_qr(mat);
+    lin_mat_t *qta = lin_mat_qr_qt_mult(qr, mat);
+    lin_mat_t *r = lin_mat_qr_r(qr);
+
+    for (size_t i = 0; i < m; i++) {
+        for (size_t j = 0; j < n; j++) {
+            float exp = i < n ? r->elements[(i * n) + j] : 0;
+            TEST_ASSERT_FLOAT_WITHIN(1e-2, exp, qta->elements[(i * n) + j]);
+        }
+    }
+
+    lin_mat_t *res = lin_mat_qr_q_mult(qr, qta);
+    for (size_t i = 0; i < m * n; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-2, mat->elements[i], res->elements[i]);
+    }
+
+    lin_mat_qr_free(qr);
+}
+
+void lstsq(void) {
+    // y = 2x + 1 sampled at x = 0..4
+    float a_el[5 * 2] = {
+        1, 0,
+        1, 1,
+        1, 2,
+        1, 3,
+        1, 4,
+    };
+    lin_mat_t *a = lin_mat_create_from_array((lin_mat_shape_t){5, 2}, a_el);
+
+    float b_el[5] = {1, 3, 5, 7, 9};
+    lin_mat_t *b = lin_mat_create_from_array((lin_mat_shape_t){5, 1}, b_el);
+
+    lin_mat_t *res = lin_mat_lstsq(a, b);
+
+    TEST_ASSERT_EQUAL(2, res->shape.rows);
+    TEST_ASSERT_EQUAL(1, res->shape.columns);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, 1, res->elements[0]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, 2, res->elements[1]);
+
+    float rank_def_el[3 * 2] = {
+        1, 2,
+        2, 4,
+        3, 6,
+    };
+    lin_mat_t *rank_def = lin_mat_create_from_array(
+        (lin_mat_shape_t){3, 2}, rank_def_el
+    );
+    lin_mat_t *rank_def_b = lin_mat_create_from_array(
+        (lin_mat_shape_t){3, 1}, b_el
+    );
+    TEST_ASSERT_NULL(lin_mat_lstsq(rank_def, rank_def_b));
+}
+
+void cholesky(void) {
+    float els[3 * 3] = {
+        4, 12, -16,
+        12, 37, -43,
+        -16, -43, 98,
+    };
+    lin_mat_t *mat = lin_mat_create_from_array((lin_mat_shape_t){3, 3}, els);
+
+    TEST_ASSERT_TRUE(lin_mat_cholesky(mat));
+
+    float exp[3 * 3] = {
+        2, 0, 0,
+        6, 1, 0,
+        -8, 5, 3,
+    };
+
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(exp, mat->elements, 9);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, 2 * log(6.0), lin_mat_cholesky_logdet(mat));
+
+    float not_pd_els[2 * 2] = {
+        1, 2,
+        2, 1,
+    };
+    lin_mat_t *not_pd = lin_mat_create_from_array(
+        (lin_mat_shape_t){2, 2}, not_pd_els
+    );
+    TEST_ASSERT_FALSE(lin_mat_cholesky(not_pd));
+}
+
+void cholesky_blocked(void) {
+    // larger than one LIN_CHOLESKY_BLOCK, a = m * m^T + n * I is SPD
+    size_t const n = 70;
+    lin_mat_t *m = lin_mat_create((lin_mat_shape_t){n, n});
+    for (size_t i = 0; i < n * n; i++) {
+        m->elements[i] = (float)((i * 7919) % 17) / 17.0f - 0.5f;
+    }
+    lin_mat_t *a = lin_mat_add(
+        lin_mat_mult(m, lin_mat_transpose(m)),
+        lin_mat_scalar_mult(lin_mat_identity(n), (float)n)
+    );
+
+    lin_mat_t *l = lin_mat_create_from_array(a->shape, a->elements);
+    TEST_ASSERT_TRUE(lin_mat_cholesky(l));
+
+    lin_mat_t *res = lin_mat_mult(l, lin_mat_transpose(l));
+    for (size_t i = 0; i < n * n; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-3, a->elements[i], res->elements[i]);
+    }
+}
+
+void spd_solve(void) {
+    float els[3 * 3] = {
+        4, 12, -16,
+        12, 37, -43,
+        -16, -43, 98,
+    };
+    lin_mat_t *mat = lin_mat_create_from_array((lin_mat_shape_t){3, 3}, els);
+
+    float b_el[3 * 2] = {
+        -4, -8,
+        -9.5, -19,
+        33, 66,
+    };
+    lin_mat_t *b = lin_mat_create_from_array((lin_mat_shape_t){3, 2}, b_el);
+
+    lin_mat_t *res = lin_mat_spd_solve(mat, b);
+
+    float exp[3 * 2] = {
+        1, 2,
+        0, 0,
+        0.5, 1,
+    };
+
+    for (size_t i = 0; i < 3 * 2; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-3, exp[i], res->elements[i]);
+    }
+}
+
+void vec_mult(void) {
+    float a_el[2 * 3] = {
+        1, 2, 3,
+        4, 5, 6,
+    };
+    lin_mat_t *a = lin_mat_create_from_array((lin_mat_shape_t){2, 3}, a_el);
+
+    float x_el[3] = {1, 0, -1};
+    lin_vec_t *x = lin_vec_create_from_array(3, x_el);
+
+    lin_vec_t *res = lin_mat_vec_mult(a, x);
+
+    float exp[2] = {-2, -2};
+    TEST_ASSERT_EQUAL(2, res->dim);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(exp, res->elements, 2);
+
+    float y_el[2] = {1, 2};
+    lin_vec_t *y = lin_vec_create_from_array(2, y_el);
+
+    lin_vec_t *res_t = lin_mat_vec_mult_transposed(a, y);
+
+    float exp_t[3] = {9, 12, 15};
+    TEST_ASSERT_EQUAL(3, res_t->dim);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(exp_t, res_t->elements, 3);
+}
+
+void vec_mult_large(void) {
+    // big enough to be split across threads, covering both the column strip
+    // and the row partial sum strategies of the transposed product
+    lin_set_num_threads(4);
+    size_t const shapes[3][2] = {{3000, 50}, {100000, 3}, {400, 500}};
+    for (size_t s = 0; s < 3; s++) {
+        size_t const m = shapes[s][0], n = shapes[s][1];
+        lin_mat_t *a = lin_mat_create((lin_mat_shape_t){m, n});
+        for (size_t i = 0; i < m * n; i++) {
+            a->elements[i] = (float)((i * 31) % 7) - 3.0f;
+        }
+        lin_vec_t *x = lin_vec_create(n);
+        for (size_t i = 0; i < n; i++) {
+            x->elements[i] = (float)(i % 3);
+        }
+        lin_vec_t *y = lin_vec_create(m);
+        for (size_t i = 0; i < m; i++) {
+            y->elements[i] = (float)(i % 5) - 2.0f;
+        }
+
+        lin_vec_t *ax = lin_mat_vec_mult(a, x);
+        lin_mat_t *exp = lin_mat_mult(
+            a, lin_mat_create_from_array((lin_mat_shape_t){n, 1}, x->elements)
+        );
+        TEST_ASSERT_EQUAL_FLOAT_ARRAY(exp->elements, ax->elements, m);
+
+        lin_vec_t *aty = lin_mat_vec_mult_transposed(a, y);
+        lin_mat_t *exp_t = lin_mat_mult(
+            lin_mat_transpose(a),
+            lin_mat_create_from_array((lin_mat_shape_t){m, 1}, y->elements)
+        );
+        TEST_ASSERT_EQUAL_FLOAT_ARRAY(exp_t->elements, aty->elements, n);
+    }
+    lin_set_num_threads(0);
+}
+
+void lu(void) {
+    float els[3 * 3] = {
+        2, 1, 1,
+        4, -6, 0,
+        -2, 7, 2,
+    };
+    lin_mat_t *mat = lin_mat_create_from_array((lin_mat_shape_t){3, 3}, els);
+
+    lin_mat_lu_t *lu = lin_mat_lu(mat);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, lin_mat_det(mat), lin_mat_lu_det(lu));
+
+    float b_el[3] = {5, -2, 9};
+    lin_mat_t *b = lin_mat_create_from_array((lin_mat_shape_t){3, 1}, b_el);
+    lin_mat_t *res = lin_mat_lu_solve(lu, b);
+
+    float exp[3] = {1, 1, 2};
+    for (size_t i = 0; i < 3; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-4, exp[i], res->elements[i]);
+    }
+    lin_mat_lu_free(lu);
+
+    float singular_els[2 * 2] = {
+        1, 2,
+        2, 4,
+    };
+    lin_mat_t *singular = lin_mat_create_from_array(
+        (lin_mat_shape_t){2, 2}, singular_els
+    );
+    TEST_ASSERT_NULL(lin_mat_lu(singular));
+}
+
+void inv_rank1_update(void) {
+    float els[3 * 3] = {
+        4, 1, 0,
+        1, 3, 1,
+        0, 1, 2,
+    };
+    lin_mat_t *mat = lin_mat_create_from_array((lin_mat_shape_t){3, 3}, els);
+    lin_mat_t *mat_inv = lin_mat_inv(mat);
+
+    float u_el[3] = {1, 0, 2};
+    float v_el[3] = {0, 1, 1};
+    lin_vec_t *u = lin_vec_create_from_array(3, u_el);
+    lin_vec_t *v = lin_vec_create_from_array(3, v_el);
+    TEST_ASSERT_TRUE(lin_mat_inv_rank1_update(mat_inv, u, v));
+
+    float updated_els[3 * 3] = {
+        4, 2, 1,
+        1, 3, 1,
+        0, 3, 4,
+    };
+    lin_mat_t *exp = lin_mat_inv(
+        lin_mat_create_from_array((lin_mat_shape_t){3, 3}, updated_els)
+    );
+    for (size_t i = 0; i < 9; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-4, exp->elements[i], mat_inv->elements[i]);
+    }
+
+    // rank-2 update through Woodbury, u and v as columns
+    lin_mat_t *wood_inv = lin_mat_inv(mat);
+    float wu_el[3 * 2] = {
+        1, 0,
+        0, 1,
+        2, 0,
+    };
+    float wv_el[3 * 2] = {
+        0, 1,
+        1, 0,
+        1, 0,
+    };
+    lin_mat_t *wu = lin_mat_create_from_array((lin_mat_shape_t){3, 2}, wu_el);
+    lin_mat_t *wv = lin_mat_create_from_array((lin_mat_shape_t){3, 2}, wv_el);
+    TEST_ASSERT_TRUE(lin_mat_inv_woodbury_update(wood_inv, wu, wv));
+
+    lin_mat_t *wood_exp = lin_mat_inv(lin_mat_add(mat, lin_mat_mult(wu, lin_mat_transpose(wv))));
+    for (size_t i = 0; i < 9; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-4, wood_exp->elements[i], wood_inv->elements[i]);
+    }
+}
+
+void cholesky_update(void) {
+    float els[3 * 3] = {
+        4, 12, -16,
+        12, 37, -43,
+        -16, -43, 98,
+    };
+    float x_el[3] = {1, 2, -1};
+    lin_vec_t *x = lin_vec_create_from_array(3, x_el);
+
+    lin_mat_t *l = lin_mat_create_from_array((lin_mat_shape_t){3, 3}, els);
+    TEST_ASSERT_TRUE(lin_mat_cholesky(l));
+    TEST_ASSERT_TRUE(lin_mat_cholesky_update(l, x));
+
+    lin_mat_t *exp = lin_mat_create_from_array((lin_mat_shape_t){3, 3}, els);
+    for (size_t i = 0; i < 3; i++) {
+        for (size_t j = 0; j < 3; j++) {
+            exp->elements[(i * 3) + j] += x_el[i] * x_el[j];
+        }
+    }
+    TEST_ASSERT_TRUE(lin_mat_cholesky(exp));
+    for (size_t i = 0; i < 9; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-4, exp->elements[i], l->elements[i]);
+    }
+
+    // downdating by the same vector restores the original factor
+    TEST_ASSERT_TRUE(lin_mat_cholesky_downdate(l, x));
+    float orig[3 * 3] = {
+        2, 0, 0,
+        6, 1, 0,
+        -8, 5, 3,
+    };
+    for (size_t i = 0; i < 9; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-3, orig[i], l->elements[i]);
+    }
+
+    float big_el[3] = {10, 0, 0};
+    lin_vec_t *big = lin_vec_create_from_array(3, big_el);
+    TEST_ASSERT_FALSE(lin_mat_cholesky_downdate(l, big));
+}
+
+void lu_update(void) {
+    float els[3 * 3] = {
+        2, 1, 1,
+        4, -6, 0,
+        -2, 7, 2,
+    };
+    lin_mat_t *mat = lin_mat_create_from_array((lin_mat_shape_t){3, 3}, els);
+    lin_mat_lu_t *lu = lin_mat_lu(mat);
+
+    float u_el[3] = {1, -1, 2};
+    float v_el[3] = {0.5, 1, -1};
+    lin_vec_t *u = lin_vec_create_from_array(3, u_el);
+    lin_vec_t *v = lin_vec_create_from_array(3, v_el);
+    TEST_ASSERT_TRUE(lin_mat_lu_update(lu, u, v));
+
+    lin_mat_t *updated = lin_mat_create_from_array((lin_mat_shape_t){3, 3}, els);
+    for (size_t i = 0; i < 3; i++) {
+        for (size_t j = 0; j < 3; j++) {
+            updated->elements[(i * 3) + j] += u_el[i] * v_el[j];
+        }
+    }
+
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, lin_mat_det(updated), lin_mat_lu_det(lu));
+
+    float b_el[3] = {1, 2, 3};
+    lin_mat_t *b = lin_mat_create_from_array((lin_mat_shape_t){3, 1}, b_el);
+    lin_mat_t *res = lin_mat_mult(updated, lin_mat_lu_solve(lu, b));
+    for (size_t i = 0; i < 3; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-4, b_el[i], res->elements[i]);
+    }
+    lin_mat_lu_free(lu);
+}
+
+void triangular(void) {
+    // larger than one LIN_TRI_BLOCK, with a dominant diagonal
+    size_t const n = 70;
+    size_t const p = 3;
+    lin_mat_t *a = lin_mat_create((lin_mat_shape_t){n, n});
+    for (size_t i = 0; i < n * n; i++) {
+        a->elements[i] = (float)((i * 7919) % 17) / 17.0f - 0.5f;
+    }
+    for (size_t i = 0; i < n; i++) {
+        a->elements[(i * n) + i] = 2.0f + (float)(i % 3);
+    }
+    lin_mat_t *b = lin_mat_create((lin_mat_shape_t){n, p});
+    for (size_t i = 0; i < n * p; i++) {
+        b->elements[i] = (float)((i * 31) % 11) - 5.0f;
+    }
+
+    for (unsigned flags = 0; flags < 8; flags++) {
+        bool const upper = (flags & LIN_TRI_UPPER) != 0;
+        lin_mat_t *t = lin_mat_create_from_array(a->shape, a->elements);
+        for (size_t i = 0; i < n; i++) {
+            for (size_t j = 0; j < n; j++) {
+                if (upper ? j < i : j > i) {
+                    t->elements[(i * n) + j] = 0;
+                } else if (i == j && (flags & LIN_TRI_UNIT)) {
+                    t->elements[(i * n) + j] = 1;
+                }
+            }
+        }
+        lin_mat_t *op_t = (flags & LIN_TRI_TRANS) ? lin_mat_transpose(t) : t;
+
+        lin_mat_t *x = lin_mat_trsm(a, b, flags);
+        lin_mat_t *res = lin_mat_mult(op_t, x);
+        for (size_t i = 0; i < n * p; i++) {
+            TEST_ASSERT_FLOAT_WITHIN(1e-3, b->elements[i], res->elements[i]);
+        }
+
+        lin_mat_t *prod = lin_mat_trmm(a, b, flags);
+        lin_mat_t *exp = lin_mat_mult(op_t, b);
+        for (size_t i = 0; i < n * p; i++) {
+            TEST_ASSERT_FLOAT_WITHIN(1e-3, exp->elements[i], prod->elements[i]);
+        }
+
+        // packed storage gives the same results from half the memory
+        lin_tri_t *packed = lin_tri_pack(a, upper);
+        lin_mat_t *unpacked = lin_tri_unpack(packed);
+        for (size_t i = 0; i < n; i++) {
+            for (size_t j = 0; j < n; j++) {
+                float const el = (upper ? j < i : j > i)
+                    ? 0 : a->elements[(i * n) + j];
+                TEST_ASSERT_EQUAL_FLOAT(el, unpacked->elements[(i * n) + j]);
+                TEST_ASSERT_EQUAL_FLOAT(el, lin_tri_get(packed, i, j));
+            }
+        }
+
+        lin_mat_t *packed_x = lin_tri_solve(packed, b, flags);
+        lin_mat_t *packed_prod = lin_tri_mult(packed, b, flags);
+        for (size_t i = 0; i < n * p; i++) {
+            TEST_ASSERT_FLOAT_WITHIN(1e-4, x->elements[i], packed_x->elements[i]);
+            TEST_ASSERT_FLOAT_WITHIN(1e-3, prod->elements[i],
+                                     packed_prod->elements[i]);
+        }
+
+        lin_tri_free(packed);
+        lin_mat_free(unpacked);
+        lin_mat_free(packed_x);
+        lin_mat_free(packed_prod);
+        lin_mat_free(x);
+        lin_mat_free(res);
+        lin_mat_free(prod);
+        lin_mat_free(exp);
+        if (op_t != t) {
+            lin_mat_free(op_t);
+        }
+        lin_mat_free(t);
+    }
+    lin_mat_free(a);
+    lin_mat_free(b);
+}
+
+void symmetric(void) {
+    // more rows than one LIN_TRI_BLOCK
+    size_t const m = 70;
+    size_t const k = 5;
+    lin_mat_t *a = lin_mat_create((lin_mat_shape_t){m, k});
+    for (size_t i = 0; i < m * k; i++) {
+        a->elements[i] = (float)((i * 7919) % 17) / 17.0f - 0.5f;
+    }
+    lin_mat_t *a_t = lin_mat_transpose(a);
+
+    for (unsigned trans = 0; trans <= LIN_TRI_TRANS; trans += LIN_TRI_TRANS) {
+        lin_mat_t *exp = trans ? lin_mat_mult(a_t, a) : lin_mat_mult(a, a_t);
+        size_t const n = exp->shape.rows;
+
+        lin_mat_t *res = lin_mat_syrk(a, trans);
+        TEST_ASSERT_EQUAL_size_t(n, res->shape.rows);
+        TEST_ASSERT_EQUAL_size_t(n, res->shape.columns);
+        for (size_t i = 0; i < n * n; i++) {
+            TEST_ASSERT_FLOAT_WITHIN(1e-4, exp->elements[i], res->elements[i]);
+        }
+
+        lin_vec_t *x = lin_vec_create(n);
+        for (size_t i = 0; i < n; i++) {
+            x->elements[i] = (float)(i % 7) - 3.0f;
+        }
+        lin_vec_t *exp_y = lin_mat_vec_mult(exp, x);
+
+        for (unsigned upper = 0; upper <= LIN_TRI_UPPER; upper++) {
+            lin_tri_t *packed = lin_tri_syrk(a, trans | upper);
+            lin_mat_t *unpacked = lin_tri_sym_unpack(packed);
+            for (size_t i = 0; i < n * n; i++) {
+                TEST_ASSERT_FLOAT_WITHIN(1e-4, exp->elements[i],
+                                         unpacked->elements[i]);
+            }
+
+            // only the selected triangle of the full matrix is read
+            lin_mat_t *half = lin_tri_unpack(packed);
+            lin_vec_t *y = lin_mat_sym_vec_mult(half, x, upper);
+            lin_vec_t *packed_y = lin_tri_sym_vec_mult(packed, x);
+            for (size_t i = 0; i < n; i++) {
+                TEST_ASSERT_FLOAT_WITHIN(1e-3, exp_y->elements[i], y->elements[i]);
+                TEST_ASSERT_FLOAT_WITHIN(1e-3, exp_y->elements[i],
+                                         packed_y->elements[i]);
+            }
+
+            lin_tri_free(packed);
+            lin_mat_free(unpacked);
+            lin_mat_free(half);
+            lin_vec_free(y);
+            lin_vec_free(packed_y);
+        }
+
+        lin_mat_free(exp);
+        lin_mat_free(res);
+        lin_vec_free(x);
+        lin_vec_free(exp_y);
+    }
+    lin_mat_free(a);
+    lin_mat_free(a_t);
+}
+
+void banded(void) {
+    size_t const n = 40;
+    size_t const p = 2;
+    lin_mat_t *b = lin_mat_create((lin_mat_shape_t){n, p});
+    for (size_t i = 0; i < n * p; i++) {
+        b->elements[i] = (float)((i * 31) % 11) - 5.0f;
+    }
+    lin_vec_t *x = lin_vec_create(n);
+    for (size_t i = 0; i < n; i++) {
+        x->elements[i] = (float)(i % 7) - 3.0f;
+    }
+
+    // dominant tridiagonal (Thomas), tridiagonal with a zero diagonal that
+    // needs pivoting, and a wider band
+    size_t const bands[3][2] = {{1, 1}, {1, 1}, {2, 3}};
+    for (size_t t = 0; t < 3; t++) {
+        size_t const lower = bands[t][0];
+        size_t const upper = bands[t][1];
+        lin_band_t *a = lin_band_create(n, lower, upper);
+        for (size_t i = 0; i < n; i++) {
+            size_t const j0 = i > lower ? i - lower : 0;
+            for (size_t j = j0; j < n && j <= i + upper; j++) {
+                float el = (float)(((i * 7) + (j * 13)) % 9) / 9.0f - 0.5f;
+                if (i == j) {
+                    el = t == 0 ? 2.0f : (t == 1 && i % 2 == 0 ? 0.0f : el);
+                }
+                lin_band_set(a, i, j, el);
+            }
+        }
+
+        lin_mat_t *dense = lin_band_to_mat(a);
+        for (size_t i = 0; i < n; i++) {
+            for (size_t j = 0; j < n; j++) {
+                bool const in_band = j + lower >= i && j <= i + upper;
+                TEST_ASSERT_EQUAL_FLOAT(in_band ? lin_band_get(a, i, j) : 0,
+                                        dense->elements[(i * n) + j]);
+            }
+        }
+
+        lin_band_t *round_trip = lin_band_from_mat(dense, lower, upper);
+        TEST_ASSERT_EQUAL_MEMORY(a->elements, round_trip->elements,
+                                 n * (lower + upper + 1) * sizeof(float));
+
+        lin_vec_t *y = lin_band_vec_mult(a, x);
+        lin_vec_t *exp_y = lin_mat_vec_mult(dense, x);
+        for (size_t i = 0; i < n; i++) {
+            TEST_ASSERT_FLOAT_WITHIN(1e-4, exp_y->elements[i], y->elements[i]);
+        }
+
+        lin_mat_t *sol = lin_band_solve(a, b);
+        TEST_ASSERT_NOT_NULL(sol);
+        lin_mat_t *res = lin_mat_mult(dense, sol);
+        for (size_t i = 0; i < n * p; i++) {
+            TEST_ASSERT_FLOAT_WITHIN(1e-3, b->elements[i], res->elements[i]);
+        }
+
+        lin_band_free(a);
+        lin_band_free(round_trip);
+        lin_mat_free(dense);
+        lin_vec_free(y);
+        lin_vec_free(exp_y);
+        lin_mat_free(sol);
+        lin_mat_free(res);
+    }
+
+    lin_band_t *singular = lin_band_create(n, 1, 1);
+    TEST_ASSERT_NULL(lin_band_solve(singular, b));
+    lin_band_free(singular);
+
+    lin_mat_free(b);
+    lin_vec_free(x);
+}
+
+void iterative(void) {
+    size_t const n = 50;
+    lin_mat_t *a = lin_mat_create((lin_mat_shape_t){n, n});
+    lin_band_t *band = lin_band_create(n, 1, 1);
+    lin_vec_t *diag = lin_vec_create(n);
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < n; j++) {
+            float el = 0;
+            if (i == j) {
+                el = 2.0f + (float)(i % 5);
+            } else if (i == j + 1 || j == i + 1) {
+                el = -1.0f;
+            }
+            a->elements[(i * n) + j] = el;
+            if (el != 0) {
+                lin_band_set(band, i, j, el);
+            }
+        }
+        diag->elements[i] = a->elements[(i * n) + i];
+    }
+
+    lin_vec_t *b = lin_vec_create(n);
+    for (size_t i = 0; i < n; i++) {
+        b->elements[i] = (float)(i % 7) - 3.0f;
+    }
+    lin_mat_t *b_mat = lin_mat_create_from_array((lin_mat_shape_t){n, 1},
+                                                 b->elements);
+    lin_mat_t *exp = lin_band_solve(band, b_mat);
+
+    lin_iter_opts_t opts = {0, 1e-5f, 0, NULL};
+    lin_iter_info_t info;
+    lin_vec_t *x = lin_vec_create(n);
+    for (int jacobi = 0; jacobi < 2; jacobi++) {
+        opts.diag = jacobi ? diag : NULL;
+
+        memset(x->elements, 0, n * sizeof(float));
+        TEST_ASSERT_TRUE(lin_cg(lin_op_mat, a, b, x, &opts, &info));
+        TEST_ASSERT_TRUE(info.converged);
+        TEST_ASSERT_TRUE(info.iterations > 0 && info.iterations <= n);
+        TEST_ASSERT_TRUE(info.residual <= 1e-5f);
+        for (size_t i = 0; i < n; i++) {
+            TEST_ASSERT_FLOAT_WITHIN(1e-3, exp->elements[i], x->elements[i]);
+        }
+
+        memset(x->elements, 0, n * sizeof(float));
+        TEST_ASSERT_TRUE(lin_cg(lin_op_band, band, b, x, &opts, NULL));
+        for (size_t i = 0; i < n; i++) {
+            TEST_ASSERT_FLOAT_WITHIN(1e-3, exp->elements[i], x->elements[i]);
+        }
+    }
+
+    // GMRES on a nonsymmetric matrix, with restarts
+    for (size_t i = 0; i + 2 < n; i++) {
+        a->elements[(i * n) + i + 2] = 0.5f;
+    }
+    lin_mat_lu_t *lu = lin_mat_lu(a);
+    lin_mat_t *exp_gmres = lin_mat_lu_solve(lu, b_mat);
+    opts.restart = 8;
+    for (int jacobi = 0; jacobi < 2; jacobi++) {
+        opts.diag = jacobi ? diag : NULL;
+        memset(x->elements, 0, n * sizeof(float));
+        TEST_ASSERT_TRUE(lin_gmres(lin_op_mat, a, b, x, &opts, &info));
+        TEST_ASSERT_TRUE(info.residual <= 1e-5f);
+        for (size_t i = 0; i < n; i++) {
+            TEST_ASSERT_FLOAT_WITHIN(1e-3, exp_gmres->elements[i], x->elements[i]);
+        }
+    }
+
+    // running out of iterations
+    opts = (lin_iter_opts_t){2, 1e-5f, 0, NULL};
+    memset(x->elements, 0, n * sizeof(float));
+    TEST_ASSERT_FALSE(lin_gmres(lin_op_mat, a, b, x, &opts, &info));
+    TEST_ASSERT_EQUAL_size_t(2, info.iterations);
+    TEST_ASSERT_FALSE(info.converged);
+
+    lin_mat_lu_free(lu);
+    lin_mat_free(a);
+    lin_mat_free(b_mat);
+    lin_mat_free(exp);
+    lin_mat_free(exp_gmres);
+    lin_band_free(band);
+    lin_vec_free(diag);
+    lin_vec_free(b);
+    lin_vec_free(x);
+}
+
+void eigen(void) {
+    // symmetric, with the largest magnitude eigenvalue near -100
+    size_t const n = 40;
+    size_t const k = 3;
+    lin_mat_t *a = lin_mat_create((lin_mat_shape_t){n, n});
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j <= i; j++) {
+            float const el = i == j
+                ? (i == 5 ? -100.0f : (float)(i + 1))
+                : 0.01f * (float)((i * j) % 5);
+            a->elements[(i * n) + j] = el;
+            a->elements[(j * n) + i] = el;
+        }
+    }
+
+    // subspace iteration converges like (|lambda_7| / |lambda_3|)^iterations
+    lin_iter_opts_t const opts = {4000, 1e-5f, 0, NULL};
+    lin_eig_t *eigs[2] = {
+        lin_eig_subspace(lin_op_mat, a, n, k, &opts),
+        lin_eig_lanczos(lin_op_mat, a, n, k, &opts),
+    };
+    float const exp[3] = {-100, 40, 39};
+    for (size_t e = 0; e < 2; e++) {
+        lin_eig_t *eig = eigs[e];
+        TEST_ASSERT_TRUE(eig->converged);
+        TEST_ASSERT_TRUE(eig->iterations > 0);
+
+        for (size_t c = 0; c < k; c++) {
+            float const lambda = eig->values->elements[c];
+            TEST_ASSERT_FLOAT_WITHIN(0.05, exp[c], lambda);
+
+            lin_vec_t *v = lin_mat_col_vec(eig->vectors, c);
+            lin_vec_t *av = lin_mat_vec_mult(a, v);
+            TEST_ASSERT_FLOAT_WITHIN(1e-4, 1, lin_vec_dot(v, v));
+            for (size_t i = 0; i < n; i++) {
+                TEST_ASSERT_FLOAT_WITHIN(1e-2, lambda * v->elements[i],
+                                         av->elements[i]);
+            }
+            lin_vec_free(v);
+            lin_vec_free(av);
+        }
+
+        TEST_ASSERT_FLOAT_WITHIN(1e-3, eigs[0]->values->elements[0],
+                                 eig->values->elements[0]);
+    }
+
+    // any operator works, here a diagonal matrix in banded storage
+    lin_band_t *band = lin_band_create(n, 0, 0);
+    for (size_t i = 0; i < n; i++) {
+        lin_band_set(band, i, i, (float)i);
+    }
+    lin_eig_t *diag = lin_eig_lanczos(lin_op_band, band, n, 2, NULL);
+    TEST_ASSERT_TRUE(diag->converged);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, n - 1, diag->values->elements[0]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, n - 2, diag->values->elements[1]);
+
+    lin_eig_free(eigs[0]);
+    lin_eig_free(eigs[1]);
+    lin_eig_free(diag);
+    lin_band_free(band);
+    lin_mat_free(a);
+}
+
+static void assert_within(float delta, float const *exp, float const *act,
+                          size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(delta, exp[i], act[i]);
+    }
+}
+
+void layout(void) {
+    // a is [3 x 4]; at is its transpose flipped in O(1) to column-major
+    float els[3 * 4] = {
+        4, 1, 0, 2,
+        1, 5, 1, 0,
+        0, 1, 6, 3,
+    };
+    lin_mat_t *a = lin_mat_create_from_array((lin_mat_shape_t){3, 4}, els);
+    lin_mat_t *at = lin_mat_create_from_array((lin_mat_shape_t){3, 4}, els);
+    lin_mat_transpose_in_place(at);
+    TEST_ASSERT_EQUAL_size_t(4, at->shape.rows);
+    TEST_ASSERT_EQUAL_size_t(3, at->shape.columns);
+    TEST_ASSERT_EQUAL(LIN_COL_MAJOR, at->layout);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(els, at->elements, 12);
+    for (size_t i = 0; i < 3; i++) {
+        for (size_t j = 0; j < 4; j++) {
+            TEST_ASSERT_EQUAL_FLOAT(lin_mat_get(a, i, j), lin_mat_get(at, j, i));
+        }
+    }
+
+    lin_mat_t *t = lin_mat_transpose(a);
+    lin_mat_t *exp_t = lin_mat_transpose(at);
+    TEST_ASSERT_EQUAL(LIN_ROW_MAJOR, exp_t->layout);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(els, exp_t->elements, 12);
+
+    // products for each combination of layouts
+    lin_mat_t *exp_ata = lin_mat_mult(t, a);
+    lin_mat_t *ata = lin_mat_mult(at, a);
+    assert_within(1e-4, exp_ata->elements, ata->elements, 16);
+    lin_mat_t *exp_aat = lin_mat_mult(a, t);
+    lin_mat_t *aat = lin_mat_mult(a, at);
+    assert_within(1e-4, exp_aat->elements, aat->elements, 9);
+    lin_mat_transpose_in_place(t);
+    lin_mat_t *ata_t = lin_mat_mult(at, t);
+    assert_within(1e-4, exp_ata->elements, ata_t->elements, 16);
+    lin_mat_transpose_in_place(t);
+    lin_mat_t *syrk = lin_mat_syrk(at, LIN_TRI_TRANS);
+    assert_within(1e-4, exp_aat->elements, syrk->elements, 9);
+
+    float x_els[3] = {1, -2, 3};
+    lin_vec_t *x = lin_vec_create_from_array(3, x_els);
+    lin_vec_t *exp_y = lin_mat_vec_mult_transposed(a, x);
+    lin_vec_t *y = lin_mat_vec_mult(at, x);
+    assert_within(1e-5, exp_y->elements, y->elements, 4);
+
+    // elementwise operations keep the layout
+    lin_mat_t *sum = lin_mat_add(at, at);
+    TEST_ASSERT_EQUAL(LIN_COL_MAJOR, sum->layout);
+    for (size_t i = 0; i < 4; i++) {
+        for (size_t j = 0; j < 3; j++) {
+            TEST_ASSERT_EQUAL_FLOAT(2 * lin_mat_get(a, j, i), lin_mat_get(sum, i, j));
+        }
+    }
+    lin_mat_t *diff = lin_mat_sub(at, t);
+    TEST_ASSERT_EQUAL(LIN_ROW_MAJOR, diff->layout);
+    for (size_t i = 0; i < 12; i++) {
+        TEST_ASSERT_EQUAL_FLOAT(0, diff->elements[i]);
+    }
+
+    // square solvers and factorizations on a column-major operand
+    float s_els[3 * 3] = {
+        4, 1, 2,
+        1, 5, 1,
+        2, 1, 6,
+    };
+    lin_mat_t *s = lin_mat_create_from_array((lin_mat_shape_t){3, 3}, s_els);
+    lin_mat_t *n = lin_mat_create_from_array((lin_mat_shape_t){3, 3}, els);
+    lin_mat_t *nt = lin_mat_transpose(n);
+    lin_mat_transpose_in_place(nt);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, lin_mat_det(n), lin_mat_det(nt));
+    lin_mat_t *exp_inv = lin_mat_inv(n);
+    lin_mat_t *inv = lin_mat_inv(nt);
+    assert_within(1e-4, exp_inv->elements, inv->elements, 9);
+
+    lin_mat_t *b = lin_mat_create_from_array((lin_mat_shape_t){3, 1}, x_els);
+    lin_mat_t *exp_x = lin_mat_spd_solve(s, b);
+    lin_mat_t *l = lin_mat_create_from_array((lin_mat_shape_t){3, 3}, s_els);
+    TEST_ASSERT_TRUE(lin_mat_set_layout(l, LIN_COL_MAJOR));
+    TEST_ASSERT_EQUAL_FLOAT(2, lin_mat_get(l, 0, 2));
+    TEST_ASSERT_TRUE(lin_mat_cholesky(l));
+    TEST_ASSERT_EQUAL(LIN_ROW_MAJOR, l->layout);
+    lin_mat_transpose_in_place(l);
+    lin_mat_t *chol_x = lin_mat_trsm(l, b, LIN_TRI_UPPER | LIN_TRI_TRANS);
+    lin_mat_t *chol_xx = lin_mat_trsm(l, chol_x, LIN_TRI_UPPER);
+    assert_within(1e-5, exp_x->elements, chol_xx->elements, 3);
+    lin_mat_transpose_in_place(l);
+    TEST_ASSERT_TRUE(lin_mat_set_layout(l, LIN_COL_MAJOR));
+    lin_mat_t *sol = lin_mat_cholesky_solve(l, b);
+    assert_within(1e-5, exp_x->elements, sol->elements, 3);
+
+    lin_mat_t *st = lin_mat_create_from_array((lin_mat_shape_t){3, 3}, s_els);
+    TEST_ASSERT_TRUE(lin_mat_set_layout(st, LIN_COL_MAJOR));
+    lin_mat_lu_t *lu = lin_mat_lu(st);
+    lin_mat_t *lu_x = lin_mat_lu_solve(lu, b);
+    assert_within(1e-5, exp_x->elements, lu_x->elements, 3);
+
+    lin_vec_t *cg_b = lin_vec_create_from_array(3, x_els);
+    lin_vec_t *cg_x = lin_vec_create(3);
+    TEST_ASSERT_TRUE(lin_cg(lin_op_mat, st, cg_b, cg_x, NULL, NULL));
+    assert_within(1e-4, exp_x->elements, cg_x->elements, 3);
+
+    lin_mat_free(a);
+    lin_mat_free(at);
+    lin_mat_free(t);
+    lin_mat_free(exp_t);
+    lin_mat_free(exp_ata);
+    lin_mat_free(ata);
+    lin_mat_free(exp_aat);
+    lin_mat_free(aat);
+    lin_mat_free(ata_t);
+    lin_mat_free(syrk);
+    lin_vec_free(x);
+    lin_vec_free(exp_y);
+    lin_vec_free(y);
+    lin_mat_free(sum);
+    lin_mat_free(diff);
+    lin_mat_free(s);
+    lin_mat_free(n);
+    lin_mat_free(nt);
+    lin_mat_free(exp_inv);
+    lin_mat_free(inv);
+    lin_mat_free(b);
+    lin_mat_free(exp_x);
+    lin_mat_free(l);
+    lin_mat_free(chol_x);
+    lin_mat_free(chol_xx);
+    lin_mat_free(sol);
+    lin_mat_free(st);
+    lin_mat_lu_free(lu);
+    lin_mat_free(lu_x);
+    lin_vec_free(cg_b);
+    lin_vec_free(cg_x);
+}
+
+static float conv_ref(float const *in, float const *w, lin_conv2d_t const *conv,
+                      size_t f, size_t oy, size_t ox) {
+    size_t const s = conv->stride == 0 ? 1 : conv->stride;
+    float sum = 0;
+    for (size_t c = 0; c < conv->channels; c++) {
+        for (size_t ky = 0; ky < conv->kernel_height; ky++) {
+            for (size_t kx = 0; kx < conv->kernel_width; kx++) {
+                long const y = (long)(oy * s + ky) - (long)conv->padding;
+                long const x = (long)(ox * s + kx) - (long)conv->padding;
+                if (y < 0 || x < 0 || y >= (long)conv->height || x >= (long)conv->width) {
+                    continue;
+                }
+                size_t const wi = ((f * conv->channels + c) * conv->kernel_height + ky)
+                    * conv->kernel_width + kx;
+                sum += w[wi] * in[(c * conv->height + (size_t)y) * conv->width + (size_t)x];
+            }
+        }
+    }
+    return sum;
+}
+
+void conv2d(void) {
+    // single channel, 2x2 box filter without padding
+    float img_els[3 * 3] = {
+        1, 2, 3,
+        4, 5, 6,
+        7, 8, 9,
+    };
+    float box_els[4] = {1, 1, 1, 1};
+    lin_mat_t *img = lin_mat_create_from_array((lin_mat_shape_t){3, 3}, img_els);
+    lin_mat_t *box = lin_mat_create_from_array((lin_mat_shape_t){1, 4}, box_els);
+    lin_conv2d_t const box_conv = {1, 3, 3, 2, 2, 1, 0};
+    lin_mat_t *res = lin_mat_conv2d(img, box, &box_conv);
+    float exp[4] = {12, 16, 24, 28};
+    TEST_ASSERT_EQUAL_size_t(1, res->shape.rows);
+    TEST_ASSERT_EQUAL_size_t(4, res->shape.columns);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(exp, res->elements, 4);
+
+    // several channels and filters, both the direct 3x3 and the im2col paths
+    size_t const channels = 3;
+    size_t const h = 9;
+    size_t const w = 11;
+    lin_mat_t *in = lin_mat_create((lin_mat_shape_t){channels, h * w});
+    for (size_t i = 0; i < channels * h * w; i++) {
+        in->elements[i] = (float)((i * 13) % 7) - 3;
+    }
+    lin_conv2d_t const convs[4] = {
+        {channels, h, w, 3, 3, 1, 1},
+        {channels, h, w, 3, 3, 2, 0},
+        {channels, h, w, 2, 4, 1, 2},
+        {channels, h, w, 5, 5, 3, 1},
+    };
+    for (size_t t = 0; t < 4; t++) {
+        lin_conv2d_t const *conv = &convs[t];
+        size_t const k = channels * conv->kernel_height * conv->kernel_width;
+        lin_mat_t *filters = lin_mat_create((lin_mat_shape_t){2, k});
+        for (size_t i = 0; i < 2 * k; i++) {
+            filters->elements[i] = (float)((i * 5) % 9) * 0.25f - 1;
+        }
+
+        lin_mat_t *out = lin_mat_conv2d(in, filters, conv);
+        size_t const s = conv->stride == 0 ? 1 : conv->stride;
+        size_t const oh = (h + 2 * conv->padding - conv->kernel_height) / s + 1;
+        size_t const ow = (w + 2 * conv->padding - conv->kernel_width) / s + 1;
+        TEST_ASSERT_EQUAL_size_t(2, out->shape.rows);
+        TEST_ASSERT_EQUAL_size_t(oh * ow, out->shape.columns);
+        for (size_t f = 0; f < 2; f++) {
+            for (size_t oy = 0; oy < oh; oy++) {
+                for (size_t ox = 0; ox < ow; ox++) {
+                    TEST_ASSERT_FLOAT_WITHIN(
+                        1e-4,
+                        conv_ref(in->elements, filters->elements, conv, f, oy, ox),
+                        out->elements[f * oh * ow + oy * ow + ox]
+                    );
+                }
+            }
+        }
+
+        lin_mat_free(filters);
+        lin_mat_free(out);
+    }
+
+    lin_mat_free(img);
+    lin_mat_free(box);
+    lin_mat_free(res);
+    lin_mat_free(in);
+}
+
+void random_fill(void) {
+    lin_rng_t rng;
+    lin_rng_seed(&rng, 42);
+    for (size_t i = 0; i < 1000; i++) {
+        float const u = lin_rng_uniform(&rng);
+        TEST_ASSERT_TRUE(u >= 0 && u < 1);
+    }
+
+    // the same seed reproduces a bulk fill spanning many blocks
+    size_t const rows = 300;
+    size_t const cols = 200;
+    size_t const n = rows * cols;
+    lin_mat_t *a = lin_mat_create((lin_mat_shape_t){rows, cols});
+    lin_mat_t *b = lin_mat_create((lin_mat_shape_t){rows, cols});
+    lin_rng_seed(&rng, 7);
+    lin_mat_fill_uniform(a, &rng, -2, 3);
+    lin_rng_seed(&rng, 7);
+    lin_mat_fill_uniform(b, &rng, -2, 3);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(a->elements, b->elements, n);
+
+    double sum = 0;
+    double sum_sq = 0;
+    for (size_t i = 0; i < n; i++) {
+        float const x = a->elements[i];
+        TEST_ASSERT_TRUE(x >= -2 && x <= 3);
+        sum += x;
+        sum_sq += (double)x * x;
+    }
+    double mean = sum / (double)n;
+    TEST_ASSERT_FLOAT_WITHIN(0.02, 0.5, mean);
+    TEST_ASSERT_FLOAT_WITHIN(0.05, 25.0 / 12.0, sum_sq / (double)n - mean * mean);
+
+    // the generator moved on, so the next fill differs
+    lin_mat_fill_uniform(b, &rng, -2, 3);
+    size_t same = 0;
+    for (size_t i = 0; i < n; i++) {
+        same += a->elements[i] == b->elements[i];
+    }
+    TEST_ASSERT_TRUE(same < n / 100);
+
+    lin_mat_fill_normal(a, &rng, 1, 2);
+    sum = 0;
+    sum_sq = 0;
+    for (size_t i = 0; i < n; i++) {
+        sum += a->elements[i];
+        sum_sq += (double)a->elements[i] * a->elements[i];
+    }
+    mean = sum / (double)n;
+    TEST_ASSERT_FLOAT_WITHIN(0.03, 1, mean);
+    TEST_ASSERT_FLOAT_WITHIN(0.1, 4, sum_sq / (double)n - mean * mean);
+
+    // split streams are reproducible and distinct
+    lin_rng_t base;
+    lin_rng_t streams[2];
+    lin_rng_seed(&base, 99);
+    lin_rng_split(&base, &streams[0]);
+    lin_rng_split(&base, &streams[1]);
+    lin_vec_t *x = lin_vec_create(5);
+    lin_vec_t *y = lin_vec_create(5);
+    lin_vec_fill_normal(x, &streams[0], 0, 1);
+    lin_vec_fill_normal(y, &streams[1], 0, 1);
+    TEST_ASSERT_TRUE(x->elements[0] != y->elements[0]);
+    lin_rng_t again;
+    lin_rng_seed(&again, 99);
+    lin_vec_fill_normal(y, &again, 0, 1);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(x->elements, y->elements, 5);
+
+    lin_mat_free(a);
+    lin_mat_free(b);
+    lin_vec_free(x);
+    lin_vec_free(y);
+}
+
+void wrap(void) {
+    float els[2 * 3] = {
+        1, 2, 3,
+        4, 5, 6,
+    };
+    lin_mat_t *mat = lin_mat_wrap((lin_mat_shape_t){2, 3}, els, LIN_BORROW);
+    TEST_ASSERT_EQUAL_PTR(els, mat->elements);
+    lin_mat_t *t = lin_mat_transpose(mat);
+    float exp[3 * 2] = {
+        1, 4,
+        2, 5,
+        3, 6,
+    };
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(exp, t->elements, 6);
+
+    // writes through the matrix land in the caller's buffer
+    lin_mat_set(mat, 1, 2, 9);
+    TEST_ASSERT_EQUAL_FLOAT(9, els[5]);
+
+    // an adopted buffer shared by two holders, with the cache enabled
+    lin_decimal_t *buf = (lin_decimal_t *)malloc(4 * sizeof(lin_decimal_t));
+    buf[0] = 2;
+    buf[1] = 1;
+    buf[2] = 1;
+    buf[3] = 1;
+    lin_mat_t *owner = lin_mat_wrap((lin_mat_shape_t){2, 2}, buf, LIN_ADOPT);
+    lin_mat_cache_enable(owner);
+    lin_mat_t *shared = lin_mat_retain(owner);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 1, lin_mat_det(owner));
+    lin_mat_free(owner);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 1, lin_mat_cached_det(shared));
+    lin_mat_free(shared);
+
+    lin_mat_free(mat);
+    lin_mat_free(t);
+}
+
+void cache(void) {
+    float els[4 * 4] = {
+        4, 2, 0, 8,
+        6, 9, 1, 90,
+        5, 120, 9, 1,
+        0, 700, 2, 5,
+    };
+    lin_mat_t *mat = lin_mat_create_from_array((lin_mat_shape_t){4, 4}, els);
+    lin_mat_t *exp_inv = lin_mat_inv(mat);
+    lin_mat_t *exp_t = lin_mat_transpose(mat);
+
+    lin_mat_cache_enable(mat);
+    TEST_ASSERT_FLOAT_WITHIN(1, -1918318, lin_mat_det(mat));
+
+    lin_mat_t const *inv = lin_mat_cached_inv(mat);
+    TEST_ASSERT_EQUAL_PTR(inv, lin_mat_cached_inv(mat));
+    for (size_t i = 0; i < 16; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-5, exp_inv->elements[i], inv->elements[i]);
+    }
+
+    lin_mat_t *t = lin_mat_transpose(mat);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(exp_t->elements, t->elements, 16);
+    TEST_ASSERT_EQUAL_PTR(lin_mat_cached_transpose(mat),
+                          lin_mat_cached_transpose(mat));
+
+    // modifying the elements directly and touching invalidates the cache
+    mat->elements[0] = 5;
+    lin_mat_touch(mat);
+    float exp_t0[4] = {5, 6, 5, 0};
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(exp_t0, lin_mat_cached_transpose(mat)->elements, 4);
+
+    lin_mat_t *uncached = lin_mat_create_from_array(mat->shape, mat->elements);
+    TEST_ASSERT_FLOAT_WITHIN(1, lin_mat_det(uncached), lin_mat_det(mat));
+
+    lin_mat_cache_disable(mat);
+    TEST_ASSERT_NULL(mat->cache);
+}
+
+void pool(void) {
+    lin_pool_enable(1 << 20);
+
+    lin_mat_t *a = lin_mat_create((lin_mat_shape_t){3, 5});
+    lin_decimal_t *elements = a->elements;
+    lin_mat_free(a);
+    TEST_ASSERT_GREATER_THAN(0, lin_pool_bytes());
+
+    // same size class, so the buffer is handed back out
+    lin_mat_t *b = lin_mat_create((lin_mat_shape_t){4, 4});
+    TEST_ASSERT_EQUAL_PTR(elements, b->elements);
+    TEST_ASSERT_EQUAL(0, lin_pool_bytes());
+    lin_mat_free(b);
+
+    // buffers beyond the bound are freed instead of pooled
+    lin_mat_t *big = lin_mat_create((lin_mat_shape_t){1024, 1024});
+    lin_mat_free(big);
+    TEST_ASSERT_LESS_OR_EQUAL(1 << 20, lin_pool_bytes());
+
+    lin_pool_disable();
+    TEST_ASSERT_EQUAL(0, lin_pool_bytes());
+}
+
+void save_load(void) {
+    float els[2 * 3] = {
+        1, 2, 3,
+        4, 5, 6,
+    };
+    lin_mat_t *mat = lin_mat_create_from_array((lin_mat_shape_t){2, 3}, els);
+
+    TEST_ASSERT_TRUE(lin_mat_save(mat, "test_save_load.linm"));
+    lin_mat_t *res = lin_mat_load("test_save_load.linm");
+    remove("test_save_load.linm");
+
+    TEST_ASSERT_NOT_NULL(res);
+    TEST_ASSERT_EQUAL(2, res->shape.rows);
+    TEST_ASSERT_EQUAL(3, res->shape.columns);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(els, res->elements, 6);
+
+    TEST_ASSERT_NULL(lin_mat_load("test_does_not_exist.linm"));
+}
+
+void load_invalid(void) {
+    float els[2 * 3] = {
+        1, 2, 3,
+        4, 5, 6,
+    };
+    lin_mat_t *mat = lin_mat_create_from_array((lin_mat_shape_t){2, 3}, els);
+    TEST_ASSERT_TRUE(lin_mat_save(mat, "test_load_invalid.linm"));
+    lin_mat_free(mat);
+
+    // drop the last element
+    FILE *file = fopen("test_load_invalid.linm", "r+b");
+    TEST_ASSERT_NOT_NULL(file);
+    TEST_ASSERT_EQUAL(0, ftruncate(fileno(file),
+                                   LIN_FILE_HEADER_SIZE + (5 * sizeof(float))));
+    fclose(file);
+    TEST_ASSERT_NULL(lin_mat_load("test_load_invalid.linm"));
+
+    // a header claiming far more elements than could ever be allocated
+    file = fopen("test_load_invalid.linm", "wb");
+    TEST_ASSERT_NOT_NULL(file);
+    uint32_t const el_size = sizeof(float);
+    uint64_t const dims[2] = {((uint64_t)1 << 62) - 2, 1};
+    fwrite("LINM", 1, 4, file);
+    fwrite(&el_size, sizeof(el_size), 1, file);
+    fwrite(dims, sizeof(dims[0]), 2, file);
+    fwrite(els, sizeof(float), 6, file);
+    fclose(file);
+    TEST_ASSERT_NULL(lin_mat_load("test_load_invalid.linm"));
+    remove("test_load_invalid.linm");
+
+    TEST_ASSERT_NULL(lin_mat_create((lin_mat_shape_t){SIZE_MAX / 2, 4}));
+    TEST_ASSERT_NULL(lin_tri_create(SIZE_MAX, false));
+    TEST_ASSERT_NULL(lin_band_create(SIZE_MAX / 2, 1, 2));
+}
+
+void mult_file(void) {
+    // tiles that do not divide any of the dimensions
+    size_t const m = 37, k = 29, n = 41;
+    lin_mat_t *a = lin_mat_create((lin_mat_shape_t){m, k});
+    for (size_t i = 0; i < m * k; i++) {
+        a->elements[i] = (float)(i % 13) - 6.0f;
+    }
+    lin_mat_t *b = lin_mat_create((lin_mat_shape_t){k, n});
+    for (size_t i = 0; i < k * n; i++) {
+        b->elements[i] = (float)(i % 5) - 2.0f;
+    }
+
+    TEST_ASSERT_TRUE(lin_mat_save(a, "test_mult_file_a.linm"));
+    TEST_ASSERT_TRUE(lin_mat_save(b, "test_mult_file_b.linm"));
+    TEST_ASSERT_TRUE(lin_mat_mult_file("test_mult_file_a.linm",
+                                       "test_mult_file_b.linm",
+                                       "test_mult_file_c.linm", 8));
+    lin_mat_t *res = lin_mat_load("test_mult_file_c.linm");
+    remove("test_mult_file_a.linm");
+    remove("test_mult_file_b.linm");
+    remove("test_mult_file_c.linm");
+
+    // writing over an input would destroy it before it is read
+    lin_mat_t *square = lin_mat_create((lin_mat_shape_t){k, k});
+    for (size_t i = 0; i < k * k; i++) {
+        square->elements[i] = (float)i;
+    }
+    TEST_ASSERT_TRUE(lin_mat_save(square, "test_mult_file_a.linm"));
+    TEST_ASSERT_FALSE(lin_mat_mult_file("test_mult_file_a.linm",
+                                        "test_mult_file_a.linm",
+                                        "test_mult_file_a.linm", 8));
+    lin_mat_t *kept = lin_mat_load("test_mult_file_a.linm");
+    remove("test_mult_file_a.linm");
+    TEST_ASSERT_NOT_NULL(kept);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(square->elements, kept->elements, k * k);
+    lin_mat_free(square);
+    lin_mat_free(kept);
+
+    lin_mat_t *exp = lin_mat_mult(a, b);
+    TEST_ASSERT_EQUAL(m, res->shape.rows);
+    TEST_ASSERT_EQUAL(n, res->shape.columns);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(exp->elements, res->elements, m * n);
+}
+
+void small_kernels(void) {
+    // sizes 2..8 covered by the unrolled kernels and 9 on the generic path,
+    // checked against straightforward loops
+    for (size_t n = 2; n <= 9; n++) {
+        lin_mat_t *a = lin_mat_create((lin_mat_shape_t){n, n});
+        lin_mat_t *b = lin_mat_create((lin_mat_shape_t){n, n});
+        lin_mat_t *x = lin_mat_create((lin_mat_shape_t){n, 1});
+        for (size_t i = 0; i < n * n; i++) {
+            a->elements[i] = (float)((i * 7) % 11) - 5;
+            b->elements[i] = (float)((i * 5) % 13) - 6;
+        }
+        for (size_t i = 0; i < n; i++) {
+            // diagonally dominant so `a` is well conditioned
+            a->elements[(i * n) + i] += 4 * (float)n;
+            x->elements[i] = (float)i - 2;
+        }
+
+        lin_mat_t *ab = lin_mat_mult(a, b);
+        lin_mat_t *ax = lin_mat_mult(a, x);
+        lin_mat_t *sum = lin_mat_add(a, b);
+        lin_mat_t *t = lin_mat_transpose(a);
+        for (size_t i = 0; i < n; i++) {
+            float ax_exp = 0;
+            for (size_t j = 0; j < n; j++) {
+                float ab_exp = 0;
+                for (size_t p = 0; p < n; p++) {
+                    ab_exp += a->elements[(i * n) + p] * b->elements[(p * n) + j];
+                }
+                ax_exp += a->elements[(i * n) + j] * x->elements[j];
+
+                TEST_ASSERT_FLOAT_WITHIN(1e-3, ab_exp, ab->elements[(i * n) + j]);
+                TEST_ASSERT_EQUAL_FLOAT(a->elements[(i * n) + j] + b->elements[(i * n) + j],
+                                        sum->elements[(i * n) + j]);
+                TEST_ASSERT_EQUAL_FLOAT(a->elements[(i * n) + j],
+                                        t->elements[(j * n) + i]);
+            }
+            TEST_ASSERT_FLOAT_WITHIN(1e-3, ax_exp, ax->elements[i]);
+        }
+
+        lin_mat_t *inv = lin_mat_inv(a);
+        lin_mat_t *id = lin_mat_mult(a, inv);
+        for (size_t i = 0; i < n; i++) {
+            for (size_t j = 0; j < n; j++) {
+                TEST_ASSERT_FLOAT_WITHIN(1e-4, i == j ? 1 : 0, id->elements[(i * n) + j]);
+            }
+        }
+
+        lin_mat_free(a);
+        lin_mat_free(b);
+        lin_mat_free(x);
+        lin_mat_free(ab);
+        lin_mat_free(ax);
+        lin_mat_free(sum);
+        lin_mat_free(t);
+        lin_mat_free(inv);
+        lin_mat_free(id);
+    }
+}
+
+void text_io(void) {
+    FILE *text = tmpfile();
+    fputs("# exported matrix\n"
+          "1, -2.5, 3e2\n"
+          "\n"
+          "0.1;4   1E-3 # trailing comment\n"
+          "-0, 7.000, +6\n", text);
+    rewind(text);
+
+    lin_mat_t *mat = lin_mat_read_text(text);
+    float exp[3 * 3] = {
+        1, -2.5f, 300,
+        0.1f, 4, 0.001f,
+        0, 7, 6,
+    };
+    TEST_ASSERT_NOT_NULL(mat);
+    TEST_ASSERT_EQUAL(3, mat->shape.rows);
+    TEST_ASSERT_EQUAL(3, mat->shape.columns);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(exp, mat->elements, 9);
+    fclose(text);
+
+    // written values read back exactly
+    float els[2 * 3] = {
+        0.1f, 1.0f / 3.0f, -1234567.0f,
+        3.4e38f, 1e-40f, 16777216.0f,
+    };
+    lin_mat_t *orig = lin_mat_create_from_array((lin_mat_shape_t){2, 3}, els);
+    text = tmpfile();
+    TEST_ASSERT_TRUE(lin_mat_write_text(orig, text, ','));
+    rewind(text);
+    char line[64];
+    TEST_ASSERT_NOT_NULL(fgets(line, sizeof(line), text));
+    TEST_ASSERT_EQUAL_STRING("0.1,0.33333334,-1234567\n", line);
+    rewind(text);
+    lin_mat_t *res = lin_mat_read_text(text);
+    TEST_ASSERT_NOT_NULL(res);
+    TEST_ASSERT_EQUAL(2, res->shape.rows);
+    TEST_ASSERT_EQUAL(3, res->shape.columns);
+    TEST_ASSERT_EQUAL_MEMORY(els, res->elements, sizeof(els));
+    fclose(text);
+
+    // numbers longer than a formatted value, and hexadecimal ones, go to the
+    // C library, also when they straddle the reader's buffer
+    char const *long_value =
+        "0.1000000000000000000000000000000000000000000000000000000000000000001";
+    text = tmpfile();
+    int const first = fprintf(text, "%s 0x1p3\n", long_value);
+    // the reader only guarantees 64 bytes of look-ahead, so the second long
+    // value starts exactly that far before the end of the first buffer
+    for (size_t i = (size_t)first; i < LIN_TEXT_BUFFER - 64; i++) {
+        fputc(' ', text);
+    }
+    fprintf(text, "%s -0x1.8p1\n", long_value);
+    rewind(text);
+    lin_mat_t *wide = lin_mat_read_text(text);
+    TEST_ASSERT_NOT_NULL(wide);
+    TEST_ASSERT_EQUAL(2, wide->shape.rows);
+    TEST_ASSERT_EQUAL(2, wide->shape.columns);
+    float const wide_exp[2 * 2] = {0.1f, 8, 0.1f, -3};
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(wide_exp, wide->elements, 4);
+    lin_mat_free(wide);
+    fclose(text);
+
+    // ragged rows, garbage and empty input are rejected
+    char const *invalid[] = {"1 2\n3\n", "1 2x\n", "# nothing\n"};
+    for (size_t i = 0; i < 3; i++) {
+        text = tmpfile();
+        fputs(invalid[i], text);
+        rewind(text);
+        TEST_ASSERT_NULL(lin_mat_read_text(text));
+        fclose(text);
+    }
+
+    lin_mat_free(mat);
+    lin_mat_free(orig);
+    lin_mat_free(res);
+}
+
+void text_file_convert(void) {
+    // enough rows to span several text buffers
+    size_t const m = 3000, n = 7;
+    lin_mat_t *mat = lin_mat_create((lin_mat_shape_t){m, n});
+    for (size_t i = 0; i < m * n; i++) {
+        mat->elements[i] = ((float)i * 0.37f) - 1000;
+    }
+
+    FILE *text = tmpfile();
+    TEST_ASSERT_TRUE(lin_mat_write_text(mat, text, ' '));
+    rewind(text);
+    TEST_ASSERT_TRUE(lin_mat_text_to_file(text, "test_text_convert.linm"));
+    fclose(text);
+
+    lin_mat_t *res = lin_mat_load("test_text_convert.linm");
+    TEST_ASSERT_NOT_NULL(res);
+    TEST_ASSERT_EQUAL(m, res->shape.rows);
+    TEST_ASSERT_EQUAL(n, res->shape.columns);
+    TEST_ASSERT_EQUAL_MEMORY(mat->elements, res->elements, m * n * sizeof(float));
+
+    text = tmpfile();
+    TEST_ASSERT_TRUE(lin_mat_file_to_text("test_text_convert.linm", text, ','));
+    remove("test_text_convert.linm");
+    rewind(text);
+    lin_mat_t *back = lin_mat_read_text(text);
+    fclose(text);
+    TEST_ASSERT_NOT_NULL(back);
+    TEST_ASSERT_EQUAL_MEMORY(mat->elements, back->elements, m * n * sizeof(float));
+
+    lin_mat_free(mat);
+    lin_mat_free(res);
+    lin_mat_free(back);
+}
+
+static void *scaled_identity(void *arg) {
+    return lin_mat_scalar_mult(lin_mat_identity(3), *(float *)arg);
+}
+
+void jobs(void) {
+    lin_set_num_threads(4);
+    float a_els[3 * 3] = {
+        4, 1, 0,
+        1, 3, 1,
+        0, 1, 2,
+    };
+    float b_els[3 * 2] = {
+        1, 2,
+        0, 1,
+        3, 0,
+    };
+    lin_mat_t *a = lin_mat_create_from_array((lin_mat_shape_t){3, 3}, a_els);
+    lin_mat_t *b = lin_mat_create_from_array((lin_mat_shape_t){3, 2}, b_els);
+
+    // (a * b) + (a^-1 * (2I * b)) as a DAG, with the independent branches
+    // free to run concurrently
+    float two = 2;
+    lin_job_t *ab = lin_job_mat_mult(LIN_JOB_MAT(a), LIN_JOB_MAT(b));
+    lin_job_t *inv = lin_job_mat_inv(LIN_JOB_MAT(a));
+    lin_job_t *scale = lin_job_submit(scaled_identity, &two, NULL, 0);
+    lin_job_t *sb = lin_job_mat_mult(LIN_JOB_RESULT(scale), LIN_JOB_MAT(b));
+    lin_job_t *isb = lin_job_mat_mult(LIN_JOB_RESULT(inv), LIN_JOB_RESULT(sb));
+    lin_job_t *sum = lin_job_mat_add(LIN_JOB_RESULT(ab), LIN_JOB_RESULT(isb));
+    lin_job_t *x = lin_job_mat_solve(LIN_JOB_MAT(a), LIN_JOB_RESULT(sb));
+
+    lin_mat_t *res = lin_job_wait(sum);
+    TEST_ASSERT_TRUE(lin_job_poll(sum));
+    lin_mat_t *exp = lin_mat_add(
+        lin_mat_mult(a, b),
+        lin_mat_mult(lin_mat_inv(a), lin_mat_scalar_mult(b, 2))
+    );
+    TEST_ASSERT_NOT_NULL(res);
+    for (size_t i = 0; i < 6; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-5, exp->elements[i], res->elements[i]);
+    }
+
+    // a * x = 2b
+    lin_mat_t *ax = lin_mat_mult(a, lin_job_wait(x));
+    for (size_t i = 0; i < 6; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-5, 2 * b_els[i], ax->elements[i]);
+    }
+
+    // a singular operand makes the job and everything depending on it NULL
+    lin_mat_t *singular = lin_mat_create_from_array(
+        (lin_mat_shape_t){2, 2}, (float[]){1, 2, 2, 4}
+    );
+    lin_job_t *bad = lin_job_mat_inv(LIN_JOB_MAT(singular));
+    lin_job_t *after = lin_job_mat_transpose(LIN_JOB_RESULT(bad));
+    TEST_ASSERT_NULL(lin_job_wait(after));
+    TEST_ASSERT_NULL(lin_job_wait(bad));
+
+    lin_job_t *jobs[] = {ab, inv, scale, sb, isb, sum, x, bad, after};
+    for (size_t i = 0; i < sizeof(jobs) / sizeof(jobs[0]); i++) {
+        lin_mat_free(lin_job_wait(jobs[i]));
+        lin_job_free(jobs[i]);
+    }
+    lin_job_shutdown();
+
+    // results nobody can wait for any more are freed with their jobs, here
+    // into the pool
+    lin_pool_enable(1 << 20);
+    lin_job_t *t = lin_job_mat_transpose(LIN_JOB_MAT(a));
+    lin_job_t *tt = lin_job_mat_transpose(LIN_JOB_RESULT(t));
+    lin_job_free(t);
+    lin_job_free(tt);
+    lin_job_shutdown();
+    TEST_ASSERT_GREATER_THAN(0, lin_pool_bytes());
+    lin_pool_disable();
+    lin_set_num_threads(0);
+
+    lin_mat_free(a);
+    lin_mat_free(b);
+    lin_mat_free(singular);
+    lin_mat_free(exp);
+    lin_mat_free(ax);
+}
+
+static void *inv_job(void *arg) {
+    return lin_mat_inv((lin_mat_t const *)arg);
+}
+
+void jobs_cached(void) {
+    lin_set_num_threads(4);
+    // large enough that the fills overlap
+    size_t const n = 96;
+    lin_mat_t *a = lin_mat_create((lin_mat_shape_t){n, n});
+    for (size_t i = 0; i < n * n; i++) {
+        a->elements[i] = i % (n + 1) == 0 ? (float)n : (float)(i % 7) / 7.0f;
+    }
+    lin_mat_cache_enable(a);
+
+    // concurrent jobs filling the cache of a shared operand
+    lin_job_t *jobs[16];
+    for (size_t i = 0; i < 16; i += 2) {
+        jobs[i] = lin_job_mat_transpose(LIN_JOB_MAT(a));
+        jobs[i + 1] = lin_job_submit(inv_job, a, NULL, 0);
+    }
+
+    for (size_t i = 0; i < 16; i += 2) {
+        lin_mat_t *t = lin_job_wait(jobs[i]);
+        lin_mat_t *inv = lin_job_wait(jobs[i + 1]);
+        TEST_ASSERT_NOT_NULL(t);
+        TEST_ASSERT_NOT_NULL(inv);
+        for (size_t r = 0; r < n; r++) {
+            for (size_t c = 0; c < n; c++) {
+                TEST_ASSERT_EQUAL_FLOAT(a->elements[(c * n) + r],
+                                        t->elements[(r * n) + c]);
+            }
+        }
+        lin_mat_t *id = lin_mat_mult(a, inv);
+        for (size_t j = 0; j < n * n; j++) {
+            TEST_ASSERT_FLOAT_WITHIN(1e-4, j % (n + 1) == 0 ? 1 : 0,
+                                     id->elements[j]);
+        }
+        lin_mat_free(id);
+        lin_mat_free(t);
+        lin_mat_free(inv);
+        lin_job_free(jobs[i]);
+        lin_job_free(jobs[i + 1]);
+    }
+    lin_job_shutdown();
+    lin_set_num_threads(0);
+
+    lin_mat_free(a);
+}
+
 int main(void) {
     UNITY_BEGIN();
     RUN_TEST(create);
     RUN_TEST(create_from_array);
     RUN_TEST(mult);
+    RUN_TEST(vec_mult);
+    RUN_TEST(vec_mult_large);
     RUN_TEST(add);
     RUN_TEST(sub);
     RUN_TEST(scalar_mult);
+    RUN_TEST(elementwise_large);
     RUN_TEST(transpose);
     RUN_TEST(det1x1);
     RUN_TEST(det2x2);
@@ -488,5 +2142,35 @@ int main(void) {
     RUN_TEST(adj);
     RUN_TEST(inv);
     RUN_TEST(map);
+    RUN_TEST(mat_pow);
+    RUN_TEST(qr);
+    RUN_TEST(qr_blocked);
+    RUN_TEST(lstsq);
+    RUN_TEST(cholesky);
+    RUN_TEST(cholesky_blocked);
+    RUN_TEST(spd_solve);
+    RUN_TEST(lu);
+    RUN_TEST(inv_rank1_update);
+    RUN_TEST(cholesky_update);
+    RUN_TEST(lu_update);
+    RUN_TEST(triangular);
+    RUN_TEST(symmetric);
+    RUN_TEST(banded);
+    RUN_TEST(iterative);
+    RUN_TEST(eigen);
+    RUN_TEST(layout);
+    RUN_TEST(conv2d);
+    RUN_TEST(random_fill);
+    RUN_TEST(wrap);
+    RUN_TEST(cache);
+    RUN_TEST(pool);
+    RUN_TEST(save_load);
+    RUN_TEST(load_invalid);
+    RUN_TEST(mult_file);
+    RUN_TEST(small_kernels);
+    RUN_TEST(text_io);
+    RUN_TEST(text_file_convert);
+    RUN_TEST(jobs);
+    RUN_TEST(jobs_cached);
     return UNITY_END();
 }
@@ -0,0 +1,113 @@
+#define LIN_TRACE
+#include "unity.h"
+#include "unity_internals.h"
+#include "lin.h"
+
+void setUp(void) {
+    // set stuff up here
+}
+
+void tearDown(void) {
+    lin_set_trace_callback(NULL, NULL);
+}
+
+typedef struct {
+    lin_trace_event_t events[64];
+    size_t count;
+} recorded_t;
+
+static void record(lin_trace_event_t const *event, void *user) {
+    recorded_t *rec = (recorded_t *)user;
+    if (rec->count < 64) {
+        rec->events[rec->count++] = *event;
+    }
+}
+
+void callback(void) {
+    lin_mat_t *a = lin_mat_create((lin_mat_shape_t){2, 3});
+    lin_mat_t *b = lin_mat_create((lin_mat_shape_t){3, 3});
+
+    recorded_t rec = {0};
+    lin_set_trace_callback(record, &rec);
+    lin_mat_t *c = lin_mat_mult(a, b);
+    lin_set_trace_callback(NULL, NULL);
+
+    // lin_mat_mult, with the lin_mat_create of its result nested inside
+    TEST_ASSERT_EQUAL(4, rec.count);
+    TEST_ASSERT_EQUAL_STRING("lin_mat_mult", rec.events[0].op);
+    TEST_ASSERT_EQUAL(LIN_TRACE_BEGIN, rec.events[0].phase);
+    TEST_ASSERT_EQUAL(2, rec.events[0].a_rows);
+    TEST_ASSERT_EQUAL(3, rec.events[0].a_columns);
+    TEST_ASSERT_EQUAL(3, rec.events[0].b_rows);
+    TEST_ASSERT_EQUAL(3, rec.events[0].b_columns);
+    TEST_ASSERT_EQUAL_STRING("lin_mat_create", rec.events[1].op);
+    TEST_ASSERT_EQUAL(LIN_TRACE_BEGIN, rec.events[1].phase);
+    TEST_ASSERT_EQUAL_STRING("lin_mat_create", rec.events[2].op);
+    TEST_ASSERT_EQUAL(LIN_TRACE_END, rec.events[2].phase);
+    TEST_ASSERT_EQUAL_STRING("lin_mat_mult", rec.events[3].op);
+    TEST_ASSERT_EQUAL(LIN_TRACE_END, rec.events[3].phase);
+
+    // nothing is reported once the callback is removed
+    lin_mat_free(c);
+    TEST_ASSERT_EQUAL(4, rec.count);
+
+    lin_mat_free(a);
+    lin_mat_free(b);
+}
+
+static void *vec_ops(void *arg) {
+    (void)arg;
+    for (size_t i = 0; i < 100; i++) {
+        lin_vec_t *v = lin_vec_create(3);
+        lin_vec_free(v);
+    }
+    return NULL;
+}
+
+static size_t count(char const *text, char const *needle) {
+    size_t n = 0;
+    for (char const *p = strstr(text, needle); p != NULL; p = strstr(p + 1, needle)) {
+        n++;
+    }
+    return n;
+}
+
+void json(void) {
+    TEST_ASSERT_TRUE(lin_trace_start_json("test_trace.json"));
+
+    lin_mat_t *a = lin_mat_identity(3);
+    lin_mat_t *inv = lin_mat_inv(a);
+    pthread_t thread;
+    pthread_create(&thread, NULL, vec_ops, NULL);
+    pthread_join(thread, NULL);
+    lin_mat_free(inv);
+    lin_mat_free(a);
+
+    TEST_ASSERT_TRUE(lin_trace_stop_json());
+
+    FILE *file = fopen("test_trace.json", "rb");
+    TEST_ASSERT_NOT_NULL(file);
+    static char text[1 << 16];
+    size_t const len = fread(text, 1, sizeof(text) - 1, file);
+    text[len] = '\0';
+    fclose(file);
+    remove("test_trace.json");
+
+    TEST_ASSERT_EQUAL('[', text[0]);
+    TEST_ASSERT_NOT_NULL(strstr(text, "\"name\":\"lin_mat_inv\",\"ph\":\"B\""));
+    TEST_ASSERT_NOT_NULL(strstr(text, "\"a\":\"3x3\""));
+    TEST_ASSERT_EQUAL(200, count(text, "\"name\":\"lin_vec_create\""));
+    TEST_ASSERT_EQUAL(count(text, "\"ph\":\"B\""), count(text, "\"ph\":\"E\""));
+#ifndef LIN_NO_THREADS
+    // the other thread's events are on their own track
+    TEST_ASSERT_NOT_NULL(strstr(text, "\"tid\":2"));
+#endif
+    TEST_ASSERT_NOT_NULL(strstr(text, "\n]\n"));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(callback);
+    RUN_TEST(json);
+    return UNITY_END();
+}
@@ -14,6 +14,10 @@ void create(void) {
     lin_vec_t *vec = lin_vec_create(3);
     TEST_ASSERT_NOT_NULL(vec);
     TEST_ASSERT_NOT_NULL(vec->elements);
+    lin_vec_free(vec);
+
+    // the allocation size would wrap around
+    TEST_ASSERT_NULL(lin_vec_create(SIZE_MAX / 2));
 }
 
 void create_from_array(void) {
@@ -122,6 +126,45 @@ void map(void){
     TEST_ASSERT_EQUAL_FLOAT_ARRAY(exp, res->elements, 3);
 }
 
+void pool(void) {
+    lin_pool_enable(1 << 10);
+
+    lin_vec_t *a = lin_vec_create(3);
+    lin_decimal_t *elements = a->elements;
+    lin_vec_free(a);
+
+    lin_vec_t *b = lin_vec_create(4);
+    TEST_ASSERT_EQUAL_PTR(elements, b->elements);
+    lin_vec_free(b);
+
+    lin_pool_disable();
+    TEST_ASSERT_EQUAL(0, lin_pool_bytes());
+}
+
+void wrap(void) {
+    // borrowed: no copy, and the buffer outlives the vector
+    float els[3] = {1, 2, 3};
+    lin_vec_t *vec = lin_vec_wrap(3, els, LIN_BORROW);
+    TEST_ASSERT_EQUAL_PTR(els, vec->elements);
+    TEST_ASSERT_EQUAL_FLOAT(14, lin_vec_dot(vec, vec));
+    els[0] = 4;
+    TEST_ASSERT_EQUAL_FLOAT(29, lin_vec_dot(vec, vec));
+    lin_vec_free(vec);
+    TEST_ASSERT_EQUAL_FLOAT(4, els[0]);
+
+    // adopted and shared: released with the last reference
+    lin_decimal_t *buf = (lin_decimal_t *)malloc(3 * sizeof(lin_decimal_t));
+    buf[0] = 2;
+    buf[1] = 0;
+    buf[2] = 0;
+    lin_vec_t *owner = lin_vec_wrap(3, buf, LIN_ADOPT);
+    lin_vec_t *shared = lin_vec_retain(owner);
+    TEST_ASSERT_EQUAL_PTR(owner, shared);
+    lin_vec_free(owner);
+    TEST_ASSERT_EQUAL_FLOAT(2, lin_vec_len(shared));
+    lin_vec_free(shared);
+}
+
 int main(void) {
     UNITY_BEGIN();
     RUN_TEST(create);
@@ -135,5 +178,7 @@ int main(void) {
     RUN_TEST(angle_rad);
     RUN_TEST(cross);
     RUN_TEST(map);
+    RUN_TEST(pool);
+    RUN_TEST(wrap);
     return UNITY_END();
 }
@@ -0,0 +1,229 @@
+#include "unity.h"
+#include "unity_internals.h"
+#include "lin.h"
+
+void setUp(void) {
+    // set stuff up here
+}
+
+void tearDown(void) {
+    // clean stuff up here
+}
+
+void create(void) {
+    lin_vec3_array_t *arr = lin_vec3_array_create(4);
+    TEST_ASSERT_NOT_NULL(arr);
+    TEST_ASSERT_NOT_NULL(arr->x);
+    TEST_ASSERT_NOT_NULL(arr->y);
+    TEST_ASSERT_NOT_NULL(arr->z);
+    TEST_ASSERT_EQUAL(4, arr->len);
+    lin_vec3_array_free(arr);
+
+    // the allocation size would wrap around
+    TEST_ASSERT_NULL(lin_vec3_array_create(SIZE_MAX / 3 + 1));
+}
+
+void xyz(void) {
+    float els[2 * 3] = {
+        1, 2, 3,
+        4, 5, 6,
+    };
+    lin_vec3_array_t *arr = lin_vec3_array_create_from_xyz(2, els);
+
+    float exp_x[2] = {1, 4};
+    float exp_y[2] = {2, 5};
+    float exp_z[2] = {3, 6};
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(exp_x, arr->x, 2);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(exp_y, arr->y, 2);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(exp_z, arr->z, 2);
+
+    float res[2 * 3];
+    lin_vec3_array_to_xyz(arr, res);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(els, res, 6);
+    lin_vec3_array_free(arr);
+}
+
+void dot(void) {
+    float els1[2 * 3] = {
+        1, 2, 3,
+        1, 0, 0,
+    };
+    float els2[2 * 3] = {
+        4, 5, 6,
+        0, 1, 0,
+    };
+    lin_vec3_array_t *a = lin_vec3_array_create_from_xyz(2, els1);
+    lin_vec3_array_t *b = lin_vec3_array_create_from_xyz(2, els2);
+
+    lin_vec_t *res = lin_vec3_array_dot(a, b);
+
+    float exp[2] = {32, 0};
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(exp, res->elements, 2);
+}
+
+void cross(void) {
+    float els1[2 * 3] = {
+        1, 2, 3,
+        1, 0, 0,
+    };
+    float els2[2 * 3] = {
+        3, 4, 5,
+        0, 1, 0,
+    };
+    lin_vec3_array_t *a = lin_vec3_array_create_from_xyz(2, els1);
+    lin_vec3_array_t *b = lin_vec3_array_create_from_xyz(2, els2);
+
+    lin_vec3_array_t *res = lin_vec3_array_cross(a, b);
+
+    float exp[2 * 3] = {
+        -2, 4, -2,
+        0, 0, 1,
+    };
+    float out[2 * 3];
+    lin_vec3_array_to_xyz(res, out);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(exp, out, 6);
+}
+
+void len(void) {
+    float els[2 * 3] = {
+        3, 4, 12,
+        0, 0, 0,
+    };
+    lin_vec3_array_t *arr = lin_vec3_array_create_from_xyz(2, els);
+
+    float exp[2] = {13, 0};
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(exp, lin_vec3_array_len(arr)->elements, 2);
+}
+
+void normalize(void) {
+    float els[2 * 3] = {
+        3, 4, 12,
+        0, 0, 0,
+    };
+    lin_vec3_array_t *arr = lin_vec3_array_create_from_xyz(2, els);
+
+    lin_vec3_array_t *res = lin_vec3_array_normalize(arr);
+
+    float exp[2 * 3] = {
+        3.0f / 13, 4.0f / 13, 12.0f / 13,
+        0, 0, 0,
+    };
+    float out[2 * 3];
+    lin_vec3_array_to_xyz(res, out);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(exp, out, 6);
+}
+
+void add(void) {
+    float els1[2 * 3] = {
+        1, 2, 3,
+        4, 5, 6,
+    };
+    float els2[2 * 3] = {
+        6, 5, 4,
+        3, 2, 1,
+    };
+    lin_vec3_array_t *a = lin_vec3_array_create_from_xyz(2, els1);
+    lin_vec3_array_t *b = lin_vec3_array_create_from_xyz(2, els2);
+
+    float exp[2 * 3] = {
+        7, 7, 7,
+        7, 7, 7,
+    };
+    float out[2 * 3];
+    lin_vec3_array_to_xyz(lin_vec3_array_add(a, b), out);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(exp, out, 6);
+}
+
+void scalar_mult(void) {
+    float els[2 * 3] = {
+        1, 2, 3,
+        4, 5, 6,
+    };
+    lin_vec3_array_t *arr = lin_vec3_array_create_from_xyz(2, els);
+
+    float exp[2 * 3] = {
+        2, 4, 6,
+        8, 10, 12,
+    };
+    float out[2 * 3];
+    lin_vec3_array_to_xyz(lin_vec3_array_scalar_mult(arr, 2), out);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(exp, out, 6);
+}
+
+void transform(void) {
+    // scale by 2 and translate by (1, 2, 3)
+    float affine_els[4 * 4] = {
+        2, 0, 0, 1,
+        0, 2, 0, 2,
+        0, 0, 2, 3,
+        0, 0, 0, 1,
+    };
+    // perspective divide by z
+    float proj_els[4 * 4] = {
+        1, 0, 0, 0,
+        0, 1, 0, 0,
+        0, 0, 1, 0,
+        0, 0, 1, 0,
+    };
+    lin_mat_t *affine = lin_mat_create_from_array((lin_mat_shape_t){4, 4}, affine_els);
+    lin_mat_t *proj = lin_mat_create_from_array((lin_mat_shape_t){4, 4}, proj_els);
+
+    float els[2 * 3] = {
+        1, 2, 3,
+        4, 6, 2,
+    };
+    float out[2 * 3];
+    float exp_affine[2 * 3] = {
+        3, 6, 9,
+        9, 14, 7,
+    };
+    lin_mat_transform_points(affine, els, out, 2);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(exp_affine, out, 6);
+
+    float exp_proj[2 * 3] = {
+        1.0f / 3, 2.0f / 3, 1,
+        2, 3, 1,
+    };
+    lin_mat_transform_points(proj, els, out, 2);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(exp_proj, out, 6);
+
+    // the [3 x 4] top of an affine matrix, transforming in place
+    lin_mat_t *top = lin_mat_create_from_array((lin_mat_shape_t){3, 4}, affine_els);
+    memcpy(out, els, sizeof(els));
+    lin_mat_transform_points(top, out, out, 2);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(exp_affine, out, 6);
+
+    // structure of arrays, also with a column-major matrix
+    lin_vec3_array_t *arr = lin_vec3_array_create_from_xyz(2, els);
+    lin_vec3_array_t *res = lin_vec3_array_create(2);
+    lin_mat_transform_vec3_array(affine, arr, res);
+    lin_vec3_array_to_xyz(res, out);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(exp_affine, out, 6);
+
+    lin_mat_t *proj_t = lin_mat_transpose(proj);
+    lin_mat_transpose_in_place(proj_t);
+    lin_mat_transform_vec3_array(proj_t, arr, arr);
+    lin_vec3_array_to_xyz(arr, out);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(exp_proj, out, 6);
+
+    lin_mat_free(affine);
+    lin_mat_free(proj);
+    lin_mat_free(top);
+    lin_mat_free(proj_t);
+    lin_vec3_array_free(arr);
+    lin_vec3_array_free(res);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(create);
+    RUN_TEST(xyz);
+    RUN_TEST(dot);
+    RUN_TEST(cross);
+    RUN_TEST(len);
+    RUN_TEST(normalize);
+    RUN_TEST(add);
+    RUN_TEST(scalar_mult);
+    RUN_TEST(transform);
+    return UNITY_END();
+}